@@ -0,0 +1,270 @@
+#include "AppOptions.h"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+std::string require_value(int argc, char** argv, int& i) {
+    if (i + 1 >= argc) {
+        throw std::invalid_argument(std::string("missing value for ") + argv[i]);
+    }
+    return argv[++i];
+}
+
+uint64_t parse_u64(const std::string& flag, const std::string& value) {
+    try {
+        size_t consumed = 0;
+        unsigned long long v = std::stoull(value, &consumed);
+        if (consumed != value.size()) throw std::invalid_argument(value);
+        return v;
+    } catch (const std::exception&) {
+        throw std::invalid_argument("invalid number for " + flag + ": " + value);
+    }
+}
+
+// "[HOST:]PORT"; `host` keeps its value when the host is left out
+void parse_endpoint(const std::string& flag, const std::string& value, std::string& host, uint16_t& port) {
+    const size_t colon = value.rfind(':');
+    if (colon != std::string::npos) host = value.substr(0, colon);
+    const uint64_t p = parse_u64(flag, colon == std::string::npos ? value : value.substr(colon + 1));
+    if (p == 0 || p > 65535) throw std::invalid_argument(flag + " needs a port in 1..65535");
+    port = static_cast<uint16_t>(p);
+}
+
+std::vector<std::string> split_symbols(const std::string& list) {
+    std::vector<std::string> symbols;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        if (comma > start) symbols.push_back(list.substr(start, comma - start));
+        start = comma + 1;
+    }
+    if (symbols.empty()) throw std::invalid_argument("--symbols needs at least one symbol");
+    return symbols;
+}
+
+} // namespace
+
+AppOptions parse_options(int argc, char** argv) {
+    AppOptions opts;
+    bool have_input = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--symbols") {
+            opts.tracked_symbols = split_symbols(require_value(argc, argv, i));
+        } else if (arg == "--trades-out") {
+            opts.trades_path = require_value(argc, argv, i);
+        } else if (arg == "--headless") {
+            opts.headless = true;
+        } else if (arg == "--no-prefilter") {
+            opts.prefilter = false;
+        } else if (arg == "--conflate") {
+            opts.conflate = true;
+        } else if (arg == "--snapshot-out") {
+            opts.snapshot_path = require_value(argc, argv, i);
+        } else if (arg == "--snapshot-interval-ms") {
+            opts.snapshot_interval_ms = parse_u64(arg, require_value(argc, argv, i));
+            if (opts.snapshot_interval_ms == 0)
+                throw std::invalid_argument("--snapshot-interval-ms must be > 0");
+        } else if (arg == "--snapshot-depth") {
+            opts.snapshot_depth = static_cast<uint32_t>(parse_u64(arg, require_value(argc, argv, i)));
+            if (opts.snapshot_depth == 0)
+                throw std::invalid_argument("--snapshot-depth must be > 0");
+        } else if (arg == "--stats-out") {
+            opts.stats_path = require_value(argc, argv, i);
+        } else if (arg == "--stats-interval-ms") {
+            opts.stats_interval_ms = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--tape-dir") {
+            opts.tape_dir = require_value(argc, argv, i);
+        } else if (arg == "--lifecycle-out") {
+            opts.lifecycle_path = require_value(argc, argv, i);
+        } else if (arg == "--flight-recorder") {
+            opts.flight_recorder_size = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--flight-dump") {
+            opts.flight_dump_path = require_value(argc, argv, i);
+        } else if (arg == "--check-invariants") {
+            opts.check_invariants = true;
+        } else if (arg == "--http-port") {
+            uint64_t port = parse_u64(arg, require_value(argc, argv, i));
+            if (port == 0 || port > 65535)
+                throw std::invalid_argument("--http-port must be in 1..65535");
+            opts.http_port = static_cast<uint16_t>(port);
+        } else if (arg == "--http-bind") {
+            opts.http_bind = require_value(argc, argv, i);
+        } else if (arg == "--shm") {
+            opts.shm_name = require_value(argc, argv, i);
+            if (opts.shm_name.empty() || opts.shm_name[0] != '/')
+                throw std::invalid_argument("--shm name must start with '/'");
+        } else if (arg == "--shm-depth") {
+            opts.shm_depth = static_cast<uint32_t>(parse_u64(arg, require_value(argc, argv, i)));
+            if (opts.shm_depth == 0 || opts.shm_depth > 10)
+                throw std::invalid_argument("--shm-depth must be in 1..10");
+        } else if (arg == "--engine-threads") {
+            opts.engine_threads = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--book-lookahead") {
+            opts.book_lookahead = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--inflate-threads") {
+            opts.inflate_threads = parse_u64(arg, require_value(argc, argv, i));
+            if (opts.inflate_threads == 0)
+                throw std::invalid_argument("--inflate-threads must be at least 1");
+        } else if (arg == "--merge") {
+            opts.merge = true;
+        } else if (arg == "--mold-listen") {
+            parse_endpoint(arg, require_value(argc, argv, i), opts.mold_bind, opts.mold_port);
+        } else if (arg == "--mold-group") {
+            opts.mold_group = require_value(argc, argv, i);
+        } else if (arg == "--mold-request") {
+            parse_endpoint(arg, require_value(argc, argv, i), opts.mold_request_host, opts.mold_request_port);
+            if (opts.mold_request_host.empty())
+                throw std::invalid_argument("--mold-request needs HOST:PORT");
+        } else if (arg == "--mold-idle-ms") {
+            opts.mold_idle_ms = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--mold-publish") {
+            parse_endpoint(arg, require_value(argc, argv, i), opts.mold_publish_host, opts.mold_publish_port);
+            if (opts.mold_publish_host.empty())
+                throw std::invalid_argument("--mold-publish needs HOST:PORT");
+        } else if (arg == "--mold-rate") {
+            opts.mold_rate = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--mold-drop-every") {
+            opts.mold_drop_every = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--mold-serve") {
+            std::string unused;
+            parse_endpoint(arg, require_value(argc, argv, i), unused, opts.mold_serve_port);
+        } else if (arg == "--build-cache") {
+            opts.build_cache_path = require_value(argc, argv, i);
+        } else if (arg == "--backtest") {
+            opts.backtest_variants = parse_u64(arg, require_value(argc, argv, i));
+            if (opts.backtest_variants == 0)
+                throw std::invalid_argument("--backtest must be > 0");
+        } else if (arg == "--backtest-threads") {
+            opts.backtest_threads = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--quote-size") {
+            opts.backtest_quote_size = static_cast<int32_t>(parse_u64(arg, require_value(argc, argv, i)));
+            if (opts.backtest_quote_size <= 0)
+                throw std::invalid_argument("--quote-size must be > 0");
+        } else if (arg == "--batch") {
+            opts.batch = true;
+        } else if (arg == "--out-dir") {
+            opts.output_dir = require_value(argc, argv, i);
+        } else if (arg == "--jobs") {
+            opts.batch_workers = parse_u64(arg, require_value(argc, argv, i));
+        } else if (arg == "--shards") {
+            opts.batch_shards = parse_u64(arg, require_value(argc, argv, i));
+            if (opts.batch_shards == 0)
+                throw std::invalid_argument("--shards must be > 0");
+        } else if (arg.rfind("--", 0) != 0) {
+            // positionals are collected for batch mode; a single one is the replay input
+            opts.batch_inputs.push_back(arg);
+            if (!have_input) opts.input_path = arg;
+            have_input = true;
+        } else {
+            throw std::invalid_argument("unknown option: " + arg);
+        }
+    }
+
+    if (opts.batch && !opts.build_cache_path.empty())
+        throw std::invalid_argument("--build-cache cannot be combined with --batch");
+    if (opts.backtest_variants && (opts.batch || !opts.build_cache_path.empty()))
+        throw std::invalid_argument("--backtest cannot be combined with --batch or --build-cache");
+    if (opts.merge && opts.batch)
+        throw std::invalid_argument("--merge cannot be combined with --batch");
+    // every concurrent job would listen on the same port
+    if (opts.batch && opts.http_port)
+        throw std::invalid_argument("--http-port cannot be combined with --batch");
+    // jobs would unlink and recreate each other's segment under the same name
+    if (opts.batch && !opts.shm_name.empty())
+        throw std::invalid_argument("--shm cannot be combined with --batch");
+    if (opts.engine_threads) {
+        // engines run off the replay thread, so nothing on it may read a book mid-run
+        if (!opts.headless || opts.batch || opts.backtest_variants || !opts.build_cache_path.empty())
+            throw std::invalid_argument("--engine-threads needs --headless and a plain replay");
+        if (!opts.snapshot_path.empty() || opts.http_port || !opts.shm_name.empty())
+            throw std::invalid_argument("--engine-threads cannot be combined with --snapshot-out, --http-port or --shm");
+    }
+
+    if (opts.mold_port) {
+        // the feed replaces the input file; modes that read a file end to end do not apply
+        if (opts.merge || opts.batch || opts.backtest_variants || !opts.build_cache_path.empty() ||
+            opts.mold_publish_port)
+            throw std::invalid_argument("--mold-listen cannot be combined with --merge, --batch, --backtest, "
+                                        "--build-cache or --mold-publish");
+        if (have_input)
+            throw std::invalid_argument("--mold-listen takes no input file");
+    }
+    // options that only mean something to one side of the feed
+    if (!opts.mold_port && (!opts.mold_group.empty() || opts.mold_request_port || opts.mold_idle_ms))
+        throw std::invalid_argument("--mold-group, --mold-request and --mold-idle-ms need --mold-listen");
+    if (!opts.mold_publish_port && (opts.mold_rate || opts.mold_drop_every || opts.mold_serve_port))
+        throw std::invalid_argument("--mold-rate, --mold-drop-every and --mold-serve need --mold-publish");
+    if (opts.mold_publish_port && (opts.merge || opts.batch || opts.backtest_variants || !opts.build_cache_path.empty()))
+        throw std::invalid_argument("--mold-publish takes a single input file and no other mode");
+
+    if (opts.batch) {
+        if (opts.batch_inputs.empty())
+            throw std::invalid_argument("--batch needs at least one input file or pattern");
+        if (opts.output_dir.empty())
+            throw std::invalid_argument("--batch needs --out-dir");
+        opts.headless = true;
+    } else if (opts.merge) {
+        if (opts.batch_inputs.empty())
+            throw std::invalid_argument("--merge needs at least one input file");
+    } else if (!opts.build_cache_path.empty() && opts.batch_inputs.size() > 1) {
+        throw std::invalid_argument("--build-cache takes a single input file (or use --merge)");
+    } else if (opts.batch_inputs.size() > 1) {
+        throw std::invalid_argument("more than one input file given (use --batch or --merge)");
+    }
+
+    return opts;
+}
+
+void print_usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [options] [ITCH_FILE | ITCH_FILE.gz | CACHE]\n"
+              << "       " << argv0 << " --build-cache CACHE [--symbols A,B,C] ITCH_FILE\n"
+              << "       " << argv0 << " --merge [options] ITCH_FILE...\n"
+              << "       " << argv0 << " --mold-listen [ADDR:]PORT [options]\n"
+              << "       " << argv0 << " --mold-publish HOST:PORT [--mold-rate N] ITCH_FILE\n"
+              << "       " << argv0 << " --batch --out-dir DIR [options] FILE|GLOB...\n"
+              << "  --symbols A,B,C             symbols to track (default: 20 large caps)\n"
+              << "  --trades-out PATH           trade CSV path (default trades.csv)\n"
+              << "  --headless                  no dashboard, print a throughput summary\n"
+              << "  --no-prefilter              decode every message instead of skipping untracked ones in bulk\n"
+              << "  --conflate                  one trade event per sweep and per top-of-book change, not per fill\n"
+              << "  --snapshot-out PATH         write top-N book snapshots to PATH\n"
+              << "  --snapshot-interval-ms N    exchange-time sampling interval (default 100)\n"
+              << "  --snapshot-depth N          levels per side in each snapshot (default 5)\n"
+              << "  --stats-out PATH            periodic per-book counters (.json for JSON, else text)\n"
+              << "  --stats-interval-ms N       wall-clock interval between stats dumps (default 1000)\n"
+              << "  --tape-dir DIR              write every fill to a time-indexed tape per symbol in DIR\n"
+              << "  --lifecycle-out PATH        per-symbol order lifecycle histograms (JSON) at end of run\n"
+              << "  --flight-recorder N         entries kept per engine, 0 disables (default 1024)\n"
+              << "  --flight-dump PATH          where SIGUSR1 / invariant failures dump (default flight_recorder.log)\n"
+              << "  --check-invariants          check top of book after every command\n"
+              << "  --http-port N               serve a live book dashboard on http://127.0.0.1:N/\n"
+              << "  --http-bind ADDR            dashboard listen address (default 127.0.0.1)\n"
+              << "  --shm NAME                  publish top-N books to POSIX shared memory NAME (e.g. /itch_books)\n"
+              << "  --shm-depth N               levels per side in shared memory (default 5, max 10)\n"
+              << "  --engine-threads N          apply commands on N worker threads with runtime symbol rebalancing\n"
+              << "  --book-lookahead N          books built ahead on background threads, 0 = inline (default 4)\n"
+              << "  --inflate-threads N         inflate members of a multi-member gzip input on N threads\n"
+              << "  --merge                     replay all inputs as one stream in exchange-timestamp order\n"
+              << "  --mold-listen [ADDR:]PORT   replay a live MoldUDP64 feed instead of a file\n"
+              << "  --mold-group ADDR           multicast group to join for --mold-listen\n"
+              << "  --mold-request HOST:PORT    retransmission server asked to fill sequence gaps\n"
+              << "  --mold-idle-ms N            end a live replay after N ms without packets (default: wait for end of session)\n"
+              << "  --mold-publish HOST:PORT    send the input file as MoldUDP64 and exit\n"
+              << "  --mold-rate N               publish at N messages per second (default unpaced)\n"
+              << "  --mold-drop-every N         publish: skip every Nth packet to exercise gap recovery\n"
+              << "  --mold-serve PORT           publish: answer retransmission requests on PORT\n"
+              << "  --build-cache PATH          decode the tracked symbols once into a command cache\n"
+              << "  --backtest K                run K variants of the reference quoting strategy in parallel\n"
+              << "  --backtest-threads N        backtest threads (default: hardware threads)\n"
+              << "  --quote-size N              shares per virtual quote (default 100)\n"
+              << "  --batch                     replay many files on a work-stealing worker pool\n"
+              << "  --out-dir DIR               batch output root, one subdirectory per job\n"
+              << "  --jobs N                    batch workers (default: hardware threads)\n"
+              << "  --shards K                  split the tracked symbols of each day into K jobs\n";
+}
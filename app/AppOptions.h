@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Command line configuration for OrderBookApp. Every option has a default so
+// running the binary with no arguments keeps the original behaviour.
+struct AppOptions {
+    // Raw or gzip-compressed ITCH 5.0 file, or a command cache written by
+    // --build-cache (all detected from the file contents, not the name)
+    std::string input_path = "../../12302019.NASDAQ_ITCH50";
+    std::string trades_path = "trades.csv";
+
+    std::vector<std::string> tracked_symbols = {
+        "AAPL", "MSFT", "AMZN", "GOOGL", "META", "NVDA", "TSLA", "ORCL", "INTC", "AMD",
+        "JPM", "BAC", "GS", "MS", "WMT", "COST", "TGT", "NFLX", "DIS", "NKE"};
+
+    // No terminal dashboard; prints a throughput summary instead
+    bool headless = false;
+
+    // One trade event per taker sweep and a book update per top-of-book
+    // change, instead of one trade event (and redraw) per resting order filled
+    bool conflate = false;
+
+    // Skip messages of untracked locates in bulk before decoding (see
+    // ItchPrefilter); --no-prefilter frames every message individually
+    bool prefilter = true;
+
+    // Book snapshot export (disabled when the path is empty)
+    std::string snapshot_path;
+    uint64_t snapshot_interval_ms = 100;
+    uint32_t snapshot_depth = 5;
+
+    // Per-book stats file (disabled when the path is empty); ".json" selects JSON
+    std::string stats_path;
+    uint64_t stats_interval_ms = 1000;
+
+    // Per-symbol trade tapes with a time index, one <SYMBOL>.tape per tracked
+    // symbol in this directory (disabled when empty); see TradeTapeReader
+    std::string tape_dir;
+
+    // End-of-run order lifecycle report (disabled when the path is empty):
+    // lifetimes, time to first fill, fill and cancel ratios per symbol
+    std::string lifecycle_path;
+
+    // Per-engine flight recorder (0 disables); dumped on SIGUSR1 and on
+    // invariant failures
+    size_t flight_recorder_size = 1024;
+    std::string flight_dump_path = "flight_recorder.log";
+    bool check_invariants = false;
+
+    // Browser dashboard on 127.0.0.1:http_port (0 disables)
+    uint16_t http_port = 0;
+    std::string http_bind = "127.0.0.1";
+
+    // Top-N books published to POSIX shared memory under this name, e.g.
+    // "/itch_books" (disabled when empty); see SharedBookReader
+    std::string shm_name;
+    uint32_t shm_depth = 5;
+
+    // Apply commands on this many engine worker threads, with symbols
+    // rebalanced between them at runtime (see EngineScheduler); 0 applies
+    // them on the replay thread. Headless replays only.
+    size_t engine_threads = 0;
+
+    // Books built ahead of need on background threads (see BookBuilder), so
+    // a directory message for a tracked symbol does not stall the replay on
+    // ladder construction; 0 builds each book inline
+    size_t book_lookahead = 4;
+
+    // Pool threads inflating the members of a multi-member gzip input in
+    // parallel (see GzipProducer); 1 inflates on the reader thread only
+    size_t inflate_threads = 1;
+
+    // Replay every positional input as one stream, merged in exchange
+    // timestamp order (see ItchMerge); the inputs must share a locate space
+    bool merge = false;
+
+    // Live MoldUDP64 input on [mold_bind:]mold_port instead of a file (see
+    // MoldUdpReceiver); 0 disables. Gaps are requested again from
+    // mold_request_host:mold_request_port when that port is set.
+    std::string mold_bind = "0.0.0.0";
+    uint16_t mold_port = 0;
+    std::string mold_group;             // multicast group to join
+    std::string mold_request_host;
+    uint16_t mold_request_port = 0;
+    uint64_t mold_idle_ms = 0;          // end the replay after this long without packets; 0 waits for end of session
+
+    // Publish the input as MoldUDP64 to mold_publish_host:mold_publish_port
+    // and exit, for loopback testing of the live input (see MoldUdpPublisher)
+    std::string mold_publish_host;
+    uint16_t mold_publish_port = 0;
+    uint64_t mold_rate = 0;             // messages per second, 0 unpaced
+    uint64_t mold_drop_every = 0;       // skip every Nth packet to exercise gap recovery
+    uint16_t mold_serve_port = 0;       // answer retransmission requests on this port
+
+    // Decode the input once into a command cache at this path and exit
+    std::string build_cache_path;
+
+    // Backtest mode: replay the input once per variant of the reference
+    // strategy (variant k quotes k ticks behind the touch), in parallel
+    size_t backtest_variants = 0;
+    size_t backtest_threads = 0;    // 0 = one per hardware thread
+    int32_t backtest_quote_size = 100;
+
+    // Batch mode: every positional argument is a file or glob pattern, each
+    // file (or file x symbol shard) becomes one job writing under output_dir.
+    // batch_inputs also holds the inputs of a --merge replay.
+    bool batch = false;
+    std::vector<std::string> batch_inputs;
+    std::string output_dir;
+    size_t batch_workers = 0;   // 0 = one per hardware thread
+    size_t batch_shards = 1;
+};
+
+// Throws std::invalid_argument on unknown flags or malformed values.
+AppOptions parse_options(int argc, char **argv);
+
+void print_usage(const char *argv0);
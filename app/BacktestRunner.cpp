@@ -0,0 +1,58 @@
+#include "BacktestRunner.h"
+#include "BacktestHarness.h"
+#include "BlockSource.h"
+#include "CommandCache.h"
+#include "ItchMerge.h"
+#include "JoinBestStrategy.h"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+std::vector<BacktestResult> run_backtest(const AppOptions &opts)
+{
+    std::unordered_set<std::string> tracked(opts.tracked_symbols.begin(), opts.tracked_symbols.end());
+
+    // a cache is replayed straight from its mapping; raw ITCH is decoded once
+    std::optional<CommandCacheReader> cache;
+    DecodedCommands decoded;
+    std::span<const EngineCommand> commands;
+    std::vector<std::pair<uint16_t, std::string>> symbols;
+
+    if (!opts.merge && command_cache::is_cache_file(opts.input_path))
+    {
+        cache.emplace(opts.input_path);
+        commands = cache->commands();
+        for (const auto &entry : cache->symbols())
+        {
+            if (tracked.count(entry.second))
+                symbols.push_back(entry);
+        }
+    }
+    else
+    {
+        auto source = opts.merge ? open_merged_source(opts.batch_inputs)
+                                 : open_block_source(opts.input_path, PipelinedSource::DEFAULT_BLOCK_SIZE,
+                                                     PipelinedSource::DEFAULT_RING_BLOCKS, opts.inflate_threads);
+        decoded = decode_commands(*source, tracked);
+        commands = decoded.commands;
+        symbols = decoded.symbols;
+    }
+
+    BacktestConfig config;
+    config.threads = opts.backtest_threads;
+
+    const int32_t quote_size = opts.backtest_quote_size;
+    return run_backtests(commands, symbols, opts.backtest_variants,
+                         [quote_size](size_t variant)
+                         {
+                             JoinBestStrategy::Params params;
+                             params.quote_size = quote_size;
+                             params.offset_ticks = static_cast<int32_t>(variant);
+                             return std::make_unique<JoinBestStrategy>(params);
+                         },
+                         config);
+}
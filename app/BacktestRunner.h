@@ -0,0 +1,10 @@
+#pragma once
+
+#include "AppOptions.h"
+#include "BacktestSession.h"
+
+#include <vector>
+
+// --backtest: decodes the input once (or maps it, for a command cache) and
+// runs opts.backtest_variants copies of JoinBestStrategy over it in parallel.
+std::vector<BacktestResult> run_backtest(const AppOptions &opts);
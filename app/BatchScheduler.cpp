@@ -0,0 +1,279 @@
+#include "BatchScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <glob.h>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char *DONE_MARKER = "DONE";
+
+// Per-worker job queue: the owner takes from the front (largest jobs first),
+// thieves take from the back (the smallest remaining ones)
+class JobDeque
+{
+public:
+    void push(size_t job)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(job);
+    }
+
+    bool pop(size_t &job)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jobs_.empty()) return false;
+        job = jobs_.front();
+        jobs_.pop_front();
+        return true;
+    }
+
+    bool steal(size_t &job)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jobs_.empty()) return false;
+        job = jobs_.back();
+        jobs_.pop_back();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<size_t> jobs_;
+};
+
+bool read_done_marker(const fs::path &marker, ReplaySummary &summary)
+{
+    std::ifstream in(marker);
+    return static_cast<bool>(in >> summary.messages >> summary.bytes >> summary.seconds >> summary.tracked_symbols);
+}
+
+void write_done_marker(const fs::path &marker, const ReplaySummary &summary)
+{
+    fs::path tmp = marker;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << summary.messages << " " << summary.bytes << " " << summary.seconds << " "
+            << summary.tracked_symbols << "\n";
+    }
+    fs::rename(tmp, marker);
+}
+
+} // namespace
+
+const char *to_string(BatchJobResult::Status status)
+{
+    switch (status)
+    {
+    case BatchJobResult::Status::Done: return "done";
+    case BatchJobResult::Status::Skipped: return "skipped";
+    case BatchJobResult::Status::Failed: return "failed";
+    }
+    return "?";
+}
+
+BatchScheduler::BatchScheduler(const AppOptions &opts)
+    : opts_(opts)
+{
+}
+
+std::vector<std::string> BatchScheduler::expand_inputs(const std::vector<std::string> &patterns)
+{
+    std::vector<std::string> files;
+    for (const auto &pattern : patterns)
+    {
+        glob_t matches{};
+        int rc = glob(pattern.c_str(), 0, nullptr, &matches);
+        if (rc == 0)
+        {
+            for (size_t i = 0; i < matches.gl_pathc; ++i)
+                files.emplace_back(matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+
+        if (rc == GLOB_NOMATCH)
+            throw std::invalid_argument("no input matches " + pattern);
+        if (rc != 0)
+            throw std::runtime_error("glob failed for " + pattern);
+    }
+
+    // the same file named twice (or matched by two patterns) is one job
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+size_t BatchScheduler::shard_of(const std::string &symbol, size_t shard_count)
+{
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : symbol)
+    {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash % shard_count;
+}
+
+std::vector<BatchJob> BatchScheduler::plan() const
+{
+    std::vector<BatchJob> jobs;
+    const size_t shards = opts_.batch_shards;
+
+    for (const auto &path : expand_inputs(opts_.batch_inputs))
+    {
+        uint64_t bytes = fs::file_size(path);
+        std::string stem = fs::path(path).filename().string();
+
+        for (size_t shard = 0; shard < shards; ++shard)
+        {
+            BatchJob job;
+            job.input_path = path;
+            job.input_bytes = bytes;
+            job.name = shards == 1 ? stem
+                                   : stem + ".shard" + std::to_string(shard) + "of" + std::to_string(shards);
+
+            for (const auto &symbol : opts_.tracked_symbols)
+            {
+                if (shard_of(symbol, shards) == shard)
+                    job.symbols.push_back(symbol);
+            }
+            if (!job.symbols.empty())
+                jobs.push_back(std::move(job));
+        }
+    }
+
+    // longest jobs first: the tail of the schedule is then made of short jobs
+    std::stable_sort(jobs.begin(), jobs.end(),
+                     [](const BatchJob &a, const BatchJob &b) { return a.input_bytes > b.input_bytes; });
+    return jobs;
+}
+
+BatchJobResult BatchScheduler::run_job(const BatchJob &job, size_t worker) const
+{
+    BatchJobResult result;
+    result.job = job;
+    result.worker = worker;
+
+    const fs::path dir = fs::path(opts_.output_dir) / job.name;
+    const fs::path marker = dir / DONE_MARKER;
+
+    if (read_done_marker(marker, result.summary))
+    {
+        result.status = BatchJobResult::Status::Skipped;
+        return result;
+    }
+
+    try
+    {
+        fs::create_directories(dir);
+
+        // same configuration as a single replay, with every output redirected into the job directory
+        AppOptions job_opts = opts_;
+        job_opts.input_path = job.input_path;
+        job_opts.tracked_symbols = job.symbols;
+        job_opts.trades_path = (dir / "trades.csv").string();
+        job_opts.flight_dump_path = (dir / "flight_recorder.log").string();
+        if (!opts_.stats_path.empty())
+            job_opts.stats_path = (dir / fs::path(opts_.stats_path).filename()).string();
+        if (!opts_.lifecycle_path.empty())
+            job_opts.lifecycle_path = (dir / fs::path(opts_.lifecycle_path).filename()).string();
+        if (!opts_.snapshot_path.empty())
+            job_opts.snapshot_path = (dir / fs::path(opts_.snapshot_path).filename()).string();
+        if (!opts_.tape_dir.empty())
+            job_opts.tape_dir = (dir / "tapes").string();
+
+        ReplaySession session(job_opts, nullptr);
+        result.summary = session.run();
+
+        write_done_marker(marker, result.summary);
+        result.status = BatchJobResult::Status::Done;
+    }
+    catch (const std::exception &e)
+    {
+        result.status = BatchJobResult::Status::Failed;
+        result.error = e.what();
+        std::replace(result.error.begin(), result.error.end(), ',', ';'); // keep the report one field per column
+    }
+
+    return result;
+}
+
+std::vector<BatchJobResult> BatchScheduler::run()
+{
+    const std::vector<BatchJob> jobs = plan();
+    std::vector<BatchJobResult> results(jobs.size());
+
+    size_t workers = opts_.batch_workers ? opts_.batch_workers : std::thread::hardware_concurrency();
+    workers = std::max<size_t>(1, std::min(workers, jobs.size()));
+
+    std::vector<JobDeque> queues(workers);
+    for (size_t i = 0; i < jobs.size(); ++i)
+        queues[i % workers].push(i);
+
+    std::mutex log_mutex;
+    std::atomic<size_t> finished{0};
+
+    auto worker_loop = [&](size_t self)
+    {
+        size_t job;
+        while (true)
+        {
+            bool found = queues[self].pop(job);
+            for (size_t k = 1; !found && k < workers; ++k)
+                found = queues[(self + k) % workers].steal(job);
+            if (!found)
+                return; // jobs never spawn jobs, so empty everywhere means done
+
+            results[job] = run_job(jobs[job], self);
+
+            const auto &r = results[job];
+            std::lock_guard<std::mutex> lock(log_mutex);
+            std::cerr << "[" << ++finished << "/" << jobs.size() << "] " << r.job.name << ": " << to_string(r.status);
+            if (r.status == BatchJobResult::Status::Failed)
+                std::cerr << " (" << r.error << ")";
+            else
+                std::cerr << " " << r.summary.messages << " msgs in " << r.summary.seconds << " s";
+            std::cerr << std::endl;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers; ++w)
+        threads.emplace_back(worker_loop, w);
+    for (auto &t : threads)
+        t.join();
+
+    write_report(results);
+    return results;
+}
+
+void BatchScheduler::write_report(const std::vector<BatchJobResult> &results) const
+{
+    fs::create_directories(opts_.output_dir);
+    std::ofstream out(fs::path(opts_.output_dir) / "batch_summary.csv", std::ios::trunc);
+
+    out << "job,input,status,worker,symbols,messages,bytes,seconds,msgs_per_sec,mb_per_sec,error\n";
+    for (const auto &r : results)
+    {
+        double secs = r.summary.seconds;
+        double msgs_per_sec = secs > 0 ? r.summary.messages / secs : 0.0;
+        double mb_per_sec = secs > 0 ? r.summary.bytes / secs / (1024.0 * 1024.0) : 0.0;
+
+        out << r.job.name << "," << r.job.input_path << "," << to_string(r.status) << "," << r.worker << ","
+            << r.summary.tracked_symbols << "," << r.summary.messages << "," << r.summary.bytes << ","
+            << std::fixed << std::setprecision(3) << secs << "," << std::setprecision(0) << msgs_per_sec << ","
+            << std::setprecision(1) << mb_per_sec << "," << r.error << "\n";
+        out.unsetf(std::ios::floatfield);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "AppOptions.h"
+#include "ReplaySession.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BatchJob {
+    std::string input_path;
+    std::string name;                   // output subdirectory under output_dir
+    std::vector<std::string> symbols;   // this job's share of the tracked symbols
+    uint64_t input_bytes = 0;
+};
+
+struct BatchJobResult {
+    enum class Status { Done, Skipped, Failed };
+
+    BatchJob job;
+    Status status = Status::Failed;
+    ReplaySummary summary;
+    size_t worker = 0;
+    std::string error;
+};
+
+// Replays many ITCH files (optionally split into symbol shards) on a pool of
+// worker threads. Jobs are dealt out largest-first, one deque per worker;
+// a worker that runs dry steals from the back of another worker's deque, so
+// a few long days at the end do not leave the other cores idle.
+//
+// Every job writes into its own directory and drops a DONE marker holding
+// its summary once it finishes, so re-running the same batch skips finished
+// jobs. A CSV report of per-job throughput is written to the output root.
+class BatchScheduler
+{
+public:
+    explicit BatchScheduler(const AppOptions &opts);
+
+    // Expands globs, splits into shards and orders jobs by input size
+    std::vector<BatchJob> plan() const;
+
+    std::vector<BatchJobResult> run();
+
+    static std::vector<std::string> expand_inputs(const std::vector<std::string> &patterns);
+
+    // Stable across runs (FNV-1a), so shard membership survives a resume
+    static size_t shard_of(const std::string &symbol, size_t shard_count);
+
+private:
+    BatchJobResult run_job(const BatchJob &job, size_t worker) const;
+    void write_report(const std::vector<BatchJobResult> &results) const;
+
+    const AppOptions &opts_;
+};
+
+const char *to_string(BatchJobResult::Status status);
@@ -0,0 +1,497 @@
+#include "ReplaySession.h"
+#include "BlockSource.h"
+#include "CommandCache.h"
+#include "ItchFramer.h"
+#include "ItchMerge.h"
+#include "ItchPrefilter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <ctime>
+#include <filesystem>
+#include <span>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// Bumped from the SIGUSR1 handler; each session compares against the last
+// generation it dumped, so one signal reaches every session in the process
+std::atomic<uint32_t> flight_dump_generation{0};
+
+void request_flight_dump(int)
+{
+    flight_dump_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t realtime_ns()
+{
+    timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+std::unique_ptr<MoldUdpReceiver> open_live_feed(const AppOptions &opts)
+{
+    MoldUdpReceiverConfig config;
+    config.bind_address = opts.mold_bind;
+    config.port = opts.mold_port;
+    config.group = opts.mold_group;
+    config.request_address = opts.mold_request_host;
+    config.request_port = opts.mold_request_port;
+    config.idle_timeout_ms = opts.mold_idle_ms;
+    return std::make_unique<MoldUdpReceiver>(config);
+}
+
+// Never more books than tracked symbols, and at most half the machine on
+// building them; lifecycle stats are switched on by the builder so their
+// side table is written off the replay thread too
+std::unique_ptr<BookBuilder> make_book_builder(const AppOptions &opts)
+{
+    BookBuilderConfig config;
+    config.min_price = 0;
+    config.max_price = 10000;
+    config.limit = opts.tracked_symbols.size();
+    config.ahead = std::min(opts.book_lookahead, config.limit);
+    config.threads = std::max<size_t>(1, std::min<size_t>(config.ahead, std::thread::hardware_concurrency() / 2));
+
+    BookBuilder::Prepare prepare;
+    if (!opts.lifecycle_path.empty())
+        prepare = [](LimitOrderBook &book) { book.enable_lifecycle_stats(); };
+    return std::make_unique<BookBuilder>(config, std::move(prepare));
+}
+
+} // namespace
+
+void ReplaySession::install_signal_handlers()
+{
+    std::signal(SIGUSR1, request_flight_dump);
+}
+
+ReplaySession::ReplaySession(const AppOptions &opts, TerminalDashboard *dashboard)
+    : opts_(opts),
+      dashboard_(dashboard),
+      trade_file_(opts.trades_path),
+      book_builder_(make_book_builder(opts)),
+      dispatcher_(std::unordered_set<std::string>(opts.tracked_symbols.begin(), opts.tracked_symbols.end()),
+                  [this](uint16_t locate, const std::string &symbol) { return create_engine(locate, symbol); })
+{
+    trade_file_ << "seq,symbol,taker,maker,price,quantity" << std::endl;
+
+    // optional top-N snapshot export, sampled on the ITCH timestamp grid
+    if (!opts_.snapshot_path.empty())
+    {
+        const uint64_t interval_ns = opts_.snapshot_interval_ms * 1'000'000ULL;
+        snapshot_writer_ = std::make_unique<SnapshotWriter>(opts_.snapshot_path, opts_.snapshot_depth, interval_ns);
+        snapshot_sampler_ = std::make_unique<SnapshotSampler>(*snapshot_writer_, interval_ns);
+    }
+
+    if (!opts_.stats_path.empty())
+        stats_reporter_ = std::make_unique<StatsReporter>(opts_.stats_path, std::chrono::milliseconds(opts_.stats_interval_ms));
+
+    if (!opts_.lifecycle_path.empty())
+        lifecycle_report_ = std::make_unique<LifecycleReport>();
+
+    if (!opts_.tape_dir.empty())
+        std::filesystem::create_directories(opts_.tape_dir);
+
+    if (opts_.http_port != 0)
+    {
+        market_state_ = std::make_unique<MarketStateStore>(BookSnapshot::MAX_DEPTH);
+        dashboard_server_ = std::make_unique<DashboardServer>(*market_state_, opts_.http_port,
+                                                              std::chrono::milliseconds(50), opts_.http_bind);
+        dashboard_server_->start();
+    }
+
+    if (!opts_.shm_name.empty())
+        shm_publisher_ = std::make_unique<SharedBookPublisher>(opts_.shm_name, opts_.shm_depth);
+
+    if (opts_.engine_threads > 0)
+        scheduler_ = std::make_unique<EngineScheduler>(opts_.engine_threads);
+}
+
+MatchingEngine *ReplaySession::create_engine(uint16_t locate, const std::string &symbol)
+{
+    auto lob = book_builder_->take();
+    auto engine_uptr = std::make_unique<MatchingEngine>(std::move(lob));
+    MatchingEngine *engine_raw = engine_uptr.get();
+
+    TradeTapeWriter *tape = nullptr;
+    if (!opts_.tape_dir.empty())
+    {
+        const auto path = std::filesystem::path(opts_.tape_dir) / (symbol + ".tape");
+        trade_tapes_.push_back(std::make_unique<TradeTapeWriter>(path.string(), locate, symbol));
+        tape = trade_tapes_.back().get();
+    }
+
+    // every fill goes on the tape at the exchange time of the command that
+    // caused it; returns the fill's sequence number
+    auto record_fill = [this, engine_raw, tape](const TradeEvent &ev)
+    {
+        const uint64_t seq = trade_seq_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (tape)
+        {
+            tape->append({engine_raw->get_book()->time(), seq, ev.taker_id, ev.maker_id,
+                          std::llround(ev.price * 10000.0), ev.quantity, 0});
+        }
+        return seq;
+    };
+
+    if (opts_.conflate)
+    {
+        // a sweep is reported as one print at its last price for its total size
+        engine_raw->setSweepCallback(
+            [this, symbol, locate, tape](const SweepEvent &ev)
+            {
+                if (market_state_)
+                    market_state_->record_trade(locate, ev.last_price, ev.quantity);
+                if (shm_publisher_)
+                    shm_publisher_->record_trade(locate, ev.last_price, ev.quantity);
+                // with a tape the fills were already counted one by one
+                if (!tape)
+                    trade_seq_.fetch_add(ev.fills, std::memory_order_relaxed);
+                if (dashboard_)
+                {
+                    dashboard_->updateTrade(symbol, ev.last_price, ev.quantity);
+                    dashboard_->render();
+                }
+            });
+        if (dashboard_)
+        {
+            engine_raw->setBboCallback(
+                [this, symbol](const BboEvent &ev)
+                {
+                    dashboard_->updateBook(symbol, ev.bid.price, ev.bid.quantity, ev.ask.price, ev.ask.quantity,
+                                           ev.bid.valid, ev.ask.valid);
+                });
+        }
+        // the tape keeps every fill even when the display is conflated
+        if (tape)
+            engine_raw->setTradeCallback([record_fill](const TradeEvent &ev) { record_fill(ev); });
+    }
+    else
+    {
+        engine_raw->setTradeCallback(
+            [this, symbol, engine_raw, locate, record_fill](const TradeEvent &ev)
+            {
+                record_fill(ev);
+                if (market_state_)
+                    market_state_->record_trade(locate, ev.price, ev.quantity);
+                if (shm_publisher_)
+                    shm_publisher_->record_trade(locate, ev.price, ev.quantity);
+                on_trade(symbol, engine_raw, ev);
+            });
+    }
+
+    if (opts_.flight_recorder_size > 0)
+        engine_raw->enable_flight_recorder(opts_.flight_recorder_size);
+
+    if (opts_.check_invariants)
+    {
+        std::string dump_path = opts_.flight_dump_path;
+        engine_raw->setInvariantCallback(
+            [dump_path, symbol](MatchingEngine &engine, const char *violation)
+            {
+                std::ofstream dump(dump_path, std::ios::app);
+                dump << "invariant failure on " << symbol << ": " << violation << "\n";
+                if (engine.flight_recorder())
+                    engine.flight_recorder()->dump(dump, symbol);
+            });
+    }
+
+    if (snapshot_sampler_)
+        snapshot_sampler_->track(locate, symbol, engine_raw->get_book().get());
+    if (stats_reporter_)
+        stats_reporter_->track(locate, symbol, engine_raw);
+    if (lifecycle_report_)
+    {
+        engine_raw->enable_lifecycle_stats();
+        lifecycle_report_->track(symbol, engine_raw);
+    }
+    if (market_state_)
+        market_state_->add_symbol(locate, symbol);
+    if (shm_publisher_)
+        shm_publisher_->add_symbol(locate, symbol);
+
+    engines_[locate] = std::move(engine_uptr);
+    symbols_[locate] = symbol;
+    if (scheduler_)
+        scheduler_->add(locate, engine_raw);
+    return engine_raw;
+}
+
+void ReplaySession::on_trade(const std::string &symbol, MatchingEngine *engine, const TradeEvent &ev)
+{
+    // write to CSV
+    // trade_file_ << trade_seq_ << ","
+    //         << symbol << ","
+    //         << ev.taker_id << ","
+    //         << ev.maker_id << ","
+    //         << ev.price << ","
+    //         << ev.quantity << std::endl;
+
+    if (!dashboard_)
+        return;
+
+    // update last trade in dashboard
+    dashboard_->updateTrade(symbol, ev.price, ev.quantity);
+
+    // get best bid/ask from this engine's LOB
+    auto bid = engine->get_book()->get_best_bid();
+    auto ask = engine->get_book()->get_best_ask();
+
+    dashboard_->updateBook(
+        symbol,
+        bid.price,
+        bid.quantity,
+        ask.price,
+        ask.quantity,
+        bid.valid,
+        ask.valid
+    );
+
+    dashboard_->render();
+}
+
+void ReplaySession::publish_book(uint16_t locate, const LimitOrderBook &book, uint64_t timestamp)
+{
+    if (market_state_)
+        market_state_->publish(locate, book, timestamp);
+    if (shm_publisher_)
+        shm_publisher_->publish(locate, book, timestamp);
+}
+
+void ReplaySession::finish_engines(ReplaySummary &summary, uint32_t dumped_generation)
+{
+    if (!scheduler_)
+        return;
+
+    scheduler_->finish();
+    summary.migrations = scheduler_->migrations();
+    summary.steals = scheduler_->steals();
+
+    // a SIGUSR1 during the run could not read the books; honour it now
+    if (flight_dump_generation.load(std::memory_order_relaxed) != dumped_generation)
+        dump_flight_recorders();
+}
+
+void ReplaySession::finish_outputs()
+{
+    if (snapshot_writer_)
+        snapshot_writer_->finish();
+    if (stats_reporter_)
+        stats_reporter_->write();
+    if (lifecycle_report_)
+        lifecycle_report_->write(opts_.lifecycle_path);
+    for (auto &tape : trade_tapes_)
+        tape->finish();
+}
+
+void ReplaySession::dump_flight_recorders()
+{
+    std::ofstream dump(opts_.flight_dump_path, std::ios::app);
+    for (const auto &[locate, engine] : engines_)
+    {
+        if (engine->flight_recorder())
+            engine->flight_recorder()->dump(dump, symbols_[locate]);
+    }
+}
+
+ReplaySummary ReplaySession::run()
+{
+    if (!opts_.merge && !opts_.mold_port && command_cache::is_cache_file(opts_.input_path))
+        return run_command_cache();
+
+    std::unique_ptr<BlockSource> source;
+    MoldUdpReceiver *receiver = nullptr;
+    if (opts_.mold_port)
+    {
+        auto live = open_live_feed(opts_);
+        receiver = live.get();
+        source = std::move(live);
+    }
+    else
+    {
+        source = opts_.merge ? open_merged_source(opts_.batch_inputs)
+                             : open_block_source(opts_.input_path, PipelinedSource::DEFAULT_BLOCK_SIZE,
+                                                 PipelinedSource::DEFAULT_RING_BLOCKS, opts_.inflate_threads);
+    }
+    ItchFramer framer(*source);
+
+    ReplaySummary summary;
+    uint32_t dumped_generation = flight_dump_generation.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+
+    // the framer hands out one packet's messages at a time, so the receiver's
+    // packet time belongs to the message just handled
+    auto record_latency = [&](const char *data, uint16_t length)
+    {
+        if (!receiver)
+            return;
+        const size_t needed = itch::order_message_length(itch::type(data));
+        if (needed == 0 || length < needed || !dispatcher_.is_tracked(itch::stock_locate(data)))
+            return;
+        const uint64_t now = realtime_ns(), received = receiver->packet_time_ns();
+        summary.packet_to_book_ns.add(now > received ? now - received : 0);
+    };
+
+    auto on_message = [&](const char *data, uint16_t length)
+    {
+        if (scheduler_)
+        {
+            // decode here, apply on the owning worker; books are off limits
+            // to this thread until finish_engines()
+            const char type = itch::type(data);
+            const size_t needed = itch::order_message_length(type);
+            EngineCommand cmd;
+            if (type == 'R')
+                dispatcher_.dispatch(data, length);
+            else if (needed != 0 && length >= needed && dispatcher_.is_tracked(itch::stock_locate(data)) &&
+                     ItchDispatcher::decode(type, data, cmd))
+                scheduler_->submit(cmd);
+            record_latency(data, length);
+            return;
+        }
+
+        if (stats_reporter_)
+            stats_reporter_->tick();
+
+        if (flight_dump_generation.load(std::memory_order_relaxed) != dumped_generation)
+        {
+            dumped_generation = flight_dump_generation.load(std::memory_order_relaxed);
+            dump_flight_recorders();
+        }
+
+        if (snapshot_sampler_ && length >= itch::TIMESTAMP + 6)
+            snapshot_sampler_->advance(itch::timestamp(data));
+
+        dispatcher_.dispatch(data, length);
+
+        if ((market_state_ || shm_publisher_) && length >= itch::TIMESTAMP + 6)
+        {
+            const uint16_t locate = itch::stock_locate(data);
+            if (MatchingEngine *engine = dispatcher_.engine(locate))
+                publish_book(locate, *engine->get_book(), itch::timestamp(data));
+        }
+        record_latency(data, length);
+    };
+
+    // the snapshot grid advances on every message's timestamp, tracked or not,
+    // so sampling replays keep the unfiltered loop
+    if (opts_.prefilter && !snapshot_sampler_)
+    {
+        ItchPrefilter prefilter;
+        summary.messages = prefilter.run(framer, [&](const char *data, uint16_t length)
+        {
+            on_message(data, length);
+            if (itch::type(data) == 'R' && length >= itch::directory::LENGTH &&
+                dispatcher_.is_tracked(itch::stock_locate(data)))
+                prefilter.track(itch::stock_locate(data));
+        });
+    }
+    else
+    {
+        ItchMessageView msg;
+        while (framer.next(msg))
+        {
+            ++summary.messages;
+            on_message(msg.data, msg.length);
+        }
+    }
+
+    finish_engines(summary, dumped_generation);
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    summary.bytes = framer.bytes_consumed();
+    summary.tracked_symbols = dispatcher_.tracked_count();
+    if (receiver)
+        summary.feed = receiver->stats();
+
+    finish_outputs();
+
+    return summary;
+}
+
+ReplaySummary ReplaySession::run_command_cache()
+{
+    CommandCacheReader cache(opts_.input_path);
+
+    // the cache was built for some symbol set; replay the tracked subset of it
+    std::unordered_set<std::string> tracked(opts_.tracked_symbols.begin(), opts_.tracked_symbols.end());
+    std::vector<MatchingEngine *> engines(UINT16_MAX + 1, nullptr);
+    for (const auto &[locate, symbol] : cache.symbols())
+    {
+        if (tracked.count(symbol) && !engines[locate])
+            engines[locate] = create_engine(locate, symbol);
+    }
+
+    ReplaySummary summary;
+    uint32_t dumped_generation = flight_dump_generation.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+
+    const std::span<const EngineCommand> commands = cache.commands();
+    const size_t count = commands.size();
+    size_t i = 0;
+    while (i < count)
+    {
+        // hand each run of same-symbol commands to its engine in one call
+        const uint16_t locate = commands[i].locate;
+        size_t run_end = i + 1;
+        while (run_end < count && commands[run_end].locate == locate)
+            ++run_end;
+
+        MatchingEngine *engine = engines[locate];
+        if (scheduler_)
+        {
+            // books are off limits to this thread until finish_engines()
+            if (engine)
+            {
+                for (size_t k = i; k < run_end; ++k)
+                    scheduler_->submit(commands[k]);
+            }
+            i = run_end;
+            continue;
+        }
+
+        if (stats_reporter_)
+            stats_reporter_->tick();
+
+        if (flight_dump_generation.load(std::memory_order_relaxed) != dumped_generation)
+        {
+            dumped_generation = flight_dump_generation.load(std::memory_order_relaxed);
+            dump_flight_recorders();
+        }
+
+        if (snapshot_sampler_)
+        {
+            for (size_t k = i; k < run_end; ++k)
+            {
+                snapshot_sampler_->advance(commands[k].timestamp);
+                if (engine)
+                    engine->apply(commands[k]);
+            }
+        }
+        else if (engine)
+        {
+            engine->apply_batch(&commands[i], run_end - i);
+        }
+
+        if (engine)
+            publish_book(locate, *engine->get_book(), commands[run_end - 1].timestamp);
+
+        i = run_end;
+    }
+
+    finish_engines(summary, dumped_generation);
+    summary.messages = count;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    summary.bytes = count * sizeof(EngineCommand);
+    summary.tracked_symbols = engines_.size();
+
+    finish_outputs();
+
+    return summary;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "AppOptions.h"
+#include "BookBuilder.h"
+#include "DashboardServer.h"
+#include "EngineScheduler.h"
+#include "ItchDispatcher.h"
+#include "LifecycleReport.h"
+#include "MarketState.h"
+#include "MatchingEngine.h"
+#include "MoldUdp.h"
+#include "OrderLifecycle.h"
+#include "SharedBook.h"
+#include "SnapshotSampler.h"
+#include "SnapshotWriter.h"
+#include "StatsReporter.h"
+#include "TerminalDashboard.h"
+#include "TradeTapeWriter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ReplaySummary {
+    uint64_t messages = 0;      // ITCH messages, or commands for a cache replay
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+    size_t tracked_symbols = 0;
+    uint64_t migrations = 0;    // --engine-threads: symbols moved by rebalancing
+    uint64_t steals = 0;        // and by idle workers
+
+    // --mold-listen: feed sequencing, and the CLOCK_REALTIME time from a
+    // packet reaching the socket to each tracked message in it having been
+    // applied (queued for a worker with --engine-threads)
+    MoldUdpReceiver::Stats feed;
+    Log2Histogram packet_to_book_ns;
+};
+
+// One end-to-end replay of an ITCH file (or of several merged in exchange
+// timestamp order, see ItchMerge): owns the per-symbol engines and the
+// optional outputs (snapshots, stats, flight recorder dumps) configured in
+// AppOptions, and feeds every message through an ItchDispatcher. A command
+// cache input (see CommandCache) is replayed straight from its mapped records,
+// and a live MoldUDP64 feed (see MoldUdpReceiver) goes through the same
+// framer and dispatcher as a file.
+class ReplaySession
+{
+public:
+    // `dashboard` may be null for a headless replay
+    ReplaySession(const AppOptions &opts, TerminalDashboard *dashboard);
+
+    ReplaySummary run();
+
+    // Routes SIGUSR1 to a flight recorder dump in every running session
+    static void install_signal_handlers();
+
+private:
+    ReplaySummary run_command_cache();
+    void finish_engines(ReplaySummary &summary, uint32_t dumped_generation);
+    void publish_book(uint16_t locate, const LimitOrderBook &book, uint64_t timestamp);
+    MatchingEngine *create_engine(uint16_t locate, const std::string &symbol);
+    void on_trade(const std::string &symbol, MatchingEngine *engine, const TradeEvent &ev);
+    void finish_outputs();
+    void dump_flight_recorders();
+
+    const AppOptions &opts_;
+    TerminalDashboard *dashboard_;
+
+    std::ofstream trade_file_;
+    std::atomic<uint64_t> trade_seq_{0};    // bumped from engine workers with --engine-threads
+
+    std::unique_ptr<BookBuilder> book_builder_;
+
+    std::unordered_map<uint16_t, std::unique_ptr<MatchingEngine>> engines_;
+    std::unordered_map<uint16_t, std::string> symbols_;
+    ItchDispatcher dispatcher_;
+
+    // optional engine worker pool; declared after the engines so it stops first
+    std::unique_ptr<EngineScheduler> scheduler_;
+
+    std::unique_ptr<SnapshotWriter> snapshot_writer_;
+    std::unique_ptr<SnapshotSampler> snapshot_sampler_;
+    std::unique_ptr<StatsReporter> stats_reporter_;
+    std::unique_ptr<LifecycleReport> lifecycle_report_;
+
+    // one per tracked symbol; each is written only by whichever thread
+    // applies that symbol's commands
+    std::vector<std::unique_ptr<TradeTapeWriter>> trade_tapes_;
+
+    // optional browser dashboard; the store is written from the replay loop
+    std::unique_ptr<MarketStateStore> market_state_;
+    std::unique_ptr<DashboardServer> dashboard_server_;
+
+    std::unique_ptr<SharedBookPublisher> shm_publisher_;
+};
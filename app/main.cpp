@@ -1,247 +1,162 @@
-#include "LimitOrderBook.h"
-#include "MatchingEngine.h"
+#include "AppOptions.h"
+#include "BacktestRunner.h"
+#include "BatchScheduler.h"
+#include "BlockSource.h"
+#include "CommandCache.h"
+#include "ItchMerge.h"
+#include "MoldUdp.h"
+#include "ReplaySession.h"
 #include "TerminalDashboard.h"
 
-#include <fstream>
+#include <exception>
+#include <iomanip>
 #include <iostream>
-#include <cstdint>
-#include <cstring>
-#include <vector>
-#include <unordered_map>
-#include <unordered_set>
+#include <stdexcept>
 #include <string>
-#include <memory>
+#include <unordered_set>
 
 using namespace std;
 
-int main()
+int main(int argc, char **argv)
 {
-    ifstream file("../../12302019.NASDAQ_ITCH50", ios::binary);
-    std::ofstream trade_file("trades.csv");
-    trade_file << "seq,symbol,taker,maker,price,quantity" << endl;
-    static uint64_t trade_seq = 0;
-
-    if (!file)
+    AppOptions opts;
+    try
     {
-        cerr << "Failed to open the required ITCH file" << endl;
+        opts = parse_options(argc, argv);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        cerr << e.what() << endl;
+        print_usage(argv[0]);
         return 1;
     }
 
-    TerminalDashboard dashboard({
-        "AAPL","MSFT","AMZN","GOOGL","META","NVDA","TSLA","ORCL","INTC","AMD",
-        "JPM","BAC","GS","MS","WMT","COST","TGT","NFLX","DIS","NKE"
-    });
-
-    const unordered_set<string> tracked_symbols = {
-        "AAPL", "MSFT", "AMZN", "GOOGL", "META", "NVDA", "TSLA", "ORCL", "INTC", "AMD",
-        "JPM", "BAC", "GS", "MS", "WMT", "COST", "TGT", "NFLX", "DIS", "NKE"};
+    ReplaySession::install_signal_handlers();
 
-    unordered_map<uint16_t, string> locate_to_symbol;
-
-    unordered_map<uint16_t, unique_ptr<MatchingEngine>> locate_to_engine;
-    size_t tracked_symbols_count = 0;
-
-    static int buy_adds = 0;
-    static int sell_adds = 0;
-
-    while (file)
+    if (!opts.build_cache_path.empty())
     {
-        uint16_t length_be;
-        if (!file.read(reinterpret_cast<char *>(&length_be), sizeof(length_be)))
+        try
         {
-            break; // EOF or error
+            auto source = opts.merge ? open_merged_source(opts.batch_inputs)
+                                     : open_block_source(opts.input_path, PipelinedSource::DEFAULT_BLOCK_SIZE,
+                                                         PipelinedSource::DEFAULT_RING_BLOCKS, opts.inflate_threads);
+            auto summary = build_command_cache(*source,
+                                               unordered_set<string>(opts.tracked_symbols.begin(), opts.tracked_symbols.end()),
+                                               opts.build_cache_path);
+            cerr << "cached " << summary.commands << " commands for " << summary.symbols << " symbols from "
+                 << summary.messages << " messages into " << opts.build_cache_path << endl;
+            return 0;
         }
-
-        uint16_t length = (length_be >> 8) | (length_be << 8);
-        if (length < 1)
+        catch (const std::exception &e)
         {
-            std::cerr << "Invalid length: " << length << "\n";
-            break;
+            cerr << "Failed to build command cache from " << opts.input_path << ": " << e.what() << endl;
+            return 1;
         }
+    }
 
-        char type;
-        if (!file.read(&type, 1))
+    if (opts.mold_publish_port)
+    {
+        try
         {
-            cerr << "Failed to read type\n";
-            break;
+            MoldUdpPublisherConfig config;
+            config.address = opts.mold_publish_host;
+            config.port = opts.mold_publish_port;
+            config.messages_per_second = opts.mold_rate;
+            config.drop_every = opts.mold_drop_every;
+            config.serve_requests = opts.mold_serve_port != 0;
+            config.request_port = opts.mold_serve_port;
+            config.linger_ms = config.serve_requests ? 2000 : 0;
+
+            auto source = open_block_source(opts.input_path, PipelinedSource::DEFAULT_BLOCK_SIZE,
+                                            PipelinedSource::DEFAULT_RING_BLOCKS, opts.inflate_threads);
+            MoldUdpPublisher publisher(config);
+            auto stats = publisher.run(*source);
+            cerr << "published " << stats.messages << " messages in " << stats.packets << " packets ("
+                 << stats.dropped << " dropped, " << stats.retransmitted << " retransmitted)" << endl;
+            return 0;
         }
-
-        // not using char array due to VLA (variable length assignment - silent error)
-        vector<char> payload(length - 1);
-        if (!file.read(payload.data(), payload.size()))
+        catch (const std::exception &e)
         {
-            cerr << "Failed to read payload, len=" << (length - 1) << "\n";
-            break;
+            cerr << "Failed to publish " << opts.input_path << ": " << e.what() << endl;
+            return 1;
         }
+    }
 
-        uint16_t stock_locate = (payload[0] << 8) | payload[1];
-
-        if (type == 'R')
+    if (opts.backtest_variants > 0)
+    {
+        try
         {
-            char symbol[9]{};
-            memcpy(symbol, payload.data() + 10, 8);
-            symbol[8] = '\0';
-
-            string stock(symbol);
-            while (!stock.empty() && stock.back() == ' ')
-                stock.pop_back();
-
-            if (stock.empty() || !tracked_symbols.count(stock) || locate_to_engine.count(stock_locate))
-                continue;
-
-            char market_category = payload[18];
-            char financial_status = payload[19];
-            char issue_classification = payload[25];
-            char authenticity = payload[28];
-
-            // filter: production, common stock, normal financial status
-            if (authenticity != 'P')
-                continue;
-            if (issue_classification != 'C')
-                continue;
-            if (financial_status != 'N' && financial_status != ' ')
-                continue;
-
-            locate_to_symbol[stock_locate] = stock;
-
-            auto lob = std::make_unique<LimitOrderBook>(0, 10000);
-            auto engine_uptr = std::make_unique<MatchingEngine>(std::move(lob));
-            MatchingEngine* engine_raw = engine_uptr.get();
-
-            string stock_copy = stock;
-            
-            engine_raw->setTradeCallback(
-                [&trade_file, stock_copy, &dashboard, engine_raw](const TradeEvent& ev)
-                {
-                    // seq counter
-                    trade_seq++;
-
-                    // write to CSV
-                    // trade_file << trade_seq << ","
-                    //         << stock_copy << ","
-                    //         << ev.taker_id << ","
-                    //         << ev.maker_id << ","
-                    //         << ev.price << ","
-                    //         << ev.quantity << std::endl;
-
-                    // update last trade in dashboard
-                    dashboard.updateTrade(stock_copy, ev.price, ev.quantity);
-
-                    // get best bid/ask from this engine's LOB
-                    auto bid = engine_raw->get_book()->get_best_bid();
-                    auto ask = engine_raw->get_book()->get_best_ask();
-
-                    dashboard.updateBook(
-                        stock_copy,
-                        bid.price,
-                        bid.quantity,
-                        ask.price,
-                        ask.quantity,
-                        bid.valid,
-                        ask.valid
-                    );
-
-                    dashboard.render();
-                }
-            );
-
-            locate_to_engine[stock_locate] = move(engine_uptr);
-            continue;
-        }
+            auto results = run_backtest(opts);
 
-        if (locate_to_engine.count(stock_locate))
-        {
-            unique_ptr<MatchingEngine>& engine = locate_to_engine[stock_locate];
-            if (type == 'A')
+            cerr << "variant  offset  placed    fills     filled_qty  position  pnl          seconds\n";
+            for (const auto &r : results)
             {
-                uint64_t order_id = 0;
-                for (int i = 0; i < 8; i++)
-                    order_id = (order_id << 8) | (unsigned char)payload[10 + i];
-
-                OrderSide side = payload[18] == 'B' ? OrderSide::Buy : OrderSide::Sell;
-                // system("clear");
-                // if (payload[18] == 'B') {
-                //     buy_adds++;
-                // } else if (payload[18] == 'S') {
-                //     sell_adds++;
-                // }
-                // cout << "buys: " << buy_adds << " and sells: " << sell_adds << endl;
-
-                uint32_t shares =
-                    (static_cast<unsigned char>(payload[19]) << 24) |
-                    (static_cast<unsigned char>(payload[20]) << 16) |
-                    (static_cast<unsigned char>(payload[21]) << 8) |
-                    (static_cast<unsigned char>(payload[22]));
-
-                uint32_t price_raw =
-                    (static_cast<unsigned char>(payload[31]) << 24) |
-                    (static_cast<unsigned char>(payload[32]) << 16) |
-                    (static_cast<unsigned char>(payload[33]) << 8) |
-                    (static_cast<unsigned char>(payload[34]));
-
-                double price = price_raw / 10000.0;
-
-                engine->submitLimit(order_id, side, price, shares);
-            }
-            else if (type == 'D')
-            {
-                uint64_t order_id = 0;
-                for (int i = 0; i < 8; i++)
-                    order_id = (order_id << 8) | static_cast<unsigned char>(payload[10 + i]);
-
-                engine->cancel(order_id);
+                cerr << left << setw(9) << r.variant << setw(8) << r.variant << setw(10) << r.orders_placed
+                     << setw(10) << r.fills << setw(12) << r.filled_quantity << setw(10) << r.net_position
+                     << setw(13) << fixed << setprecision(2) << r.pnl << setprecision(3) << r.seconds << "\n";
             }
-            else if (type == 'X')
-            {
-                uint64_t order_id = 0;
-                for (int i = 0; i < 8; i++)
-                    order_id = (order_id << 8) | static_cast<unsigned char>(payload[10 + i]);
+            return 0;
+        }
+        catch (const std::exception &e)
+        {
+            cerr << "Backtest failed: " << e.what() << endl;
+            return 1;
+        }
+    }
 
-                uint32_t cancelled_shares = 0;
-                for (int i = 0; i < 4; i++)
-                {
-                    cancelled_shares = (cancelled_shares << 8) | static_cast<unsigned char>(payload[18 + i]);
-                }
+    if (opts.batch)
+    {
+        try
+        {
+            BatchScheduler scheduler(opts);
+            auto results = scheduler.run();
 
-                engine->reduce_order(order_id, cancelled_shares);
-            }
-            else if (type == 'U')
-            {
-                uint64_t old_order_id = 0;
-                for (int i = 0; i < 8; i++)
-                    old_order_id = (old_order_id << 8) | static_cast<unsigned char>(payload[10 + i]);
+            size_t failed = 0;
+            for (const auto &r : results)
+                failed += r.status == BatchJobResult::Status::Failed;
 
-                uint64_t new_order_id = 0;
-                for (int i = 0; i < 8; i++)
-                    new_order_id = (new_order_id << 8) | static_cast<unsigned char>(payload[18 + i]);
+            cerr << results.size() << " jobs, " << failed << " failed; report in "
+                 << opts.output_dir << "/batch_summary.csv" << endl;
+            return failed ? 1 : 0;
+        }
+        catch (const std::exception &e)
+        {
+            cerr << "Batch replay failed: " << e.what() << endl;
+            return 1;
+        }
+    }
 
-                uint32_t qty = 0;
-                for (int i = 0; i < 4; i++)
-                    qty = (qty << 8) | static_cast<unsigned char>(payload[26 + i]);
+    TerminalDashboard dashboard(opts.tracked_symbols);
 
-                uint32_t price = 0;
-                for (int i = 0; i < 4; i++)
-                    price = (price << 8) | static_cast<unsigned char>(payload[30 + i]);
+    try
+    {
+        ReplaySession session(opts, opts.headless ? nullptr : &dashboard);
+        ReplaySummary summary = session.run();
 
-                double px = price / 10000.0;
-                engine->order_replace(old_order_id, new_order_id, px, qty);
-            }
-            else if (type == 'E')
+        if (opts.headless)
+        {
+            cerr << "replayed " << summary.messages << " messages (" << summary.bytes << " bytes) in "
+                 << summary.seconds << " s, " << summary.tracked_symbols << " symbols tracked" << endl;
+            if (opts.engine_threads)
+                cerr << opts.engine_threads << " engine threads, " << summary.migrations << " migrations, "
+                     << summary.steals << " steals" << endl;
+            if (opts.mold_port)
             {
-                uint64_t order_id = 0;
-                for (int i = 0; i < 8; i++)
-                    order_id = (order_id << 8) | static_cast<unsigned char>(payload[10 + i]);
-
-                uint32_t executed_shares = 0;
-                for (int i = 0; i < 4; i++)
-                {
-                    executed_shares = (executed_shares << 8) | static_cast<unsigned char>(payload[18 + i]);
-                }
-
-                engine->reduce_order(order_id, executed_shares);
+                const auto &feed = summary.feed;
+                const auto &latency = summary.packet_to_book_ns;
+                cerr << "feed: " << feed.packets << " packets, " << feed.gaps << " gaps, " << feed.requested
+                     << " messages requested, " << feed.lost << " lost, " << feed.duplicates << " duplicates" << endl;
+                cerr << "packet to book: p50 " << latency.quantile(0.5) << " ns, p99 " << latency.quantile(0.99)
+                     << " ns, max " << latency.max << " ns (" << latency.total << " messages, power-of-two buckets)"
+                     << endl;
             }
         }
     }
+    catch (const std::exception &e)
+    {
+        cerr << "Failed to replay " << opts.input_path << ": " << e.what() << endl;
+        return 1;
+    }
 
     return 0;
 }
@@ -0,0 +1,56 @@
+#include "BacktestHarness.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+std::vector<BacktestResult> run_backtests(std::span<const EngineCommand> commands,
+                                          const std::vector<std::pair<uint16_t, std::string>> &symbols,
+                                          size_t variants, const StrategyFactory &factory,
+                                          const BacktestConfig &config)
+{
+    std::vector<BacktestResult> results(variants);
+    if (variants == 0)
+        return results;
+
+    size_t threads = config.threads ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, variants);
+
+    std::atomic<size_t> next_variant{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    auto worker = [&]()
+    {
+        for (size_t v = next_variant.fetch_add(1); v < variants; v = next_variant.fetch_add(1))
+        {
+            try
+            {
+                std::unique_ptr<Strategy> strategy = factory(v);
+                BacktestSession session(symbols, *strategy, config);
+                session.run(commands);
+                results[v] = session.result();
+                results[v].variant = v;
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool)
+        t.join();
+
+    if (error)
+        std::rethrow_exception(error);
+    return results;
+}
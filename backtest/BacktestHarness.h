@@ -0,0 +1,22 @@
+#pragma once
+
+#include "BacktestSession.h"
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Builds the strategy for one parameter variant
+using StrategyFactory = std::function<std::unique_ptr<Strategy>(size_t variant)>;
+
+// Replays one decoded command stream through `variants` independent
+// strategy instances on a pool of threads. The stream is shared read-only,
+// so decoding is paid once however many variants run; each variant owns its
+// books, so variants never contend. Results are indexed by variant. The
+// first exception thrown by any variant is rethrown after all threads stop.
+std::vector<BacktestResult> run_backtests(std::span<const EngineCommand> commands,
+                                          const std::vector<std::pair<uint16_t, std::string>> &symbols,
+                                          size_t variants, const StrategyFactory &factory,
+                                          const BacktestConfig &config = {});
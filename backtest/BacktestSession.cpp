@@ -0,0 +1,306 @@
+#include "BacktestSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+
+int64_t to_ticks(double price)
+{
+    return std::llround(price / LimitOrderBook::tick_size());
+}
+
+OrderSide opposite(OrderSide side)
+{
+    return side == OrderSide::Buy ? OrderSide::Sell : OrderSide::Buy;
+}
+
+} // namespace
+
+BacktestSession::BacktestSession(const std::vector<std::pair<uint16_t, std::string>> &symbols, Strategy &strategy,
+                                 const BacktestConfig &config)
+    : strategy_(strategy), by_locate_(UINT16_MAX + 1, nullptr)
+{
+    for (const auto &[locate, symbol] : symbols)
+    {
+        if (by_locate_[locate])
+            continue;
+
+        auto inst = std::make_unique<Instrument>();
+        inst->locate = locate;
+        inst->symbol = symbol;
+        inst->engine = std::make_unique<MatchingEngine>(
+            std::make_unique<LimitOrderBook>(config.min_price, config.max_price, config.pool_size));
+        inst->engine->setTradeCallback(
+            [this](const TradeEvent &ev)
+            {
+                pending_trades_.push_back(ev);
+                on_maker_fill(opposite(taker_side_), to_ticks(ev.price), ev.quantity);
+            });
+
+        by_locate_[locate] = inst.get();
+        instruments_.push_back(std::move(inst));
+    }
+}
+
+BacktestSession::~BacktestSession() = default;
+
+void BacktestSession::run(std::span<const EngineCommand> commands)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (const EngineCommand &cmd : commands)
+        step(cmd);
+    result_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BacktestSession::step(const EngineCommand &cmd)
+{
+    Instrument *inst = by_locate_[cmd.locate];
+    if (!inst)
+        return;
+
+    current_ = inst;
+    now_ = cmd.timestamp;
+    ++result_.commands;
+
+    before_command(cmd);
+    inst->engine->apply(cmd);
+
+    // a real order left resting across a virtual one would have traded with it
+    if (!orders_.empty() && (cmd.type == CommandType::Add || cmd.type == CommandType::Replace))
+    {
+        const int64_t id = cmd.type == CommandType::Add ? cmd.order_id : cmd.new_order_id;
+        const auto &resting = inst->engine->get_book()->orders_by_id;
+        auto it = resting.find(id);
+        if (it != resting.end())
+        {
+            const Order &real = *it->second;
+            const int64_t ticks = to_ticks(real.price);
+            int32_t available = real.quantity;
+            for (auto &order : orders_)
+            {
+                if (available == 0)
+                    break;
+                if (order.locate != inst->locate || order.side == real.side)
+                    continue;
+                bool crossed = order.side == OrderSide::Buy ? ticks <= order.price_ticks : ticks >= order.price_ticks;
+                if (!crossed)
+                    continue;
+                int32_t qty = std::min(available, order.remaining);
+                available -= qty;
+                add_fill(order, order.price, qty, false);
+            }
+        }
+    }
+    remove_filled();
+
+    for (size_t i = 0; i < pending_trades_.size(); ++i)
+        strategy_.on_trade(*this, pending_trades_[i]);
+    pending_trades_.clear();
+
+    settle();
+    strategy_.on_book_update(*this, cmd);
+    settle();
+}
+
+// Volume ahead of resting virtual orders has to be judged against the book
+// as it was before the command, so cancels and executions are looked at here
+void BacktestSession::before_command(const EngineCommand &cmd)
+{
+    if (cmd.type == CommandType::Add)
+    {
+        taker_side_ = cmd.order_side();
+        return;
+    }
+
+    const auto &resting = current_->engine->get_book()->orders_by_id;
+    auto it = resting.find(cmd.order_id);
+    if (it == resting.end())
+        return;
+    const Order &real = *it->second;
+
+    switch (cmd.type)
+    {
+    case CommandType::Cancel:
+        on_level_removal(real, real.quantity);
+        break;
+    case CommandType::Reduce:
+        on_level_removal(real, std::min(cmd.quantity, real.quantity));
+        break;
+    case CommandType::Execute:
+        on_maker_fill(real.side, to_ticks(real.price), std::min(cmd.quantity, real.quantity));
+        break;
+    case CommandType::Replace:
+        taker_side_ = real.side;
+        on_level_removal(real, real.quantity);
+        break;
+    case CommandType::Add:
+        break;
+    }
+}
+
+void BacktestSession::on_level_removal(const Order &real, int32_t shares)
+{
+    if (orders_.empty())
+        return;
+
+    // with the virtual order outside the book, every real order ahead of it
+    // sits strictly inside its queue_ahead volume
+    const int64_t real_ahead = current_->engine->get_book()->queue_ahead(real.order_id).value_or(0);
+    const int64_t ticks = to_ticks(real.price);
+    for (auto &order : orders_)
+    {
+        if (order.locate != current_->locate || order.side != real.side || order.price_ticks != ticks)
+            continue;
+        if (real_ahead < order.queue_ahead)
+            order.queue_ahead -= std::min<int64_t>(shares, order.queue_ahead);
+    }
+}
+
+void BacktestSession::on_maker_fill(OrderSide maker_side, int64_t price_ticks, int32_t quantity)
+{
+    for (auto &order : orders_)
+    {
+        if (order.locate != current_->locate || order.side != maker_side || order.remaining == 0)
+            continue;
+
+        const bool through = maker_side == OrderSide::Buy ? price_ticks < order.price_ticks
+                                                          : price_ticks > order.price_ticks;
+        if (through)
+        {
+            add_fill(order, order.price, std::min(quantity, order.remaining), false);
+        }
+        else if (price_ticks == order.price_ticks)
+        {
+            // FIFO: the volume ahead trades first
+            const int64_t consumed = std::min<int64_t>(quantity, order.queue_ahead);
+            order.queue_ahead -= consumed;
+            const int64_t left = quantity - consumed;
+            if (left > 0)
+                add_fill(order, order.price, static_cast<int32_t>(std::min<int64_t>(left, order.remaining)), false);
+        }
+    }
+}
+
+void BacktestSession::add_fill(VirtualOrder &order, double price, int32_t quantity, bool aggressive)
+{
+    if (quantity <= 0)
+        return;
+    order.remaining -= quantity;
+    pending_fills_.push_back({order.id, order.locate, order.side, price, quantity, order.remaining, aggressive, now_});
+}
+
+void BacktestSession::remove_filled()
+{
+    std::erase_if(orders_, [](const VirtualOrder &order) { return order.remaining == 0; });
+}
+
+void BacktestSession::settle()
+{
+    // strategies may place (and so fill) more orders from on_fill
+    while (!pending_fills_.empty())
+    {
+        std::vector<VirtualFill> fills;
+        fills.swap(pending_fills_);
+
+        for (const VirtualFill &fill : fills)
+        {
+            Instrument *inst = by_locate_[fill.locate];
+            const int64_t signed_qty = fill.side == OrderSide::Buy ? fill.quantity : -int64_t(fill.quantity);
+            inst->position += signed_qty;
+            inst->cash -= signed_qty * fill.price;
+
+            ++result_.fills;
+            result_.filled_quantity += fill.quantity;
+
+            current_ = inst;
+            strategy_.on_fill(*this, fill);
+        }
+    }
+}
+
+const LimitOrderBook &BacktestSession::book() const
+{
+    return *current_->engine->get_book();
+}
+
+uint64_t BacktestSession::place(OrderSide side, double price, int32_t quantity)
+{
+    if (quantity <= 0)
+        throw std::invalid_argument("virtual order quantity must be positive");
+
+    VirtualOrder order;
+    order.id = next_order_id_++;
+    order.locate = current_->locate;
+    order.side = side;
+    order.price_ticks = to_ticks(price);
+    order.price = order.price_ticks * LimitOrderBook::tick_size();
+    order.quantity = quantity;
+    order.remaining = quantity;
+    ++result_.orders_placed;
+
+    const LimitOrderBook &lob = book();
+    const auto touch = side == OrderSide::Buy ? lob.get_best_ask() : lob.get_best_bid();
+    if (touch.valid)
+    {
+        const int64_t touch_ticks = to_ticks(touch.price);
+        const bool marketable = side == OrderSide::Buy ? touch_ticks <= order.price_ticks
+                                                       : touch_ticks >= order.price_ticks;
+        if (marketable)
+            add_fill(order, touch.price, std::min(quantity, touch.quantity), true);
+    }
+
+    if (order.remaining > 0)
+    {
+        order.queue_ahead = lob.level_quantity(side, order.price);
+        orders_.push_back(order);
+    }
+    return order.id;
+}
+
+bool BacktestSession::cancel(uint64_t order_id)
+{
+    auto it = std::find_if(orders_.begin(), orders_.end(),
+                           [order_id](const VirtualOrder &order) { return order.id == order_id; });
+    if (it == orders_.end())
+        return false;
+
+    orders_.erase(it);
+    ++result_.orders_cancelled;
+    return true;
+}
+
+const VirtualOrder *BacktestSession::find_order(uint64_t order_id) const
+{
+    for (const auto &order : orders_)
+    {
+        if (order.id == order_id)
+            return &order;
+    }
+    return nullptr;
+}
+
+BacktestResult BacktestSession::result() const
+{
+    BacktestResult result = result_;
+    for (const auto &inst : instruments_)
+    {
+        const LimitOrderBook &lob = *inst->engine->get_book();
+        const auto bid = lob.get_best_bid();
+        const auto ask = lob.get_best_ask();
+
+        double mark = 0.0;
+        if (bid.valid && ask.valid)
+            mark = (bid.price + ask.price) / 2.0;
+        else if (bid.valid || ask.valid)
+            mark = bid.valid ? bid.price : ask.price;
+
+        result.net_position += inst->position;
+        result.cash += inst->cash;
+        result.pnl += inst->cash + inst->position * mark;
+    }
+    return result;
+}
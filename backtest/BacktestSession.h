@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Strategy.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BacktestConfig {
+    // Book construction for every simulated symbol
+    double min_price = 0.0;
+    double max_price = 10000.0;
+    size_t pool_size = 1'000'000;
+
+    // Parallel variants (0 = one per hardware thread)
+    size_t threads = 0;
+};
+
+struct BacktestResult {
+    size_t variant = 0;
+    uint64_t commands = 0;
+    uint64_t orders_placed = 0;
+    uint64_t orders_cancelled = 0;
+    uint64_t fills = 0;
+    int64_t filled_quantity = 0;
+    int64_t net_position = 0;   // summed over symbols
+    double cash = 0.0;
+    double pnl = 0.0;           // cash plus positions marked at the final mid
+    double seconds = 0.0;
+};
+
+// One strategy replayed against its own copy of every tracked book. Real
+// commands are applied unchanged; virtual orders are matched against the
+// real flow around them:
+//  - a virtual order joins the queue behind the real volume at its price;
+//  - real cancels and reduces shrink that volume only for orders that were
+//    ahead of it (LimitOrderBook::queue_ahead tells them apart);
+//  - real executions at its price consume the volume ahead first, then fill
+//    it, and prices trading through it fill it outright;
+//  - a real order left resting across it fills it as well.
+class BacktestSession : public StrategyContext
+{
+public:
+    BacktestSession(const std::vector<std::pair<uint16_t, std::string>> &symbols, Strategy &strategy,
+                    const BacktestConfig &config = {});
+    ~BacktestSession() override;
+
+    void run(std::span<const EngineCommand> commands);
+    void step(const EngineCommand &cmd);
+
+    BacktestResult result() const;
+    const std::vector<VirtualOrder> &open_orders() const { return orders_; }
+
+    // StrategyContext
+    const LimitOrderBook &book() const override;
+    uint16_t locate() const override { return current_->locate; }
+    const std::string &symbol() const override { return current_->symbol; }
+    uint64_t timestamp() const override { return now_; }
+    uint64_t place(OrderSide side, double price, int32_t quantity) override;
+    bool cancel(uint64_t order_id) override;
+    const VirtualOrder *find_order(uint64_t order_id) const override;
+    int64_t position() const override { return current_->position; }
+
+private:
+    struct Instrument {
+        uint16_t locate = 0;
+        std::string symbol;
+        std::unique_ptr<MatchingEngine> engine;
+        int64_t position = 0;
+        double cash = 0.0;
+    };
+
+    void before_command(const EngineCommand &cmd);
+    void on_level_removal(const Order &order, int32_t shares);
+    void on_maker_fill(OrderSide maker_side, int64_t price_ticks, int32_t quantity);
+    void add_fill(VirtualOrder &order, double price, int32_t quantity, bool aggressive);
+    void remove_filled();
+    void settle();
+
+    Strategy &strategy_;
+    std::vector<std::unique_ptr<Instrument>> instruments_;
+    std::vector<Instrument *> by_locate_;
+    Instrument *current_ = nullptr;
+    uint64_t now_ = 0;
+    OrderSide taker_side_ = OrderSide::Buy;
+
+    std::vector<VirtualOrder> orders_;
+    std::vector<VirtualFill> pending_fills_;
+    std::vector<TradeEvent> pending_trades_;
+    uint64_t next_order_id_ = 1;
+
+    BacktestResult result_;
+};
@@ -0,0 +1,31 @@
+#include "JoinBestStrategy.h"
+
+#include <cmath>
+
+void JoinBestStrategy::on_book_update(StrategyContext &ctx, const EngineCommand &)
+{
+    const LimitOrderBook &book = ctx.book();
+    const auto bid = book.get_best_bid();
+    const auto ask = book.get_best_ask();
+    const double offset = params_.offset_ticks * LimitOrderBook::tick_size();
+
+    Quotes &q = quotes_[ctx.locate()];
+    requote(ctx, OrderSide::Buy, q.bid_id, bid.valid && ctx.position() < params_.max_position, bid.price - offset);
+    requote(ctx, OrderSide::Sell, q.ask_id, ask.valid && ctx.position() > -params_.max_position, ask.price + offset);
+}
+
+void JoinBestStrategy::requote(StrategyContext &ctx, OrderSide side, uint64_t &order_id, bool valid, double target)
+{
+    const VirtualOrder *live = order_id ? ctx.find_order(order_id) : nullptr;
+
+    // keep a quote that is still at the target price (and its queue position)
+    if (live && valid && std::abs(live->price - target) < LimitOrderBook::tick_size() / 2)
+        return;
+
+    if (live)
+        ctx.cancel(order_id);
+    order_id = 0;
+
+    if (valid && target > 0.0)
+        order_id = ctx.place(side, target, params_.quote_size);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Strategy.h"
+#include <cstdint>
+#include <unordered_map>
+
+// Reference market maker: quotes `quote_size` on both sides, `offset_ticks`
+// behind the real best bid / ask, requoting when the touch moves and
+// stopping a side once |position| reaches `max_position`.
+class JoinBestStrategy : public Strategy
+{
+public:
+    struct Params {
+        int32_t quote_size = 100;
+        int32_t offset_ticks = 0;
+        int64_t max_position = 1000;
+    };
+
+    explicit JoinBestStrategy(Params params) : params_(params) {}
+
+    void on_book_update(StrategyContext &ctx, const EngineCommand &cmd) override;
+
+private:
+    struct Quotes {
+        uint64_t bid_id = 0;
+        uint64_t ask_id = 0;
+    };
+
+    void requote(StrategyContext &ctx, OrderSide side, uint64_t &order_id, bool valid, double target);
+
+    Params params_;
+    std::unordered_map<uint16_t, Quotes> quotes_;
+};
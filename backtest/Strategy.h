@@ -0,0 +1,71 @@
+#pragma once
+
+#include "EngineCommand.h"
+#include "LimitOrderBook.h"
+#include "MatchingEngine.h"
+#include <cstdint>
+#include <string>
+
+// A simulated order that lives beside the replayed book, never in it.
+// `queue_ahead` is the real volume that must trade or cancel before it fills.
+struct VirtualOrder {
+    uint64_t id = 0;
+    uint16_t locate = 0;
+    OrderSide side = OrderSide::Buy;
+    int64_t price_ticks = 0;
+    double price = 0.0;
+    int32_t quantity = 0;       // original size
+    int32_t remaining = 0;
+    int64_t queue_ahead = 0;
+};
+
+struct VirtualFill {
+    uint64_t order_id = 0;
+    uint16_t locate = 0;
+    OrderSide side = OrderSide::Buy;
+    double price = 0.0;
+    int32_t quantity = 0;
+    int32_t remaining = 0;      // left on the order after this fill
+    bool aggressive = false;    // took displayed liquidity on placement
+    uint64_t timestamp = 0;
+};
+
+// What a strategy can see and do while handling a callback. Book access and
+// positions refer to the symbol the callback is for.
+class StrategyContext
+{
+public:
+    virtual ~StrategyContext() = default;
+
+    virtual const LimitOrderBook &book() const = 0;
+    virtual uint16_t locate() const = 0;
+    virtual const std::string &symbol() const = 0;
+    virtual uint64_t timestamp() const = 0;
+
+    // Places a virtual limit order and returns its id. A marketable order
+    // fills against the displayed opposite top of book (without consuming
+    // it); any remainder joins the back of the queue at its price.
+    // Throws std::invalid_argument for a non-positive quantity.
+    virtual uint64_t place(OrderSide side, double price, int32_t quantity) = 0;
+    // False if the order already filled or was cancelled
+    virtual bool cancel(uint64_t order_id) = 0;
+    // nullptr once the order is filled or cancelled
+    virtual const VirtualOrder *find_order(uint64_t order_id) const = 0;
+
+    virtual int64_t position() const = 0;
+};
+
+// Strategy callbacks, all invoked after the triggering real command has been
+// fully applied to the book.
+class Strategy
+{
+public:
+    virtual ~Strategy() = default;
+
+    // After every real command for a tracked symbol
+    virtual void on_book_update(StrategyContext &, const EngineCommand &) {}
+    // For each real trade produced by an aggressive real order
+    virtual void on_trade(StrategyContext &, const TradeEvent &) {}
+    // For each (partial) fill of one of this strategy's virtual orders
+    virtual void on_fill(StrategyContext &, const VirtualFill &) {}
+};
@@ -0,0 +1,123 @@
+#include "BookBuilder.h"
+
+#include <algorithm>
+#include <chrono>
+
+BookBuilder::BookBuilder(BookBuilderConfig config, Prepare prepare)
+    : config_(config), prepare_(std::move(prepare))
+{
+    const size_t threads = config_.ahead ? std::clamp<size_t>(config_.threads, 1, config_.ahead) : 0;
+    for (size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(&BookBuilder::run, this);
+}
+
+BookBuilder::~BookBuilder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+std::unique_ptr<LimitOrderBook> BookBuilder::build() const
+{
+    auto book = std::make_unique<LimitOrderBook>(config_.min_price, config_.max_price);
+    book->prefault(config_.prefault_orders);
+    if (prepare_)
+        prepare_(*book);
+    return book;
+}
+
+void BookBuilder::run()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this]
+                          { return stop_ || error_ ||
+                                   (ready_.size() + building_ < config_.ahead && started_ < config_.limit); });
+            if (stop_ || error_)
+                return;
+            ++building_;
+            ++started_;
+        }
+
+        std::unique_ptr<LimitOrderBook> book;
+        std::exception_ptr error;
+        try
+        {
+            book = build();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --building_;
+            if (error)
+            {
+                if (!error_)
+                    error_ = error;
+            }
+            else
+            {
+                ready_.push_back(std::move(book));
+            }
+        }
+        changed_.notify_all();
+    }
+}
+
+std::unique_ptr<LimitOrderBook> BookBuilder::take()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++taken_;
+        if (!workers_.empty())
+        {
+            // wait while a book is on its way; past the limit nothing is coming
+            const auto start = std::chrono::steady_clock::now();
+            changed_.wait(lock, [this]
+                          { return !ready_.empty() || error_ || (building_ == 0 && started_ >= config_.limit); });
+            wait_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                            .count();
+
+            if (!ready_.empty())
+            {
+                auto book = std::move(ready_.front());
+                ready_.pop_front();
+                lock.unlock();
+                changed_.notify_all();
+                return book;
+            }
+            if (error_)
+                std::rethrow_exception(error_);
+        }
+        ++built_inline_;
+    }
+    return build();
+}
+
+size_t BookBuilder::taken() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return taken_;
+}
+
+size_t BookBuilder::built_inline() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return built_inline_;
+}
+
+uint64_t BookBuilder::wait_ns() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wait_ns_;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "LimitOrderBook.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct BookBuilderConfig {
+    double min_price = 0.0;
+    double max_price = 10000.0;
+    size_t ahead = 4;                   // books kept built ahead of need; 0 builds inline in take()
+    size_t threads = 1;                 // builder threads when ahead > 0
+    size_t limit = SIZE_MAX;            // most books ever needed (e.g. the tracked symbol count)
+    size_t prefault_orders = 1 << 16;   // pool slots faulted in before handover
+};
+
+// Builds LimitOrderBooks ahead of need on background threads. A book over the
+// default 1M-tick ladder writes tens of megabytes (and takes the page faults)
+// in its constructor, which stalls the replay if it happens inline when a
+// stock directory message lists a tracked symbol. The builder keeps up to
+// `ahead` books constructed, prefaulted and prepared, and take() hands one
+// over, waiting only when the replay outruns the builders.
+class BookBuilder
+{
+public:
+    // Runs on the builder thread on every book before handover
+    using Prepare = std::function<void(LimitOrderBook &)>;
+
+    explicit BookBuilder(BookBuilderConfig config, Prepare prepare = {});
+    ~BookBuilder();
+
+    BookBuilder(const BookBuilder &) = delete;
+    BookBuilder &operator=(const BookBuilder &) = delete;
+
+    // A ready book. Rethrows an exception raised while building one.
+    std::unique_ptr<LimitOrderBook> take();
+
+    size_t taken() const;
+    size_t built_inline() const;        // taken without a builder having made them
+    uint64_t wait_ns() const;           // time take() spent waiting on builders
+
+private:
+    std::unique_ptr<LimitOrderBook> build() const;
+    void run();
+
+    const BookBuilderConfig config_;
+    const Prepare prepare_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::unique_ptr<LimitOrderBook>> ready_;
+    size_t building_ = 0;
+    size_t started_ = 0;
+    size_t taken_ = 0;
+    size_t built_inline_ = 0;
+    uint64_t wait_ns_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Order.h"
+#include <cstdint>
+#include <type_traits>
+
+// A fully decoded order-book command: the normalized form of ITCH A/F, D, X,
+// E/C and U messages. Fixed size and trivially copyable so arrays of them can
+// be written to disk and mapped straight back in (see CommandCache).
+enum class CommandType : uint8_t {
+    Add = 'A',
+    Cancel = 'D',
+    Reduce = 'X',
+    Execute = 'E',
+    Replace = 'U'
+};
+
+struct alignas(8) EngineCommand {
+    int64_t order_id;       // original order for Replace
+    int64_t new_order_id;   // Replace only
+    uint64_t timestamp;     // exchange ns since midnight
+    uint32_t price;         // ITCH fixed point, 4 implied decimals (Add/Replace)
+    int32_t quantity;       // shares added / removed / executed
+    uint16_t locate;
+    CommandType type;
+    uint8_t side;           // 0 = Buy, 1 = Sell (Add only)
+    uint8_t reserved[4];
+
+    OrderSide order_side() const { return side ? OrderSide::Sell : OrderSide::Buy; }
+    double price_value() const { return price / 10000.0; }
+};
+
+static_assert(sizeof(EngineCommand) == 40);
+static_assert(std::is_trivially_copyable_v<EngineCommand>);
@@ -0,0 +1,350 @@
+#include "EngineScheduler.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <stdexcept>
+
+namespace
+{
+
+// Idle workers spin through their lanes this many times before sleeping
+constexpr int IDLE_SPINS = 64;
+constexpr auto IDLE_SLEEP = std::chrono::microseconds(50);
+
+// A symbol is only worth stealing with at least this many commands queued
+constexpr uint64_t MIN_STEAL_BACKLOG = 32;
+
+uint64_t now_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+} // namespace
+
+EngineScheduler::EngineScheduler(size_t workers, size_t ring_capacity, uint64_t rebalance_every)
+    : lane_of_(UINT16_MAX + 1, -1),
+      ring_capacity_(std::bit_ceil(std::max<size_t>(ring_capacity, 2))),
+      rebalance_every_(std::max<uint64_t>(rebalance_every, 1)),
+      workers_(workers)
+{
+    if (workers == 0)
+        throw std::invalid_argument("EngineScheduler: need at least one worker");
+
+    // workers index lanes_ while the producer adds; it must never reallocate
+    lanes_.reserve(UINT16_MAX + 1);
+    for (uint32_t w = 0; w < workers_.size(); ++w)
+        workers_[w].thread = std::thread(&EngineScheduler::run, this, w);
+}
+
+EngineScheduler::~EngineScheduler()
+{
+    stop_workers();
+}
+
+void EngineScheduler::add(uint16_t locate, MatchingEngine *engine)
+{
+    if (lane_of_[locate] >= 0)
+        throw std::invalid_argument("EngineScheduler: locate added twice");
+
+    auto lane = std::make_unique<Lane>();
+    lane->locate = locate;
+    lane->engine = engine;
+    lane->ring.resize(ring_capacity_);
+    lane->mask = ring_capacity_ - 1;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t id = static_cast<uint32_t>(lanes_.size());
+
+    // new symbols go to the worker owning the fewest
+    uint32_t owner = 0;
+    for (uint32_t w = 1; w < workers_.size(); ++w)
+    {
+        if (workers_[w].lanes.size() < workers_[owner].lanes.size())
+            owner = w;
+    }
+    lane->owner.store(owner, std::memory_order_relaxed);
+    lanes_.push_back(std::move(lane));
+    workers_[owner].lanes.push_back(id);
+    lane_of_[locate] = static_cast<int32_t>(id);
+    assignment_version_.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t EngineScheduler::queued(const Lane &lane)
+{
+    return lane.tail.load(std::memory_order_acquire) - lane.head.load(std::memory_order_acquire);
+}
+
+void EngineScheduler::wait_for_space(Lane &lane, uint64_t tail)
+{
+    int spins = 0;
+    while (true)
+    {
+        lane.cached_head = lane.head.load(std::memory_order_acquire);
+        if (tail - lane.cached_head < lane.ring.size())
+            return;
+
+        if (failed_.load(std::memory_order_acquire))
+        {
+            stop_workers();
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::rethrow_exception(error_);
+        }
+        if (++spins < IDLE_SPINS)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+}
+
+bool EngineScheduler::drain(Lane &lane)
+{
+    if (lane.claimed.exchange(true, std::memory_order_acquire))
+        return false;
+
+    const uint64_t head = lane.head.load(std::memory_order_relaxed);
+    const uint64_t tail = lane.tail.load(std::memory_order_acquire);
+    if (head == tail)
+    {
+        lane.claimed.store(false, std::memory_order_release);
+        return false;
+    }
+
+    // the batch may wrap around the ring: apply it as at most two runs
+    const uint64_t count = std::min<uint64_t>(tail - head, BATCH);
+    const uint64_t start = head & lane.mask;
+    const uint64_t first = std::min<uint64_t>(count, lane.ring.size() - start);
+
+    const uint64_t t0 = now_ns();
+    lane.engine->apply_batch(&lane.ring[start], first);
+    if (count > first)
+        lane.engine->apply_batch(&lane.ring[0], count - first);
+    lane.busy_ns.fetch_add(now_ns() - t0, std::memory_order_relaxed);
+    lane.applied.fetch_add(count, std::memory_order_relaxed);
+
+    lane.head.store(head + count, std::memory_order_release);
+    lane.claimed.store(false, std::memory_order_release);
+    return true;
+}
+
+void EngineScheduler::run(uint32_t me)
+{
+    std::vector<uint32_t> mine;
+    uint64_t version = ~uint64_t{0};
+    int idle = 0;
+
+    try
+    {
+        while (!failed_.load(std::memory_order_relaxed))
+        {
+            const uint64_t current = assignment_version_.load(std::memory_order_acquire);
+            if (current != version)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                mine = workers_[me].lanes;
+                version = assignment_version_.load(std::memory_order_relaxed);
+            }
+
+            bool worked = false;
+            for (uint32_t id : mine)
+            {
+                Lane &lane = *lanes_[id];
+                if (lane.owner.load(std::memory_order_relaxed) == me)
+                    worked |= drain(lane);
+            }
+            if (worked)
+            {
+                idle = 0;
+                continue;
+            }
+
+            if (steal(me))
+                continue;
+
+            if (producer_done_.load(std::memory_order_acquire))
+            {
+                // exit once nothing is queued anywhere; a stolen or migrated
+                // symbol may still be draining on another worker
+                std::lock_guard<std::mutex> lock(mutex_);
+                bool empty = true;
+                for (const auto &lane : lanes_)
+                    empty = empty && queued(*lane) == 0;
+                if (empty)
+                    return;
+            }
+
+            if (++idle < IDLE_SPINS)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_)
+            error_ = std::current_exception();
+        failed_.store(true, std::memory_order_release);
+    }
+}
+
+void EngineScheduler::move_lane(uint32_t id, uint32_t to)
+{
+    Lane &lane = *lanes_[id];
+    auto &from = workers_[lane.owner.load(std::memory_order_relaxed)].lanes;
+    from.erase(std::find(from.begin(), from.end(), id));
+    workers_[to].lanes.push_back(id);
+    lane.owner.store(to, std::memory_order_relaxed);
+    ++lane.moves;
+    assignment_version_.fetch_add(1, std::memory_order_release);
+}
+
+bool EngineScheduler::steal(uint32_t thief)
+{
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock())
+        return false;
+
+    // the victim is the worker with the deepest backlog spread over at least
+    // two symbols; taking its sole busy symbol would only move the hot spot
+    uint32_t victim = thief;
+    uint64_t victim_backlog = 0;
+    for (uint32_t w = 0; w < workers_.size(); ++w)
+    {
+        if (w == thief)
+            continue;
+        uint64_t backlog = 0;
+        size_t busy = 0;
+        for (uint32_t id : workers_[w].lanes)
+        {
+            const uint64_t q = queued(*lanes_[id]);
+            backlog += q;
+            busy += q >= MIN_STEAL_BACKLOG;
+        }
+        if (busy >= 2 && backlog > victim_backlog)
+        {
+            victim = w;
+            victim_backlog = backlog;
+        }
+    }
+    if (victim == thief)
+        return false;
+
+    // take its second-deepest symbol and leave the deepest where its cache is warm
+    uint32_t deepest = UINT32_MAX, second = UINT32_MAX;
+    uint64_t deepest_q = 0, second_q = 0;
+    for (uint32_t id : workers_[victim].lanes)
+    {
+        const uint64_t q = queued(*lanes_[id]);
+        if (q > deepest_q)
+        {
+            second = deepest;
+            second_q = deepest_q;
+            deepest = id;
+            deepest_q = q;
+        }
+        else if (q > second_q)
+        {
+            second = id;
+            second_q = q;
+        }
+    }
+    if (second == UINT32_MAX || second_q < MIN_STEAL_BACKLOG)
+        return false;
+
+    move_lane(second, thief);
+    steals_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void EngineScheduler::rebalance()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (workers_.size() < 2 || lanes_.size() < 2)
+        return;
+
+    // per-symbol load: engine time in this window plus the queued commands
+    // priced at the symbol's average cost so far
+    std::vector<uint64_t> lane_load(lanes_.size());
+    for (size_t id = 0; id < lanes_.size(); ++id)
+    {
+        Lane &lane = *lanes_[id];
+        const uint64_t busy = lane.busy_ns.load(std::memory_order_relaxed);
+        const uint64_t applied = lane.applied.load(std::memory_order_relaxed);
+        const uint64_t per_command = applied ? std::max<uint64_t>(busy / applied, 1) : 1;
+        lane_load[id] = busy - lane.busy_at_rebalance + queued(lane) * per_command;
+        lane.busy_at_rebalance = busy;
+    }
+
+    std::vector<uint64_t> worker_load(workers_.size(), 0);
+    for (uint32_t w = 0; w < workers_.size(); ++w)
+    {
+        for (uint32_t id : workers_[w].lanes)
+            worker_load[w] += lane_load[id];
+    }
+    const auto [min_it, max_it] = std::minmax_element(worker_load.begin(), worker_load.end());
+    const uint32_t busiest = static_cast<uint32_t>(max_it - worker_load.begin());
+    const uint32_t idlest = static_cast<uint32_t>(min_it - worker_load.begin());
+    const uint64_t gap = *max_it - *min_it;
+
+    // ignore gaps under 1/8 of the busiest worker's load, and never strip a
+    // worker of its last symbol
+    if (busiest == idlest || gap * 8 < *max_it || workers_[busiest].lanes.size() < 2)
+        return;
+
+    // moving a symbol of load x leaves the two at max - x and min + x; the
+    // best candidate is the one closest to gap / 2, and anything under the
+    // gap still narrows it
+    uint32_t best = UINT32_MAX;
+    uint64_t best_distance = UINT64_MAX;
+    for (uint32_t id : workers_[busiest].lanes)
+    {
+        const uint64_t x = lane_load[id];
+        if (x == 0 || x >= gap)
+            continue;
+        const uint64_t distance = x > gap / 2 ? x - gap / 2 : gap / 2 - x;
+        if (distance < best_distance)
+        {
+            best = id;
+            best_distance = distance;
+        }
+    }
+    if (best == UINT32_MAX)
+        return;
+
+    move_lane(best, idlest);
+    migrations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EngineScheduler::stop_workers()
+{
+    producer_done_.store(true, std::memory_order_release);
+    for (auto &worker : workers_)
+    {
+        if (worker.thread.joinable())
+            worker.thread.join();
+    }
+}
+
+void EngineScheduler::finish()
+{
+    stop_workers();
+    if (error_)
+        std::rethrow_exception(error_);
+}
+
+std::vector<EngineScheduler::SymbolLoad> EngineScheduler::loads() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<SymbolLoad> out;
+    out.reserve(lanes_.size());
+    for (const auto &lane : lanes_)
+    {
+        out.push_back({lane->locate, lane->applied.load(std::memory_order_relaxed),
+                       lane->busy_ns.load(std::memory_order_relaxed), lane->owner.load(std::memory_order_relaxed),
+                       lane->moves});
+    }
+    return out;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "EngineCommand.h"
+#include "MatchingEngine.h"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Applies commands to per-symbol MatchingEngines on a pool of worker threads.
+// The producer (the replay thread) pushes each command into its symbol's
+// single-producer single-consumer ring; a symbol is owned by one worker at a
+// time, which drains it in batches and charges the elapsed time to it.
+//
+// Symbol activity is heavily skewed, so ownership is not fixed:
+//  - every `rebalance_every` commands the producer compares worker loads
+//    (engine time over the last window plus the estimated cost of what is
+//    still queued) and moves one symbol from the busiest to the idlest worker
+//    when that narrows the gap
+//  - a worker whose own symbols have nothing queued steals a symbol with
+//    queued commands from the worker with the deepest backlog, as long as
+//    the victim keeps another busy symbol
+//
+// A symbol only changes hands between batches: whoever drains it must first
+// win its claim flag, so its commands are applied in order by one thread at
+// a time, and the release/acquire on the flag hands the book to the next
+// owner. Engine callbacks run on the worker threads.
+class EngineScheduler
+{
+public:
+    struct SymbolLoad {
+        uint16_t locate;
+        uint64_t commands;      // applied so far
+        uint64_t busy_ns;       // time spent applying them
+        size_t worker;          // current owner
+        uint64_t moves;         // times it changed owner
+    };
+
+    explicit EngineScheduler(size_t workers, size_t ring_capacity = 1024, uint64_t rebalance_every = 1 << 16);
+    ~EngineScheduler();
+
+    EngineScheduler(const EngineScheduler &) = delete;
+    EngineScheduler &operator=(const EngineScheduler &) = delete;
+
+    // Producer thread only. A symbol must be added before its first command.
+    void add(uint16_t locate, MatchingEngine *engine);
+    bool has(uint16_t locate) const { return lane_of_[locate] >= 0; }
+
+    // Producer thread only. Blocks while the symbol's ring is full; rethrows
+    // an exception raised by an engine.
+    void submit(const EngineCommand &cmd)
+    {
+        Lane &lane = *lanes_[lane_of_[cmd.locate]];
+        const uint64_t tail = lane.tail.load(std::memory_order_relaxed);
+        if (tail - lane.cached_head == lane.ring.size())
+            wait_for_space(lane, tail);
+        lane.ring[tail & lane.mask] = cmd;
+        lane.tail.store(tail + 1, std::memory_order_release);
+
+        if (++submitted_ % rebalance_every_ == 0)
+            rebalance();
+    }
+
+    // Waits until every submitted command has been applied, then stops the
+    // workers. Rethrows the first exception raised by an engine.
+    void finish();
+
+    size_t workers() const { return workers_.size(); }
+    uint64_t migrations() const { return migrations_.load(std::memory_order_relaxed); }
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+    std::vector<SymbolLoad> loads() const;
+
+private:
+    static constexpr size_t BATCH = 256;
+
+    struct alignas(64) Lane {
+        // consumer side, written by whichever worker holds `claimed`
+        std::atomic<uint64_t> head{0};
+        std::atomic<bool> claimed{false};
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<uint64_t> applied{0};
+
+        // producer side
+        alignas(64) std::atomic<uint64_t> tail{0};
+        uint64_t cached_head = 0;
+        uint64_t busy_at_rebalance = 0;
+
+        // owner bookkeeping, guarded by EngineScheduler::mutex_
+        alignas(64) std::atomic<uint32_t> owner{0};
+        uint64_t moves = 0;
+
+        uint16_t locate = 0;
+        MatchingEngine *engine = nullptr;
+        std::vector<EngineCommand> ring;
+        uint64_t mask = 0;
+    };
+
+    struct Worker {
+        std::vector<uint32_t> lanes;    // owned lanes, guarded by mutex_
+        std::thread thread;
+    };
+
+    void run(uint32_t me);
+    bool drain(Lane &lane);
+    bool steal(uint32_t thief);
+    void rebalance();
+    void wait_for_space(Lane &lane, uint64_t tail);
+    void move_lane(uint32_t lane, uint32_t to);
+    static uint64_t queued(const Lane &lane);
+    void stop_workers();
+
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::vector<int32_t> lane_of_;      // by locate, -1 if untracked
+    size_t ring_capacity_;
+    uint64_t rebalance_every_;
+    uint64_t submitted_ = 0;
+
+    mutable std::mutex mutex_;
+    std::vector<Worker> workers_;
+    std::atomic<uint64_t> assignment_version_{0};    // bumped on every ownership change
+
+    std::atomic<bool> producer_done_{false};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;                      // guarded by mutex_
+
+    std::atomic<uint64_t> migrations_{0};
+    std::atomic<uint64_t> steals_{0};
+};
@@ -0,0 +1,70 @@
+#include "FlightRecorder.h"
+
+#include <iomanip>
+#include <stdexcept>
+
+FlightRecorder::FlightRecorder(size_t capacity)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("FlightRecorder: capacity must be non-zero");
+    }
+
+    size_t rounded = 1;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    records_ = std::make_unique<FlightRecord[]>(rounded);
+    mask_ = rounded - 1;
+}
+
+const char* to_string(FlightRecord::Kind kind) {
+    switch (kind) {
+        case FlightRecord::Kind::Add: return "ADD";
+        case FlightRecord::Kind::Cancel: return "CANCEL";
+        case FlightRecord::Kind::Reduce: return "REDUCE";
+        case FlightRecord::Kind::Execute: return "EXECUTE";
+        case FlightRecord::Kind::Replace: return "REPLACE";
+        case FlightRecord::Kind::Trade: return "TRADE";
+        case FlightRecord::Kind::InvariantFailure: return "INVARIANT";
+    }
+    return "?";
+}
+
+void FlightRecorder::dump(std::ostream& out, const std::string& label) const {
+    out << "=== flight recorder: " << label << " (" << size() << " of "
+        << total_recorded() << " entries) ===\n";
+
+    for (size_t i = 0; i < size(); ++i) {
+        const FlightRecord& r = at(i);
+        bool output = r.kind == FlightRecord::Kind::Trade || r.kind == FlightRecord::Kind::InvariantFailure;
+
+        out << "tsc=" << r.tsc << (output ? " OUT " : " IN  ")
+            << std::left << std::setw(10) << to_string(r.kind) << std::right;
+
+        switch (r.kind) {
+            case FlightRecord::Kind::Add:
+                out << " id=" << r.id << " side=" << (r.side == OrderSide::Buy ? 'B' : 'S')
+                    << " px=" << std::fixed << std::setprecision(4) << r.price << " qty=" << r.quantity;
+                break;
+            case FlightRecord::Kind::Cancel:
+                out << " id=" << r.id;
+                break;
+            case FlightRecord::Kind::Reduce:
+            case FlightRecord::Kind::Execute:
+                out << " id=" << r.id << " qty=" << r.quantity;
+                break;
+            case FlightRecord::Kind::Replace:
+                out << " old=" << r.id << " new=" << r.other_id
+                    << " px=" << std::fixed << std::setprecision(4) << r.price << " qty=" << r.quantity;
+                break;
+            case FlightRecord::Kind::Trade:
+                out << " taker=" << r.other_id << " maker=" << r.id
+                    << " px=" << std::fixed << std::setprecision(4) << r.price << " qty=" << r.quantity;
+                break;
+            case FlightRecord::Kind::InvariantFailure:
+                break;
+        }
+        out << "\n";
+    }
+    out.flush();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Order.h"
+#include "Tsc.h"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// One entry in the flight recorder: either an input command or a resulting
+// event, stored as raw fields so recording is a handful of stores.
+struct FlightRecord {
+    enum class Kind : uint8_t {
+        Add,
+        Cancel,
+        Reduce,
+        Execute,
+        Replace,
+        Trade,
+        InvariantFailure
+    };
+
+    uint64_t tsc;
+    int64_t id;         // order id (maker id for trades)
+    int64_t other_id;   // new id for replaces, taker id for trades
+    double price;
+    int32_t quantity;
+    Kind kind;
+    OrderSide side;
+};
+
+// Fixed-size circular log of the most recent engine inputs and outputs. The
+// buffer is allocated once up front; record() never allocates and overwrites
+// the oldest entry once full.
+class FlightRecorder
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit FlightRecorder(size_t capacity);
+
+    void record(FlightRecord::Kind kind, int64_t id, int64_t other_id, double price, int32_t quantity,
+                OrderSide side = OrderSide::Buy)
+    {
+        FlightRecord &r = records_[head_ & mask_];
+        r.tsc = read_tsc();
+        r.id = id;
+        r.other_id = other_id;
+        r.price = price;
+        r.quantity = quantity;
+        r.kind = kind;
+        r.side = side;
+        ++head_;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+    size_t size() const { return head_ < capacity() ? head_ : capacity(); }
+    uint64_t total_recorded() const { return head_; }
+
+    // i = 0 is the oldest retained entry
+    const FlightRecord &at(size_t i) const { return records_[(head_ - size() + i) & mask_]; }
+
+    void clear() { head_ = 0; }
+
+    // Writes the retained entries, oldest first, one per line
+    void dump(std::ostream &out, const std::string &label) const;
+
+private:
+    std::unique_ptr<FlightRecord[]> records_;
+    size_t mask_;
+    uint64_t head_ = 0;
+};
+
+const char *to_string(FlightRecord::Kind kind);
@@ -0,0 +1,79 @@
+#include "LifecycleReport.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+
+void write_histogram(std::ostream& out, const char* name, const Log2Histogram& h) {
+    out << "\"" << name << "\": {\"count\": " << h.total
+        << ", \"p50\": " << h.quantile(0.50)
+        << ", \"p90\": " << h.quantile(0.90)
+        << ", \"p99\": " << h.quantile(0.99)
+        << ", \"max\": " << h.max
+        << ", \"log2_buckets\": [";
+    // trailing empty buckets are dropped; bucket k covers [2^(k-1), 2^k)
+    size_t used = Log2Histogram::BUCKETS;
+    while (used > 0 && h.counts[used - 1] == 0) --used;
+    for (size_t k = 0; k < used; ++k)
+        out << (k ? ", " : "") << h.counts[k];
+    out << "]}";
+}
+
+} // namespace
+
+void LifecycleReport::track(const std::string& symbol, const MatchingEngine* engine) {
+    engines_.push_back({symbol, engine});
+}
+
+void LifecycleReport::write(const std::string& path) const {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("LifecycleReport: cannot open " + tmp);
+        }
+        write_json(out);
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("LifecycleReport: cannot replace " + path);
+    }
+}
+
+void LifecycleReport::write_json(std::ostream& out) const {
+    out << "{\n  \"books\": [";
+    bool first = true;
+    for (const auto& t : engines_) {
+        const OrderLifecycleStats* l = t.engine->lifecycle_stats();
+        if (!l) continue;
+        const BookStats s = t.engine->stats();
+
+        out << (first ? "\n" : ",\n")
+            << "    {\"symbol\": \"" << t.symbol << "\""
+            << ", \"adds\": " << s.adds
+            << ", \"cancels\": " << s.cancels
+            << ", \"replaces\": " << s.replaces
+            << ", \"cancel_to_add\": " << std::fixed << std::setprecision(4)
+            << (s.adds ? static_cast<double>(s.cancels + s.replaces) / s.adds : 0.0)
+            << ", \"filled_on_arrival\": " << l->filled_on_arrival
+            << ", \"fully_filled\": " << l->fully_filled
+            << ", \"cancelled_unfilled\": " << l->cancelled_unfilled
+            << ", \"cancelled_partial\": " << l->cancelled_partial
+            << ", \"replaced\": " << l->replaced
+            << ", \"fill_ratio_deciles\": [";
+        for (size_t d = 0; d < l->fill_ratio_deciles.size(); ++d)
+            out << (d ? ", " : "") << l->fill_ratio_deciles[d];
+        out << "],\n     ";
+        write_histogram(out, "filled_lifetime_ns", l->filled_lifetime_ns);
+        out << ",\n     ";
+        write_histogram(out, "cancelled_lifetime_ns", l->cancelled_lifetime_ns);
+        out << ",\n     ";
+        write_histogram(out, "time_to_first_fill_ns", l->time_to_first_fill_ns);
+        out << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+}
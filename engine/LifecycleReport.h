@@ -0,0 +1,29 @@
+#pragma once
+
+#include "MatchingEngine.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// End-of-run order lifecycle report: per symbol, how orders left the book
+// (filled, cancelled, replaced), their lifetimes and time to first fill as
+// log2-bucketed histograms, fill ratios and the cancel-to-add ratio. Reads
+// the stats each engine gathered inline (MatchingEngine::enable_lifecycle_stats),
+// so producing it costs nothing beyond the replay itself.
+class LifecycleReport
+{
+public:
+    void track(const std::string &symbol, const MatchingEngine *engine);
+
+    // JSON, replaced atomically like the stats file
+    void write(const std::string &path) const;
+    void write_json(std::ostream &out) const;
+
+private:
+    struct Tracked {
+        std::string symbol;
+        const MatchingEngine *engine;
+    };
+
+    std::vector<Tracked> engines_;
+};
@@ -4,37 +4,171 @@
 // --- Public API ---
 void MatchingEngine::submitLimit(int64_t order_id, OrderSide side, double price, int32_t qty)
 {
+    if (recorder_)
+        recorder_->record(FlightRecord::Kind::Add, order_id, 0, price, qty, side);
+
     // Forward the order to the LOB, passing the trade callback
     book_->process_order(order_id, price, qty, side,
-                        [&](const Order &taker, const Order &maker, double trade_price, int32_t trade_qty)
+                        [this](const Order &taker, const Order &maker, double trade_price, int32_t trade_qty)
                         {
-                            if (onTrade_)
-                            {
-                                TradeEvent ev{taker.order_id, maker.order_id, trade_price, trade_qty};
-                                onTrade_(ev);
-                            }
+                            on_book_trade(taker, maker, trade_price, trade_qty);
                         });
+    after_command();
 }
 
 void MatchingEngine::cancel(int64_t order_id)
 {
+    if (recorder_)
+        recorder_->record(FlightRecord::Kind::Cancel, order_id, 0, 0.0, 0);
+
     book_->cancel_order(order_id);
+    after_command();
 }
 
 void MatchingEngine::reduce_order(int64_t order_id, int32_t cancelled_shares)
 {
+    if (recorder_)
+        recorder_->record(FlightRecord::Kind::Reduce, order_id, 0, 0.0, cancelled_shares);
+
     book_->reduce_order(order_id, cancelled_shares);
+    after_command();
+}
+
+void MatchingEngine::execute(int64_t order_id, int32_t executed_shares)
+{
+    if (recorder_)
+        recorder_->record(FlightRecord::Kind::Execute, order_id, 0, 0.0, executed_shares);
+
+    book_->execute_order(order_id, executed_shares);
+    after_command();
 }
 
 void MatchingEngine::order_replace(int64_t old_order_id, int64_t new_order_id, double price, int32_t qty) {
-    auto side_opt = book_->get_side(old_order_id);
-    if (!side_opt.has_value()) {
-        return;
+    if (recorder_)
+        recorder_->record(FlightRecord::Kind::Replace, old_order_id, new_order_id, price, qty);
+
+    book_->replace_order(old_order_id, new_order_id, price, qty,
+                        [this](const Order &taker, const Order &maker, double trade_price, int32_t trade_qty)
+                        {
+                            on_book_trade(taker, maker, trade_price, trade_qty);
+                        });
+    after_command();
+}
+
+void MatchingEngine::apply(const EngineCommand &cmd)
+{
+    book_->set_time(cmd.timestamp);
+    switch (cmd.type)
+    {
+    case CommandType::Add:
+        submitLimit(cmd.order_id, cmd.order_side(), cmd.price_value(), cmd.quantity);
+        break;
+    case CommandType::Cancel:
+        cancel(cmd.order_id);
+        break;
+    case CommandType::Reduce:
+        reduce_order(cmd.order_id, cmd.quantity);
+        break;
+    case CommandType::Execute:
+        execute(cmd.order_id, cmd.quantity);
+        break;
+    case CommandType::Replace:
+        order_replace(cmd.order_id, cmd.new_order_id, cmd.price_value(), cmd.quantity);
+        break;
     }
+}
 
-    OrderSide old_side = side_opt.value();
-    book_->cancel_order(old_order_id);
+void MatchingEngine::apply_batch(const EngineCommand *cmds, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        apply(cmds[i]);
+}
 
-    submitLimit(new_order_id, old_side, price, qty);
+void MatchingEngine::setSweepCallback(SweepCallback cb, bool per_level)
+{
+    onSweep_ = std::move(cb);
+    sweep_per_level_ = per_level;
+    if (per_level)
+        sweep_levels_.reserve(64);
+}
 
-}
\ No newline at end of file
+void MatchingEngine::setBboCallback(BboCallback cb)
+{
+    onBbo_ = std::move(cb);
+    // changes are reported relative to the book as it stands now
+    last_bbo_ = BboEvent{book_->get_best_bid(), book_->get_best_ask()};
+}
+
+// --- Internals ---
+void MatchingEngine::on_book_trade(const Order &taker, const Order &maker, double trade_price, int32_t trade_qty)
+{
+    if (recorder_)
+        recorder_->record(FlightRecord::Kind::Trade, maker.order_id, taker.order_id, trade_price, trade_qty, maker.side);
+
+    if (onTrade_)
+    {
+        TradeEvent ev{taker.order_id, maker.order_id, trade_price, trade_qty};
+        onTrade_(ev);
+    }
+
+    if (onSweep_)
+    {
+        // a command has at most one taker, so fills only ever extend the sweep
+        if (sweep_.fills == 0)
+        {
+            sweep_.taker_id = taker.order_id;
+            sweep_.taker_side = taker.side;
+            sweep_.first_price = trade_price;
+        }
+        if (sweep_.fills == 0 || trade_price != sweep_.last_price)
+        {
+            ++sweep_.levels;
+            if (sweep_per_level_)
+                sweep_levels_.push_back({trade_price, 0, 0});
+        }
+        if (sweep_per_level_)
+        {
+            sweep_levels_.back().quantity += trade_qty;
+            ++sweep_levels_.back().fills;
+        }
+        sweep_.last_price = trade_price;
+        sweep_.quantity += trade_qty;
+        sweep_notional_ += trade_price * trade_qty;
+        ++sweep_.fills;
+    }
+}
+
+void MatchingEngine::emit_sweep()
+{
+    sweep_.vwap = sweep_notional_ / sweep_.quantity;
+    sweep_.by_level = sweep_levels_;
+    onSweep_(sweep_);
+
+    sweep_ = SweepEvent{};
+    sweep_notional_ = 0.0;
+    sweep_levels_.clear();
+}
+
+void MatchingEngine::emit_bbo_if_changed()
+{
+    const BboEvent now{book_->get_best_bid(), book_->get_best_ask()};
+    auto same = [](const LimitOrderBook::BestLevel &a, const LimitOrderBook::BestLevel &b)
+    {
+        return a.valid == b.valid && a.price == b.price && a.quantity == b.quantity;
+    };
+    if (same(now.bid, last_bbo_.bid) && same(now.ask, last_bbo_.ask))
+        return;
+
+    last_bbo_ = now;
+    onBbo_(now);
+}
+
+void MatchingEngine::verify_top_of_book()
+{
+    if (const char* violation = book_->check_top_of_book())
+    {
+        if (recorder_)
+            recorder_->record(FlightRecord::Kind::InvariantFailure, 0, 0, 0.0, 0);
+        onInvariant_(*this, violation);
+    }
+}
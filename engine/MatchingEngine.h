@@ -1,9 +1,13 @@
 #pragma once
 
 #include "LimitOrderBook.h"
+#include "FlightRecorder.h"
+#include "EngineCommand.h"
 #include <functional>
 #include <cstdint>
 #include <memory>
+#include <span>
+#include <vector>
 
 struct TradeEvent {
     int64_t taker_id;
@@ -12,22 +16,109 @@ struct TradeEvent {
     int32_t quantity;
 };
 
+// Fills of one sweep at a single price
+struct SweepLevel {
+    double   price;
+    int32_t  quantity;
+    uint32_t fills;
+};
+
+// Every fill of one taker order within one command, summed
+struct SweepEvent {
+    int64_t   taker_id;
+    OrderSide taker_side;
+    int32_t   quantity;         // shares filled in total
+    double    vwap;
+    double    first_price;
+    double    last_price;
+    uint32_t  fills;            // resting orders hit
+    uint32_t  levels;           // price levels touched
+    // Per-level breakdown in fill order; empty unless requested. Valid only
+    // during the callback.
+    std::span<const SweepLevel> by_level;
+};
+
+// Top of book after a command that changed it
+struct BboEvent {
+    LimitOrderBook::BestLevel bid;
+    LimitOrderBook::BestLevel ask;
+};
+
 class MatchingEngine {
 public:
     using TradeCallback = std::function<void(const TradeEvent&)>;
+    using SweepCallback = std::function<void(const SweepEvent&)>;
+    using BboCallback = std::function<void(const BboEvent&)>;
+    // Invoked with a description when the post-command top-of-book check fails
+    using InvariantCallback = std::function<void(MatchingEngine&, const char*)>;
 
     explicit MatchingEngine(std::unique_ptr<LimitOrderBook> book)
         : book_(std::move(book)) {};
 
     void setTradeCallback(TradeCallback cb) { onTrade_ = std::move(cb); }
+    // Conflated output: at most one sweep event and one BBO event per command,
+    // however many resting orders the command filled. Independent of the
+    // per-fill trade callback.
+    void setSweepCallback(SweepCallback cb, bool per_level = false);
+    void setBboCallback(BboCallback cb);
+    // Setting a callback turns on an O(1) top-of-book check after every command
+    void setInvariantCallback(InvariantCallback cb) { onInvariant_ = std::move(cb); }
+
+    // Keeps the last `capacity` inputs and trades in a circular log
+    void enable_flight_recorder(size_t capacity) { recorder_ = std::make_unique<FlightRecorder>(capacity); }
+    const FlightRecorder* flight_recorder() const { return recorder_.get(); }
+
+    // Per-order lifetimes, time to first fill and fill ratios, stamped with
+    // the exchange time of each applied command (see LimitOrderBook)
+    void enable_lifecycle_stats() { book_->enable_lifecycle_stats(); }
+    const OrderLifecycleStats* lifecycle_stats() const { return book_->lifecycle_stats(); }
+
+    // Publishes the top `depth` levels after every command for lock-free
+    // readers on other threads (LimitOrderBook::read_depth)
+    void enable_published_depth(size_t depth) { book_->enable_published_depth(depth); }
 
     void submitLimit(int64_t order_id, OrderSide side, double price, int32_t qty);
     void cancel(int64_t order_id);
     void reduce_order(int64_t order_id, int32_t cancelled_shares);
+    void execute(int64_t order_id, int32_t executed_shares);
     void order_replace(int64_t old_order_id, int64_t new_order_id, double price, int32_t qty);
+
+    // Applies one pre-decoded command; same effect as the matching call above,
+    // with the book clock set to the command's timestamp
+    void apply(const EngineCommand &cmd);
+    // Applies a run of commands for this engine back to back
+    void apply_batch(const EngineCommand *cmds, size_t count);
     std::unique_ptr<LimitOrderBook>& get_book() { return book_; };
+    BookStats stats() const { return book_->get_stats(); }
 
 private:
+    void on_book_trade(const Order &taker, const Order &maker, double trade_price, int32_t trade_qty);
+    void after_command()
+    {
+        if (sweep_.fills)
+            emit_sweep();
+        if (onBbo_)
+            emit_bbo_if_changed();
+        if (onInvariant_)
+            verify_top_of_book();
+        book_->publish_depth();
+    }
+    void emit_sweep();
+    void emit_bbo_if_changed();
+    void verify_top_of_book();
+
     std::unique_ptr<LimitOrderBook> book_;
     TradeCallback onTrade_;
+    InvariantCallback onInvariant_;
+    std::unique_ptr<FlightRecorder> recorder_;
+
+    // fills of the current command, flushed by after_command()
+    SweepCallback onSweep_;
+    bool sweep_per_level_ = false;
+    SweepEvent sweep_{};
+    double sweep_notional_ = 0.0;
+    std::vector<SweepLevel> sweep_levels_;
+
+    BboCallback onBbo_;
+    BboEvent last_bbo_{};
 };
@@ -0,0 +1,109 @@
+#include "StatsReporter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+StatsReporter::StatsReporter(std::string path, std::chrono::milliseconds interval)
+    : path_(std::move(path)), interval_(interval),
+      started_(std::chrono::steady_clock::now()), last_write_(started_)
+{
+    const std::string ext = ".json";
+    bool is_json = path_.size() >= ext.size() &&
+                   path_.compare(path_.size() - ext.size(), ext.size(), ext) == 0;
+    format_ = is_json ? Format::Json : Format::Text;
+}
+
+void StatsReporter::track(uint16_t locate, const std::string& symbol, const MatchingEngine* engine) {
+    engines_.push_back({locate, symbol, engine});
+}
+
+void StatsReporter::maybe_write() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_write_ >= interval_) {
+        write();
+    }
+}
+
+void StatsReporter::write() {
+    last_write_ = std::chrono::steady_clock::now();
+
+    const std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("StatsReporter: cannot open " + tmp);
+        }
+        if (format_ == Format::Json) write_json(out);
+        else write_text(out);
+    }
+
+    if (std::rename(tmp.c_str(), path_.c_str()) != 0) {
+        throw std::runtime_error("StatsReporter: cannot replace " + path_);
+    }
+}
+
+void StatsReporter::write_json(std::ostream& out) const {
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(last_write_ - started_).count();
+
+    out << "{\n  \"elapsed_ms\": " << elapsed_ms << ",\n  \"books\": [";
+    for (size_t i = 0; i < engines_.size(); ++i) {
+        const auto& t = engines_[i];
+        BookStats s = t.engine->stats();
+
+        out << (i ? ",\n" : "\n")
+            << "    {\"symbol\": \"" << t.symbol << "\", \"locate\": " << t.locate
+            << ", \"adds\": " << s.adds
+            << ", \"cancels\": " << s.cancels
+            << ", \"reduces\": " << s.reduces
+            << ", \"replaces\": " << s.replaces
+            << ", \"fills\": " << s.fills
+            << ", \"filled_quantity\": " << s.filled_quantity
+            << ", \"matches\": " << s.matches
+            << ", \"levels_crossed\": " << s.levels_crossed
+            << ", \"max_levels_crossed\": " << s.max_levels_crossed
+            << ", \"max_queue_depth\": " << s.max_queue_depth
+            << ", \"pool_capacity\": " << s.pool_capacity
+            << ", \"pool_in_use\": " << s.pool_in_use
+            << ", \"pool_high_water\": " << s.pool_high_water
+            << ", \"id_index_size\": " << s.id_index_size
+            << ", \"id_index_buckets\": " << s.id_index_buckets
+            << ", \"id_index_load\": " << std::fixed << std::setprecision(4) << s.id_index_load
+            << ", \"active_bid_levels\": " << s.active_bid_levels
+            << ", \"active_ask_levels\": " << s.active_ask_levels
+            << ", \"ladder_bytes\": " << s.ladder_bytes
+            << ", \"pool_bytes\": " << s.pool_bytes
+            << ", \"id_index_bytes\": " << s.id_index_bytes
+            << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void StatsReporter::write_text(std::ostream& out) const {
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(last_write_ - started_).count();
+
+    out << "elapsed_ms " << elapsed_ms << "\n\n";
+    out << std::left
+        << std::setw(8) << "SYMBOL"
+        << std::setw(12) << "ADDS" << std::setw(12) << "CANCELS" << std::setw(12) << "REDUCES"
+        << std::setw(12) << "REPLACES" << std::setw(12) << "FILLS"
+        << std::setw(10) << "AVG_LVLS" << std::setw(10) << "MAX_LVLS" << std::setw(10) << "MAX_QUEUE"
+        << std::setw(12) << "POOL_HWM" << std::setw(10) << "ID_LOAD"
+        << std::setw(12) << "LADDER_MB" << std::setw(10) << "POOL_MB" << "\n";
+
+    for (const auto& t : engines_) {
+        BookStats s = t.engine->stats();
+        double avg_levels = s.matches ? static_cast<double>(s.levels_crossed) / s.matches : 0.0;
+
+        out << std::left << std::setw(8) << t.symbol
+            << std::setw(12) << s.adds << std::setw(12) << s.cancels << std::setw(12) << s.reduces
+            << std::setw(12) << s.replaces << std::setw(12) << s.fills
+            << std::fixed << std::setprecision(2)
+            << std::setw(10) << avg_levels << std::setw(10) << s.max_levels_crossed
+            << std::setw(10) << s.max_queue_depth << std::setw(12) << s.pool_high_water
+            << std::setw(10) << s.id_index_load
+            << std::setw(12) << s.ladder_bytes / (1024.0 * 1024.0)
+            << std::setw(10) << s.pool_bytes / (1024.0 * 1024.0) << "\n";
+    }
+}
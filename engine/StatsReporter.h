@@ -0,0 +1,54 @@
+#pragma once
+
+#include "MatchingEngine.h"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Periodically dumps per-book counters and memory accounting to a file. It
+// runs on the replay thread between messages, so reading the books needs no
+// synchronisation; the file is replaced atomically (write + rename) so other
+// processes can poll it at any time.
+class StatsReporter
+{
+public:
+    enum class Format { Text, Json };
+
+    // Format is chosen from the extension: ".json" -> Json, anything else -> Text
+    StatsReporter(std::string path, std::chrono::milliseconds interval);
+
+    void track(uint16_t locate, const std::string &symbol, const MatchingEngine *engine);
+
+    // Call once per message; only looks at the clock every CHECK_EVERY calls
+    void tick()
+    {
+        if (++ticks_ % CHECK_EVERY == 0)
+            maybe_write();
+    }
+
+    void write();
+
+    void write_json(std::ostream &out) const;
+    void write_text(std::ostream &out) const;
+
+private:
+    static constexpr uint64_t CHECK_EVERY = 4096;
+
+    struct Tracked {
+        uint16_t locate;
+        std::string symbol;
+        const MatchingEngine *engine;
+    };
+
+    void maybe_write();
+
+    std::string path_;
+    Format format_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point last_write_;
+    uint64_t ticks_ = 0;
+    std::vector<Tracked> engines_;
+};
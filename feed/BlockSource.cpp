@@ -0,0 +1,472 @@
+#include "BlockSource.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#ifdef ORDERBOOK_HAVE_ZLIB
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <zlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// --- PipelinedSource ---
+
+PipelinedSource::PipelinedSource(std::unique_ptr<BlockProducer> producer, size_t block_size, size_t ring_blocks)
+    : producer_(std::move(producer)), ring_(ring_blocks)
+{
+    if (block_size == 0 || ring_blocks < 2) {
+        throw std::invalid_argument("PipelinedSource: need a non-empty block and at least two ring slots");
+    }
+    for (auto& slot : ring_) {
+        slot.data.resize(block_size);
+    }
+    worker_ = std::thread(&PipelinedSource::run, this);
+}
+
+PipelinedSource::~PipelinedSource() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    not_full_.notify_all();
+    worker_.join();
+}
+
+std::span<const char> PipelinedSource::next_block() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (holding_) {
+        holding_ = false;
+        ++read_index_;
+        --filled_;
+        not_full_.notify_one();
+    }
+
+    not_empty_.wait(lock, [this] { return filled_ > 0 || eof_; });
+
+    if (filled_ > 0) {
+        holding_ = true;
+        const Slot& slot = ring_[read_index_ % ring_.size()];
+        return {slot.data.data(), slot.size};
+    }
+
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    return {};
+}
+
+void PipelinedSource::run() {
+    try {
+        while (true) {
+            Slot* slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_full_.wait(lock, [this] { return filled_ < ring_.size() || stop_; });
+                if (stop_) return;
+                slot = &ring_[write_index_ % ring_.size()];
+            }
+
+            // fill the whole block so the consumer sees few, large handoffs
+            size_t size = 0;
+            while (size < slot->data.size()) {
+                size_t n = producer_->fill(slot->data.data() + size, slot->data.size() - size);
+                if (n == 0) break;
+                size += n;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (size > 0) {
+                slot->size = size;
+                ++write_index_;
+                ++filled_;
+            }
+            if (size < slot->data.size()) {
+                eof_ = true;
+            }
+            not_empty_.notify_one();
+            if (eof_) return;
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        eof_ = true;
+        not_empty_.notify_one();
+    }
+}
+
+// --- FileProducer ---
+
+FileProducer::FileProducer(const std::string& path)
+    : file_(std::fopen(path.c_str(), "rb"))
+{
+    if (!file_) {
+        throw std::runtime_error("cannot open " + path);
+    }
+}
+
+FileProducer::~FileProducer() {
+    std::fclose(file_);
+}
+
+size_t FileProducer::fill(char* dst, size_t capacity) {
+    size_t n = std::fread(dst, 1, capacity, file_);
+    if (n == 0 && std::ferror(file_)) {
+        throw std::runtime_error("read error");
+    }
+    return n;
+}
+
+// --- GzipProducer ---
+
+#ifdef ORDERBOOK_HAVE_ZLIB
+
+namespace {
+
+// Compressed bytes scanned for member headers ahead of the reader
+constexpr size_t SCAN_AHEAD = 16 << 20;
+// Largest member a pool thread holds in memory; bigger ones are streamed
+constexpr size_t MAX_MEMBER_OUTPUT = 64 << 20;
+// zlib counts input in uInt
+constexpr size_t MAX_INPUT_CHUNK = 1 << 30;
+
+// Offsets in [from, to) that could start a gzip member: magic, deflate and
+// no reserved flag bits
+void scan_member_headers(const unsigned char* data, size_t size, size_t from, size_t to,
+                         std::vector<size_t>& out) {
+    to = std::min(to, size >= 10 ? size - 9 : 0);
+    while (from < to) {
+        const void* hit = std::memchr(data + from, 0x1f, to - from);
+        if (!hit) return;
+        const size_t at = static_cast<const unsigned char*>(hit) - data;
+        if (data[at + 1] == 0x8b && data[at + 2] == 8 && (data[at + 3] & 0xe0) == 0) out.push_back(at);
+        from = at + 1;
+    }
+}
+
+// Inflates one whole gzip member starting at `data` into `out`. False if
+// the bytes are not a valid member (bad header, data or CRC) or if it would
+// inflate to more than `limit` bytes; otherwise `consumed` is its
+// compressed size.
+bool inflate_member(const unsigned char* data, size_t size, size_t limit, std::vector<char>& out,
+                    size_t& consumed) {
+    z_stream zs{};
+    if (inflateInit2(&zs, 15 + 16) != Z_OK) return false;
+
+    zs.next_in = const_cast<Bytef*>(data);
+    size_t fed = 0, produced = 0;
+    bool ok = false;
+    out.clear();
+    while (true) {
+        if (zs.avail_in == 0) {
+            if (fed == size) break;
+            const size_t n = std::min(size - fed, MAX_INPUT_CHUNK);
+            zs.avail_in = static_cast<uInt>(n);
+            fed += n;
+        }
+        if (produced == out.size()) {
+            if (out.size() >= limit) break;
+            out.resize(std::min(std::max<size_t>(2 * out.size(), 1 << 20), limit));
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(out.data() + produced);
+        zs.avail_out = static_cast<uInt>(out.size() - produced);
+        const int rc = inflate(&zs, Z_NO_FLUSH);
+        produced = out.size() - zs.avail_out;
+        if (rc == Z_STREAM_END) {
+            ok = true;
+            break;
+        }
+        if (rc != Z_OK && rc != Z_BUF_ERROR) break;
+    }
+    consumed = static_cast<size_t>(zs.total_in);
+    inflateEnd(&zs);
+    out.resize(produced);
+    return ok;
+}
+
+} // namespace
+
+struct GzipProducer::State {
+    std::FILE* file = nullptr;
+    z_stream stream{};
+    std::vector<unsigned char> input = std::vector<unsigned char>(1 << 20);
+    bool input_eof = false;
+    bool done = false;
+
+    // Parallel members (threads > 1). `stream` then reads from the mapping
+    // and only inflates members the pool could not take.
+    struct Member {
+        bool ok = false;
+        std::vector<char> output;
+        size_t consumed = 0;
+    };
+    const unsigned char* map = nullptr;
+    size_t map_size = 0;
+    size_t pos = 0;                     // compressed offset of the next member to hand out
+    size_t scanned_to = 0;
+    bool streaming = false;             // `stream` is inflating the member at `pos`
+    size_t stream_fed = 0;              // compressed bytes given to `stream` so far
+    std::vector<char> current;          // inflated member being handed out
+    size_t current_offset = 0;
+
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable member_done;
+    std::vector<size_t> candidates;     // scanned header offsets, ascending
+    size_t next_job = 0;                // first candidate no thread has taken
+    size_t next_member = 0;             // first candidate not yet handed out or skipped
+    size_t window = 0;                  // candidates in flight ahead of next_member
+    std::map<size_t, Member> finished;  // by candidate index
+    size_t awaited = SIZE_MAX;          // candidate the reader is waiting on
+    bool stop = false;
+    std::vector<std::thread> pool;
+
+    bool refill_input() {
+        if (input_eof) return false;
+        size_t n = std::fread(input.data(), 1, input.size(), file);
+        if (n == 0) {
+            if (std::ferror(file)) throw std::runtime_error("gzip: read error");
+            input_eof = true;
+            return false;
+        }
+        stream.next_in = input.data();
+        stream.avail_in = static_cast<uInt>(n);
+        return true;
+    }
+
+    bool refill_mapped() {
+        if (stream_fed == map_size - pos) return false;
+        const size_t n = std::min(map_size - pos - stream_fed, MAX_INPUT_CHUNK);
+        stream.next_in = const_cast<Bytef*>(map + pos + stream_fed);
+        stream.avail_in = static_cast<uInt>(n);
+        stream_fed += n;
+        return true;
+    }
+
+    void run_pool() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            // candidates behind next_member were handed out or skipped
+            auto next = [this] { return std::max(next_job, next_member); };
+            work_ready.wait(lock, [&] {
+                return stop || (next() < candidates.size() && next() < next_member + window);
+            });
+            if (stop) return;
+
+            const size_t index = next();
+            next_job = index + 1;
+            const size_t start = candidates[index];
+            lock.unlock();
+
+            Member member;
+            try {
+                member.ok = inflate_member(map + start, map_size - start, MAX_MEMBER_OUTPUT, member.output,
+                                           member.consumed);
+            } catch (const std::bad_alloc&) {
+                member = Member{};     // the reader streams it instead
+            }
+
+            lock.lock();
+            // drop it if the reader already moved past it (a false header)
+            if (index >= next_member || index == awaited) finished[index] = std::move(member);
+            member_done.notify_all();
+        }
+    }
+
+    // Picks how the member at `pos` is inflated: a pool result when a
+    // candidate sits there, otherwise (or if the pool gave up) on `stream`
+    void next_mapped_member() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        scan_member_headers(map, map_size, std::max(scanned_to, pos), pos + SCAN_AHEAD, candidates);
+        scanned_to = std::max(scanned_to, std::min(pos + SCAN_AHEAD, map_size));
+
+        // candidates inside members already handed out were false headers
+        while (next_member < candidates.size() && candidates[next_member] < pos)
+            finished.erase(next_member++);
+
+        // wait only for a member a pool thread has started; one it has not
+        // (the first one, or the one member of a plain gzip file) is
+        // inflated here, and moving next_member past it keeps the pool off it
+        const bool at_pos = next_member < candidates.size() && candidates[next_member] == pos;
+        const bool pooled = at_pos && next_job > next_member;
+        if (at_pos) ++next_member;
+        work_ready.notify_all();
+
+        if (pooled) {
+            awaited = next_member - 1;
+            member_done.wait(lock, [this] { return finished.count(awaited) > 0; });
+            Member member = std::move(finished[awaited]);
+            finished.erase(awaited);
+            awaited = SIZE_MAX;
+            if (member.ok) {
+                current = std::move(member.output);
+                current_offset = 0;
+                pos += member.consumed;
+                return;
+            }
+        }
+
+        inflateReset(&stream);
+        stream.avail_in = 0;
+        stream_fed = 0;
+        streaming = true;
+    }
+
+    size_t fill_mapped(char* dst, size_t capacity) {
+        size_t written = 0;
+        while (written < capacity) {
+            if (current_offset < current.size()) {
+                const size_t n = std::min(capacity - written, current.size() - current_offset);
+                std::memcpy(dst + written, current.data() + current_offset, n);
+                current_offset += n;
+                written += n;
+                continue;
+            }
+            if (!streaming) {
+                if (pos >= map_size) {
+                    done = true;
+                    break;
+                }
+                next_mapped_member();
+                continue;
+            }
+
+            if (stream.avail_in == 0 && !refill_mapped()) {
+                throw std::runtime_error("gzip: truncated stream");
+            }
+            stream.next_out = reinterpret_cast<Bytef*>(dst + written);
+            stream.avail_out = static_cast<uInt>(capacity - written);
+            const int rc = inflate(&stream, Z_NO_FLUSH);
+            written = capacity - stream.avail_out;
+            if (rc == Z_STREAM_END) {
+                pos += stream_fed - stream.avail_in;
+                streaming = false;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                throw std::runtime_error(std::string("gzip: inflate failed: ") +
+                                         (stream.msg ? stream.msg : "unknown error"));
+            }
+        }
+        return written;
+    }
+};
+
+GzipProducer::GzipProducer(const std::string& path, size_t threads)
+    : state_(std::make_unique<State>())
+{
+    State& s = *state_;
+    s.file = std::fopen(path.c_str(), "rb");
+    if (!s.file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    // 15 window bits + 32: accept gzip or zlib headers
+    if (inflateInit2(&s.stream, 15 + 32) != Z_OK) {
+        std::fclose(s.file);
+        throw std::runtime_error("gzip: inflateInit2 failed");
+    }
+    if (threads < 2) return;
+
+    struct stat st;
+    if (::fstat(::fileno(s.file), &st) == 0 && st.st_size > 0) {
+        void* map = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, ::fileno(s.file), 0);
+        if (map != MAP_FAILED) {
+            ::madvise(map, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            s.map = static_cast<const unsigned char*>(map);
+            s.map_size = static_cast<size_t>(st.st_size);
+        }
+    }
+    if (!s.map) return;     // not mappable: inflate on the reader thread
+
+    // two members per thread in flight keeps the pool busy while the
+    // reader copies one out
+    s.window = 2 * threads;
+    for (size_t i = 0; i < threads; ++i) {
+        s.pool.emplace_back(&State::run_pool, &s);
+    }
+}
+
+GzipProducer::~GzipProducer() {
+    State& s = *state_;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.stop = true;
+    }
+    s.work_ready.notify_all();
+    for (auto& thread : s.pool) thread.join();
+    if (s.map) ::munmap(const_cast<unsigned char*>(s.map), s.map_size);
+    inflateEnd(&s.stream);
+    std::fclose(s.file);
+}
+
+size_t GzipProducer::fill(char* dst, size_t capacity) {
+    State& s = *state_;
+    if (s.done) return 0;
+    if (s.map) return s.fill_mapped(dst, capacity);
+
+    s.stream.next_out = reinterpret_cast<Bytef*>(dst);
+    s.stream.avail_out = static_cast<uInt>(capacity);
+
+    while (s.stream.avail_out > 0) {
+        if (s.stream.avail_in == 0 && !s.refill_input()) {
+            throw std::runtime_error("gzip: truncated stream");
+        }
+
+        int rc = inflate(&s.stream, Z_NO_FLUSH);
+        if (rc == Z_STREAM_END) {
+            // end of one member: continue with the next one if there is more input
+            if (s.stream.avail_in == 0 && !s.refill_input()) {
+                s.done = true;
+                break;
+            }
+            inflateReset(&s.stream);
+        } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("gzip: inflate failed: ") +
+                                     (s.stream.msg ? s.stream.msg : "unknown error"));
+        }
+    }
+
+    return capacity - s.stream.avail_out;
+}
+
+#else
+
+struct GzipProducer::State {};
+
+GzipProducer::GzipProducer(const std::string&, size_t) {
+    throw std::runtime_error("gzip input requires building with zlib");
+}
+
+GzipProducer::~GzipProducer() = default;
+
+size_t GzipProducer::fill(char*, size_t) {
+    return 0;
+}
+
+#endif
+
+// --- Factory ---
+
+std::unique_ptr<BlockSource> open_block_source(const std::string& path, size_t block_size, size_t ring_blocks,
+                                               size_t inflate_threads) {
+    unsigned char magic[2] = {0, 0};
+    if (std::FILE* probe = std::fopen(path.c_str(), "rb")) {
+        size_t n = std::fread(magic, 1, sizeof(magic), probe);
+        std::fclose(probe);
+        if (n < sizeof(magic)) magic[0] = magic[1] = 0;
+    } else {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    std::unique_ptr<BlockProducer> producer;
+    if (magic[0] == 0x1f && magic[1] == 0x8b) {
+        producer = std::make_unique<GzipProducer>(path, inflate_threads);
+    } else {
+        producer = std::make_unique<FileProducer>(path);
+    }
+
+    return std::make_unique<PipelinedSource>(std::move(producer), block_size, ring_blocks);
+}
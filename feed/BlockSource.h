@@ -0,0 +1,123 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A byte stream delivered in large blocks. The block returned by
+// next_block() stays valid until the following call, which releases it.
+class BlockSource
+{
+public:
+    virtual ~BlockSource() = default;
+
+    // Empty span at end of stream
+    virtual std::span<const char> next_block() = 0;
+};
+
+// Producer half of a PipelinedSource: writes up to `capacity` bytes of the
+// stream into `dst` and returns how many were written, 0 at end of stream.
+class BlockProducer
+{
+public:
+    virtual ~BlockProducer() = default;
+    virtual size_t fill(char *dst, size_t capacity) = 0;
+};
+
+// Runs a BlockProducer on its own thread, filling a ring of fixed-size
+// buffers ahead of the consumer. Handoff happens once per block (megabytes),
+// so the mutex is never on the per-message path. Exceptions thrown by the
+// producer are rethrown from next_block().
+class PipelinedSource : public BlockSource
+{
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 4 << 20;
+    static constexpr size_t DEFAULT_RING_BLOCKS = 4;
+
+    explicit PipelinedSource(std::unique_ptr<BlockProducer> producer,
+                             size_t block_size = DEFAULT_BLOCK_SIZE,
+                             size_t ring_blocks = DEFAULT_RING_BLOCKS);
+    ~PipelinedSource() override;
+
+    PipelinedSource(const PipelinedSource &) = delete;
+    PipelinedSource &operator=(const PipelinedSource &) = delete;
+
+    std::span<const char> next_block() override;
+
+private:
+    struct Slot {
+        std::vector<char> data;
+        size_t size = 0;
+    };
+
+    void run();
+
+    std::unique_ptr<BlockProducer> producer_;
+    std::vector<Slot> ring_;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    size_t read_index_ = 0;     // consumer position
+    size_t write_index_ = 0;    // producer position
+    size_t filled_ = 0;         // published slots, including the one held by the consumer
+    bool holding_ = false;
+    bool eof_ = false;
+    bool stop_ = false;
+    std::exception_ptr error_;
+
+    std::thread worker_;
+};
+
+// Reads a plain file.
+class FileProducer : public BlockProducer
+{
+public:
+    explicit FileProducer(const std::string &path);
+    ~FileProducer() override;
+
+    size_t fill(char *dst, size_t capacity) override;
+
+private:
+    std::FILE *file_;
+};
+
+// Inflates a gzip file, including files made of several concatenated members.
+// Only available when built with zlib (ORDERBOOK_HAVE_ZLIB).
+//
+// A single deflate stream cannot be split without an index, but the members
+// of a multi-member file (pigz --independent output, concatenated chunks)
+// are independent streams. With threads > 1 the file is mapped, the region
+// ahead of the reader is scanned for member headers, and up to that many
+// members are inflated at once on a pool, then handed out in file order.
+// Header bytes can also occur inside compressed data, so a scanned offset
+// only counts once it inflates to a member with a valid CRC. Members too
+// large to hold, and single-member files, are inflated on the reader thread
+// as with threads == 1.
+class GzipProducer : public BlockProducer
+{
+public:
+    explicit GzipProducer(const std::string &path, size_t threads = 1);
+    ~GzipProducer() override;
+
+    size_t fill(char *dst, size_t capacity) override;
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+// Opens `path` as a pipelined block source, inflating on the reader thread
+// (and `inflate_threads` pool threads, see GzipProducer) when the file starts
+// with the gzip magic bytes.
+std::unique_ptr<BlockSource> open_block_source(const std::string &path,
+                                               size_t block_size = PipelinedSource::DEFAULT_BLOCK_SIZE,
+                                               size_t ring_blocks = PipelinedSource::DEFAULT_RING_BLOCKS,
+                                               size_t inflate_threads = 1);
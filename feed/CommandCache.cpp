@@ -0,0 +1,232 @@
+#include "CommandCache.h"
+#include "ItchDispatcher.h"
+#include "ItchFramer.h"
+#include "ItchPrefilter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace command_cache {
+
+bool is_cache_file(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    char magic[sizeof(MAGIC)] = {};
+    bool match = std::fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                 std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    std::fclose(f);
+    return match;
+}
+
+} // namespace command_cache
+
+// ---------- Writer ----------
+
+CommandCacheWriter::CommandCacheWriter(const std::string& path) : path_(path) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_)
+        throw std::runtime_error("cannot create command cache " + path);
+
+    // placeholder header with a zeroed magic, so an unfinished file is rejected
+    command_cache::Header header{};
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1)
+        throw std::runtime_error("write failed: " + path_);
+    buffer_.reserve(BUFFER_RECORDS);
+}
+
+CommandCacheWriter::~CommandCacheWriter() {
+    if (file_)
+        std::fclose(file_);
+}
+
+void CommandCacheWriter::add_symbol(uint16_t locate, const std::string& symbol) {
+    command_cache::SymbolEntry entry{};
+    entry.locate = locate;
+    std::memset(entry.symbol, ' ', sizeof(entry.symbol));
+    std::memcpy(entry.symbol, symbol.data(), std::min(symbol.size(), sizeof(entry.symbol)));
+    symbols_.push_back(entry);
+}
+
+void CommandCacheWriter::flush() {
+    if (buffer_.empty())
+        return;
+    if (std::fwrite(buffer_.data(), sizeof(EngineCommand), buffer_.size(), file_) != buffer_.size())
+        throw std::runtime_error("write failed: " + path_);
+    written_ += buffer_.size();
+    buffer_.clear();
+}
+
+void CommandCacheWriter::finish(uint64_t source_messages, uint64_t source_bytes) {
+    if (finished_)
+        return;
+    flush();
+
+    command_cache::Header header{};
+    std::memcpy(header.magic, command_cache::MAGIC, sizeof(header.magic));
+    header.version = command_cache::VERSION;
+    header.record_size = sizeof(EngineCommand);
+    header.record_count = written_;
+    header.records_offset = sizeof(header);
+    header.symbols_offset = sizeof(header) + written_ * sizeof(EngineCommand);
+    header.symbol_count = static_cast<uint32_t>(symbols_.size());
+    header.source_messages = source_messages;
+    header.source_bytes = source_bytes;
+
+    if (!symbols_.empty() &&
+        std::fwrite(symbols_.data(), sizeof(command_cache::SymbolEntry), symbols_.size(), file_) != symbols_.size())
+        throw std::runtime_error("write failed: " + path_);
+    if (std::fseek(file_, 0, SEEK_SET) != 0 || std::fwrite(&header, sizeof(header), 1, file_) != 1)
+        throw std::runtime_error("write failed: " + path_);
+    if (std::fclose(file_) != 0) {
+        file_ = nullptr;
+        throw std::runtime_error("write failed: " + path_);
+    }
+    file_ = nullptr;
+    finished_ = true;
+}
+
+// ---------- Reader ----------
+
+CommandCacheReader::CommandCacheReader(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open command cache " + path);
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(header_)) {
+        ::close(fd);
+        throw std::runtime_error("not a command cache: " + path);
+    }
+
+    map_size_ = static_cast<size_t>(st.st_size);
+    map_ = ::mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        throw std::runtime_error("cannot map command cache " + path);
+    }
+    // replay walks the records front to back exactly once; advice values
+    // are not flags, so each needs its own call
+    ::madvise(map_, map_size_, MADV_SEQUENTIAL);
+    ::madvise(map_, map_size_, MADV_WILLNEED);
+
+    const char* base = static_cast<const char*>(map_);
+    std::memcpy(&header_, base, sizeof(header_));
+
+    auto fail = [&](const std::string& why) {
+        ::munmap(map_, map_size_);
+        map_ = nullptr;
+        throw std::runtime_error("invalid command cache " + path + ": " + why);
+    };
+    if (std::memcmp(header_.magic, command_cache::MAGIC, sizeof(header_.magic)) != 0)
+        fail("bad magic (unfinished or not a cache)");
+    if (header_.version != command_cache::VERSION)
+        fail("unsupported version " + std::to_string(header_.version));
+    if (header_.record_size != sizeof(EngineCommand))
+        fail("record size mismatch");
+    // compared as remaining space, so a corrupt count cannot wrap the sums
+    if (header_.records_offset % alignof(EngineCommand) != 0 || header_.records_offset > header_.symbols_offset ||
+        header_.symbols_offset > map_size_ ||
+        header_.record_count > (header_.symbols_offset - header_.records_offset) / sizeof(EngineCommand) ||
+        header_.symbol_count > (map_size_ - header_.symbols_offset) / sizeof(command_cache::SymbolEntry))
+        fail("truncated");
+
+    records_ = reinterpret_cast<const EngineCommand*>(base + header_.records_offset);
+
+    symbols_.reserve(header_.symbol_count);
+    for (uint32_t i = 0; i < header_.symbol_count; ++i) {
+        command_cache::SymbolEntry entry;
+        std::memcpy(&entry, base + header_.symbols_offset + i * sizeof(entry), sizeof(entry));
+        std::string symbol(entry.symbol, sizeof(entry.symbol));
+        while (!symbol.empty() && symbol.back() == ' ')
+            symbol.pop_back();
+        symbols_.emplace_back(entry.locate, std::move(symbol));
+    }
+}
+
+CommandCacheReader::~CommandCacheReader() {
+    if (map_)
+        ::munmap(map_, map_size_);
+}
+
+// ---------- Builder ----------
+
+namespace {
+
+// Frames `source` and reports every tracked directory entry and decoded
+// order command, in stream order. Returns {messages, bytes}.
+template <typename OnSymbol, typename OnCommand>
+std::pair<uint64_t, uint64_t> decode_tracked(BlockSource& source, const std::unordered_set<std::string>& tracked_symbols,
+                                             OnSymbol&& on_symbol, OnCommand&& on_command) {
+    ItchFramer framer(source);
+    ItchPrefilter prefilter;
+
+    EngineCommand cmd;
+    const uint64_t messages = prefilter.run(framer, [&](const char* msg, uint16_t length) {
+        const char type = itch::type(msg);
+
+        if (type == 'R') {
+            if (length < itch::directory::LENGTH)
+                return;
+            uint16_t locate = itch::stock_locate(msg);
+            if (prefilter.tracked(locate) || !ItchDispatcher::passes_directory_filter(msg))
+                return;
+            std::string symbol = ItchDispatcher::directory_symbol(msg);
+            if (symbol.empty() || !tracked_symbols.count(symbol))
+                return;
+            prefilter.track(locate);
+            on_symbol(locate, symbol);
+            return;
+        }
+
+        // messages the prefilter hands over unchecked still need the test,
+        // and their length decides whether the locate may be read at all
+        const size_t needed = itch::order_message_length(type);
+        if (needed == 0 || length < needed || !prefilter.tracked(itch::stock_locate(msg)))
+            return;
+        if (ItchDispatcher::decode(type, msg, cmd))
+            on_command(cmd);
+    });
+
+    return {messages, framer.bytes_consumed()};
+}
+
+} // namespace
+
+DecodedCommands decode_commands(BlockSource& source, const std::unordered_set<std::string>& tracked_symbols) {
+    DecodedCommands decoded;
+    auto [messages, bytes] = decode_tracked(
+        source, tracked_symbols,
+        [&](uint16_t locate, const std::string& symbol) { decoded.symbols.emplace_back(locate, symbol); },
+        [&](const EngineCommand& cmd) { decoded.commands.push_back(cmd); });
+    decoded.messages = messages;
+    decoded.bytes = bytes;
+    return decoded;
+}
+
+CommandCacheBuildSummary build_command_cache(BlockSource& source,
+                                             const std::unordered_set<std::string>& tracked_symbols,
+                                             const std::string& out_path) {
+    CommandCacheWriter writer(out_path);
+    CommandCacheBuildSummary summary;
+
+    auto [messages, bytes] = decode_tracked(
+        source, tracked_symbols,
+        [&](uint16_t locate, const std::string& symbol) {
+            writer.add_symbol(locate, symbol);
+            ++summary.symbols;
+        },
+        [&](const EngineCommand& cmd) { writer.append(cmd); });
+
+    summary.messages = messages;
+    summary.bytes = bytes;
+    summary.commands = writer.record_count();
+    writer.finish(summary.messages, summary.bytes);
+    return summary;
+}
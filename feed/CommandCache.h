@@ -0,0 +1,132 @@
+#pragma once
+
+#include "BlockSource.h"
+#include "EngineCommand.h"
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// On-disk cache of pre-decoded order commands. A replay from the cache skips
+// framing, big-endian decoding and stock directory filtering entirely: the
+// record array is mapped read-only and handed to the engines as is.
+//
+// Layout (little endian, native EngineCommand layout):
+//   Header        64 bytes
+//   records       record_count x EngineCommand, starting at byte 64
+//   symbol table  symbol_count x SymbolEntry, at symbols_offset
+namespace command_cache {
+
+inline constexpr char MAGIC[8] = {'I', 'T', 'C', 'H', 'C', 'M', 'D', '1'};
+inline constexpr uint32_t VERSION = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_count;
+    uint64_t records_offset;
+    uint64_t symbols_offset;
+    uint32_t symbol_count;
+    uint32_t reserved;
+    uint64_t source_messages;   // ITCH messages read while building
+    uint64_t source_bytes;
+};
+static_assert(sizeof(Header) == 64);
+
+struct SymbolEntry {
+    uint16_t locate;
+    char symbol[8];             // space padded, as in the 'R' message
+    uint8_t reserved[6];
+};
+static_assert(sizeof(SymbolEntry) == 16);
+
+// True when the file at `path` starts with the cache magic
+bool is_cache_file(const std::string &path);
+
+} // namespace command_cache
+
+// Streams commands into a cache file. The header is rewritten by finish();
+// a file that was never finished fails validation when opened.
+class CommandCacheWriter
+{
+public:
+    explicit CommandCacheWriter(const std::string &path);
+    ~CommandCacheWriter();
+
+    CommandCacheWriter(const CommandCacheWriter &) = delete;
+    CommandCacheWriter &operator=(const CommandCacheWriter &) = delete;
+
+    void add_symbol(uint16_t locate, const std::string &symbol);
+    void append(const EngineCommand &cmd)
+    {
+        buffer_.push_back(cmd);
+        if (buffer_.size() == BUFFER_RECORDS)
+            flush();
+    }
+
+    void finish(uint64_t source_messages = 0, uint64_t source_bytes = 0);
+    uint64_t record_count() const { return written_ + buffer_.size(); }
+
+private:
+    static constexpr size_t BUFFER_RECORDS = 16384;
+
+    void flush();
+
+    std::string path_;
+    std::FILE *file_ = nullptr;
+    std::vector<EngineCommand> buffer_;
+    std::vector<command_cache::SymbolEntry> symbols_;
+    uint64_t written_ = 0;
+    bool finished_ = false;
+};
+
+// Read-only mapping of a finished cache file.
+class CommandCacheReader
+{
+public:
+    explicit CommandCacheReader(const std::string &path);
+    ~CommandCacheReader();
+
+    CommandCacheReader(const CommandCacheReader &) = delete;
+    CommandCacheReader &operator=(const CommandCacheReader &) = delete;
+
+    std::span<const EngineCommand> commands() const { return {records_, header_.record_count}; }
+    const std::vector<std::pair<uint16_t, std::string>> &symbols() const { return symbols_; }
+    const command_cache::Header &header() const { return header_; }
+
+private:
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+    command_cache::Header header_{};
+    const EngineCommand *records_ = nullptr;
+    std::vector<std::pair<uint16_t, std::string>> symbols_;
+};
+
+struct CommandCacheBuildSummary {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t commands = 0;
+    size_t symbols = 0;
+};
+
+// An ITCH stream decoded into memory, for consumers that replay the same
+// commands many times within one process (see run_backtests)
+struct DecodedCommands {
+    std::vector<EngineCommand> commands;
+    std::vector<std::pair<uint16_t, std::string>> symbols;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+};
+
+DecodedCommands decode_commands(BlockSource &source, const std::unordered_set<std::string> &tracked_symbols);
+
+// Frames and decodes an ITCH stream once, keeping only order messages for
+// `tracked_symbols` that pass the stock directory filter, and writes them to
+// a cache at `out_path`.
+CommandCacheBuildSummary build_command_cache(BlockSource &source,
+                                             const std::unordered_set<std::string> &tracked_symbols,
+                                             const std::string &out_path);
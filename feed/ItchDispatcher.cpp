@@ -0,0 +1,97 @@
+#include "ItchDispatcher.h"
+
+ItchDispatcher::ItchDispatcher(std::unordered_set<std::string> tracked_symbols, EngineFactory factory)
+    : tracked_(std::move(tracked_symbols)), factory_(std::move(factory)),
+      engines_(UINT16_MAX + 1, nullptr), symbols_(UINT16_MAX + 1)
+{
+}
+
+std::string ItchDispatcher::directory_symbol(const char* msg) {
+    std::string stock(msg + itch::directory::STOCK, 8);
+    while (!stock.empty() && stock.back() == ' ')
+        stock.pop_back();
+    return stock;
+}
+
+bool ItchDispatcher::passes_directory_filter(const char* msg) {
+    char financial_status = msg[itch::directory::FINANCIAL_STATUS];
+    char issue_classification = msg[itch::directory::ISSUE_CLASSIFICATION];
+    char authenticity = msg[itch::directory::AUTHENTICITY];
+
+    // filter: production, common stock, normal financial status
+    if (authenticity != 'P')
+        return false;
+    if (issue_classification != 'C')
+        return false;
+    if (financial_status != 'N' && financial_status != ' ')
+        return false;
+    return true;
+}
+
+void ItchDispatcher::on_stock_directory(const char* msg, size_t length) {
+    if (length < itch::directory::LENGTH)
+        return;
+
+    uint16_t locate = itch::stock_locate(msg);
+    if (engines_[locate])
+        return;
+
+    std::string stock = directory_symbol(msg);
+    if (stock.empty() || !tracked_.count(stock) || !passes_directory_filter(msg))
+        return;
+
+    MatchingEngine* engine = factory_(locate, stock);
+    if (!engine)
+        return;
+
+    engines_[locate] = engine;
+    symbols_[locate] = stock;
+    ++tracked_count_;
+}
+
+bool ItchDispatcher::decode(char type, const char* msg, EngineCommand& cmd) {
+    cmd = EngineCommand{};
+    cmd.locate = itch::stock_locate(msg);
+    cmd.timestamp = itch::timestamp(msg);
+
+    switch (type) {
+        case 'A':
+        case 'F':
+            cmd.type = CommandType::Add;
+            cmd.order_id = static_cast<int64_t>(itch::read_be64(msg + itch::add::ORDER_REF));
+            cmd.side = msg[itch::add::SIDE] == 'B' ? 0 : 1;
+            cmd.quantity = static_cast<int32_t>(itch::read_be32(msg + itch::add::SHARES));
+            cmd.price = itch::read_be32(msg + itch::add::PRICE);
+            return true;
+        case 'D':
+            cmd.type = CommandType::Cancel;
+            cmd.order_id = static_cast<int64_t>(itch::read_be64(msg + itch::modify::ORDER_REF));
+            return true;
+        case 'X':
+            cmd.type = CommandType::Reduce;
+            cmd.order_id = static_cast<int64_t>(itch::read_be64(msg + itch::modify::ORDER_REF));
+            cmd.quantity = static_cast<int32_t>(itch::read_be32(msg + itch::modify::SHARES));
+            return true;
+        case 'E':
+        case 'C':
+            cmd.type = CommandType::Execute;
+            cmd.order_id = static_cast<int64_t>(itch::read_be64(msg + itch::modify::ORDER_REF));
+            cmd.quantity = static_cast<int32_t>(itch::read_be32(msg + itch::modify::SHARES));
+            return true;
+        case 'U':
+            cmd.type = CommandType::Replace;
+            cmd.order_id = static_cast<int64_t>(itch::read_be64(msg + itch::replace::ORIGINAL_REF));
+            cmd.new_order_id = static_cast<int64_t>(itch::read_be64(msg + itch::replace::NEW_REF));
+            cmd.quantity = static_cast<int32_t>(itch::read_be32(msg + itch::replace::SHARES));
+            cmd.price = itch::read_be32(msg + itch::replace::PRICE);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void ItchDispatcher::apply(MatchingEngine& engine, char type, const char* msg) {
+    EngineCommand cmd;
+    if (decode(type, msg, cmd))
+        engine.apply(cmd);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "EngineCommand.h"
+#include "ItchMessage.h"
+#include "MatchingEngine.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Routes decoded ITCH messages to per-symbol matching engines. Stock
+// directory ('R') messages for tracked symbols that pass the production /
+// common stock / normal status filter ask the factory for an engine; order
+// messages for those locates are decoded and applied, everything else is
+// dropped. Engines are looked up through a flat array indexed by locate.
+class ItchDispatcher
+{
+public:
+    // Returns the engine for a newly listed symbol, or nullptr to skip it.
+    // The dispatcher does not own the engine.
+    using EngineFactory = std::function<MatchingEngine *(uint16_t locate, const std::string &symbol)>;
+
+    ItchDispatcher(std::unordered_set<std::string> tracked_symbols, EngineFactory factory);
+
+    // `msg` points at the type byte, `length` excludes the length prefix
+    void dispatch(const char *msg, size_t length)
+    {
+        const char type = itch::type(msg);
+        if (type == 'R') {
+            on_stock_directory(msg, length);
+            return;
+        }
+
+        // length first: a short or non-order message may not reach the locate
+        const size_t needed = itch::order_message_length(type);
+        if (needed == 0 || length < needed)
+            return;
+        if (MatchingEngine *engine = engines_[itch::stock_locate(msg)])
+            apply(*engine, type, msg);
+    }
+
+    MatchingEngine *engine(uint16_t locate) const { return engines_[locate]; }
+    const std::string &symbol(uint16_t locate) const { return symbols_[locate]; }
+    bool is_tracked(uint16_t locate) const { return engines_[locate] != nullptr; }
+    size_t tracked_count() const { return tracked_count_; }
+
+    // Decodes one order message and applies it to `engine`
+    static void apply(MatchingEngine &engine, char type, const char *msg);
+
+    // Decodes an order message (A, F, D, X, E, C, U) into `cmd`; false for
+    // any other type. `msg` must be at least order_message_length(type) long.
+    static bool decode(char type, const char *msg, EngineCommand &cmd);
+
+    // Production, common stock, normal (or blank) financial status
+    static bool passes_directory_filter(const char *msg);
+
+    // Symbol from an 'R' message with the space padding removed
+    static std::string directory_symbol(const char *msg);
+
+private:
+    void on_stock_directory(const char *msg, size_t length);
+
+    std::unordered_set<std::string> tracked_;
+    EngineFactory factory_;
+    std::vector<MatchingEngine *> engines_;
+    std::vector<std::string> symbols_;
+    size_t tracked_count_ = 0;
+};
@@ -0,0 +1,58 @@
+#include "ItchFramer.h"
+
+#include <algorithm>
+
+ItchFramer::ItchFramer(BlockSource& source)
+    : source_(source)
+{
+    carry_.reserve(2 + UINT16_MAX);
+}
+
+bool ItchFramer::load_block() {
+    bytes_before_block_ += end_ - block_begin_;
+    auto block = source_.next_block();
+    block_begin_ = cur_ = block.data();
+    end_ = block.data() + block.size();
+    return !block.empty();
+}
+
+bool ItchFramer::next_slow(ItchMessageView& msg) {
+    // a zero length can only come from corrupt input
+    if (end_ - cur_ >= 2 && itch::read_be16(cur_) == 0) {
+        throw std::runtime_error("ItchFramer: invalid zero-length message");
+    }
+
+    // block ended exactly on a message boundary: frame from the next block
+    if (cur_ == end_) {
+        if (!load_block()) return false;
+        return next(msg);
+    }
+
+    // stash whatever is left of this block, then top up from the next ones
+    carry_.assign(cur_, end_);
+    cur_ = end_;
+
+    size_t needed = 2;
+    while (true) {
+        if (carry_.size() >= 2) {
+            uint16_t length = itch::read_be16(carry_.data());
+            if (length == 0) {
+                throw std::runtime_error("ItchFramer: invalid zero-length message");
+            }
+            needed = 2 + static_cast<size_t>(length);
+        }
+        if (carry_.size() >= needed) break;
+
+        if (cur_ == end_ && !load_block()) {
+            throw std::runtime_error("ItchFramer: truncated message at end of stream");
+        }
+
+        size_t take = std::min(needed - carry_.size(), static_cast<size_t>(end_ - cur_));
+        carry_.insert(carry_.end(), cur_, cur_ + take);
+        cur_ += take;
+    }
+
+    msg.data = carry_.data() + 2;
+    msg.length = itch::read_be16(carry_.data());
+    return true;
+}
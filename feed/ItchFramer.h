@@ -0,0 +1,58 @@
+#pragma once
+
+#include "BlockSource.h"
+#include "ItchMessage.h"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// One ITCH message: `data` points at the type byte, `length` excludes the
+// 2-byte length prefix. Valid until the next call to ItchFramer::next().
+struct ItchMessageView {
+    const char *data = nullptr;
+    uint16_t length = 0;
+};
+
+// Splits a BlockSource into length-prefixed ITCH messages. Messages that sit
+// wholly inside a block are returned as pointers into that block (no copy);
+// only the rare message straddling two blocks is stitched together in a
+// small carry buffer.
+class ItchFramer
+{
+public:
+    explicit ItchFramer(BlockSource &source);
+
+    // False at a clean end of stream; throws on a truncated final message
+    bool next(ItchMessageView &msg)
+    {
+        if (end_ - cur_ >= 2) {
+            uint16_t length = itch::read_be16(cur_);
+            if (length != 0 && end_ - cur_ >= 2 + length) {
+                msg.data = cur_ + 2;
+                msg.length = length;
+                cur_ += 2 + length;
+                return true;
+            }
+        }
+        return next_slow(msg);
+    }
+
+    // Remaining whole-or-partial bytes of the current block, for callers that
+    // want to scan ahead before framing (see ItchPrefilter)
+    const char *cursor() const { return cur_; }
+    const char *block_end() const { return end_; }
+    void advance_to(const char *p) { cur_ = p; }
+
+    uint64_t bytes_consumed() const { return bytes_before_block_ + (cur_ - block_begin_); }
+
+private:
+    bool next_slow(ItchMessageView &msg);
+    bool load_block();
+
+    BlockSource &source_;
+    const char *block_begin_ = nullptr;
+    const char *cur_ = nullptr;
+    const char *end_ = nullptr;
+    uint64_t bytes_before_block_ = 0;
+    std::vector<char> carry_;
+};
@@ -0,0 +1,150 @@
+#include "ItchMerge.h"
+#include "CommandCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+// --- ItchMerge ---
+
+ItchMerge::ItchMerge(std::vector<std::unique_ptr<BlockSource>> inputs) {
+    if (inputs.empty()) {
+        throw std::invalid_argument("ItchMerge: no inputs");
+    }
+    // the input index shares the key with a 48-bit timestamp
+    if (inputs.size() >= UINT16_MAX) {
+        throw std::invalid_argument("ItchMerge: too many inputs");
+    }
+
+    inputs_.reserve(inputs.size());
+    for (auto& source : inputs) {
+        inputs_.push_back(std::make_unique<Input>(std::move(source)));
+    }
+
+    const size_t leaves = std::bit_ceil(inputs_.size());
+    keys_.assign(leaves, EXHAUSTED);
+    tree_.assign(leaves, 0);
+}
+
+void ItchMerge::advance(size_t i) {
+    Input& in = *inputs_[i];
+    if (!in.framer.next(in.head)) {
+        keys_[i] = EXHAUSTED;
+        return;
+    }
+    if (in.head.length >= itch::TIMESTAMP + 6) {
+        in.timestamp = itch::timestamp(in.head.data);
+    }
+    keys_[i] = (in.timestamp << 16) | i;
+}
+
+void ItchMerge::replay(size_t i) {
+    // walk leaf to root; each node keeps the loser and passes the winner up
+    uint32_t winner = static_cast<uint32_t>(i);
+    for (size_t node = (i + keys_.size()) >> 1; node > 0; node >>= 1) {
+        if (keys_[tree_[node]] < keys_[winner]) {
+            std::swap(tree_[node], winner);
+        }
+    }
+    tree_[0] = winner;
+}
+
+bool ItchMerge::next(ItchMessageView& msg) {
+    if (!started_) {
+        started_ = true;
+        for (size_t i = 0; i < inputs_.size(); ++i) {
+            advance(i);
+        }
+
+        // build bottom up from the winners of each subtree
+        const size_t leaves = keys_.size();
+        std::vector<uint32_t> winners(2 * leaves);
+        for (size_t i = 0; i < leaves; ++i) {
+            winners[leaves + i] = static_cast<uint32_t>(i);
+        }
+        for (size_t node = leaves - 1; node > 0; --node) {
+            uint32_t a = winners[2 * node], b = winners[2 * node + 1];
+            if (keys_[b] < keys_[a]) std::swap(a, b);
+            winners[node] = a;
+            tree_[node] = b;
+        }
+        tree_[0] = leaves > 1 ? winners[1] : 0;
+    } else {
+        const uint32_t last = tree_[0];
+        if (keys_[last] == EXHAUSTED) return false;
+        advance(last);
+        replay(last);
+    }
+
+    const uint32_t winner = tree_[0];
+    if (keys_[winner] == EXHAUSTED) return false;
+    msg = inputs_[winner]->head;
+    return true;
+}
+
+uint64_t ItchMerge::bytes_consumed() const {
+    uint64_t total = 0;
+    for (const auto& in : inputs_) {
+        total += in->framer.bytes_consumed();
+    }
+    return total;
+}
+
+// --- ItchMergeProducer ---
+
+ItchMergeProducer::ItchMergeProducer(std::vector<std::unique_ptr<BlockSource>> inputs)
+    : merge_(std::move(inputs))
+{
+}
+
+size_t ItchMergeProducer::fill(char* dst, size_t capacity) {
+    // a message that does not fit is split across blocks; the consumer's
+    // framer stitches it back together
+    size_t n = 0;
+    while (n < capacity) {
+        if (!pending_) {
+            if (!merge_.next(message_)) break;
+            prefix_[0] = static_cast<char>(message_.length >> 8);
+            prefix_[1] = static_cast<char>(message_.length & 0xff);
+            pending_offset_ = 0;
+            pending_ = true;
+        }
+
+        while (pending_offset_ < 2 && n < capacity) {
+            dst[n++] = prefix_[pending_offset_++];
+        }
+        if (pending_offset_ < 2) break;
+
+        const size_t total = 2 + static_cast<size_t>(message_.length);
+        const size_t take = std::min(capacity - n, total - pending_offset_);
+        std::memcpy(dst + n, message_.data + (pending_offset_ - 2), take);
+        n += take;
+        pending_offset_ += take;
+        if (pending_offset_ == total) pending_ = false;
+    }
+    return n;
+}
+
+// --- open_merged_source ---
+
+std::unique_ptr<BlockSource> open_merged_source(const std::vector<std::string>& paths, size_t input_block_size,
+                                                size_t input_ring_blocks) {
+    if (paths.empty()) {
+        throw std::invalid_argument("open_merged_source: no inputs");
+    }
+    if (paths.size() == 1) {
+        return open_block_source(paths[0]);
+    }
+
+    std::vector<std::unique_ptr<BlockSource>> inputs;
+    inputs.reserve(paths.size());
+    for (const auto& path : paths) {
+        if (command_cache::is_cache_file(path)) {
+            throw std::runtime_error(path + " is a command cache; only ITCH streams can be merged");
+        }
+        inputs.push_back(open_block_source(path, input_block_size, input_ring_blocks));
+    }
+    return std::make_unique<PipelinedSource>(std::make_unique<ItchMergeProducer>(std::move(inputs)));
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "BlockSource.h"
+#include "ItchFramer.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Merges N ITCH streams into one, ordered by the 6-byte exchange timestamp.
+// Each input keeps its own framer and head message; a loser tree over the
+// heads picks the next message, so advancing costs log2(N) comparisons of
+// packed 64-bit keys (timestamp << 16 | input), replayed from one leaf. Ties
+// go to the lower input index and each input keeps its own order, so the
+// merge is stable and deterministic. Messages too short to carry a timestamp
+// take their input's previous one.
+//
+// The inputs must share one locate space, e.g. per-symbol or per-locate
+// extracts of the same day; locates are not remapped. Duplicate directory
+// messages are harmless, the dispatcher only lists a locate once.
+class ItchMerge
+{
+public:
+    explicit ItchMerge(std::vector<std::unique_ptr<BlockSource>> inputs);
+
+    ItchMerge(const ItchMerge &) = delete;
+    ItchMerge &operator=(const ItchMerge &) = delete;
+
+    // False once every input is exhausted. The view stays valid until the
+    // next call.
+    bool next(ItchMessageView &msg);
+
+    // Input the last message came from
+    size_t source() const { return tree_[0]; }
+    size_t inputs() const { return inputs_.size(); }
+
+    uint64_t bytes_consumed() const;
+
+private:
+    struct Input {
+        explicit Input(std::unique_ptr<BlockSource> s) : source(std::move(s)), framer(*source) {}
+
+        std::unique_ptr<BlockSource> source;
+        ItchFramer framer;
+        ItchMessageView head;
+        uint64_t timestamp = 0;
+    };
+
+    static constexpr uint64_t EXHAUSTED = UINT64_MAX;
+
+    void advance(size_t i);
+    void replay(size_t i);
+
+    std::vector<std::unique_ptr<Input>> inputs_;
+    std::vector<uint64_t> keys_;    // one per leaf, padded to a power of two
+    std::vector<uint32_t> tree_;    // loser per internal node; tree_[0] is the winner
+    bool started_ = false;
+};
+
+// BlockProducer that re-frames an ItchMerge as one length-prefixed stream, so
+// the merge can run on a PipelinedSource thread and feed anything that reads
+// a BlockSource (framer, prefilter, command cache builder) unchanged.
+class ItchMergeProducer : public BlockProducer
+{
+public:
+    explicit ItchMergeProducer(std::vector<std::unique_ptr<BlockSource>> inputs);
+
+    size_t fill(char *dst, size_t capacity) override;
+
+private:
+    ItchMerge merge_;
+    ItchMessageView message_;       // being copied out while pending_
+    char prefix_[2] = {};
+    size_t pending_offset_ = 0;     // bytes of prefix + message already copied
+    bool pending_ = false;
+};
+
+// Opens every path as its own read-ahead source (inflating gzip inputs on
+// their reader threads) and merges them on one more thread. A single path
+// is opened directly. Throws std::runtime_error if a path is a command cache.
+std::unique_ptr<BlockSource> open_merged_source(const std::vector<std::string> &paths,
+                                                size_t input_block_size = 1 << 20,
+                                                size_t input_ring_blocks = PipelinedSource::DEFAULT_RING_BLOCKS);
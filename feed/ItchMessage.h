@@ -0,0 +1,100 @@
+#ifndef FEED_ITCHMESSAGE_H
+#define FEED_ITCHMESSAGE_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Field access for NASDAQ TotalView-ITCH 5.0 messages. All offsets are from
+// the message type byte (i.e. after the 2-byte length prefix of the file /
+// MoldUDP64 framing); all integers are big endian.
+namespace itch {
+
+inline uint16_t read_be16(const char *p) {
+    const auto *u = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<uint16_t>((u[0] << 8) | u[1]);
+}
+
+inline uint32_t read_be32(const char *p) {
+    const auto *u = reinterpret_cast<const unsigned char *>(p);
+    return (static_cast<uint32_t>(u[0]) << 24) | (static_cast<uint32_t>(u[1]) << 16) |
+           (static_cast<uint32_t>(u[2]) << 8) | static_cast<uint32_t>(u[3]);
+}
+
+inline uint64_t read_be48(const char *p) {
+    return (static_cast<uint64_t>(read_be16(p)) << 32) | read_be32(p + 2);
+}
+
+inline uint64_t read_be64(const char *p) {
+    return (static_cast<uint64_t>(read_be32(p)) << 32) | read_be32(p + 4);
+}
+
+// Common header
+inline constexpr size_t TYPE = 0;
+inline constexpr size_t STOCK_LOCATE = 1;
+inline constexpr size_t TRACKING_NUMBER = 3;
+inline constexpr size_t TIMESTAMP = 5;      // 6 bytes, ns since midnight
+
+inline char type(const char *msg) { return msg[TYPE]; }
+inline uint16_t stock_locate(const char *msg) { return read_be16(msg + STOCK_LOCATE); }
+inline uint64_t timestamp(const char *msg) { return read_be48(msg + TIMESTAMP); }
+
+// 'R' stock directory
+namespace directory {
+inline constexpr size_t STOCK = 11;         // 8 bytes, space padded
+inline constexpr size_t MARKET_CATEGORY = 19;
+inline constexpr size_t FINANCIAL_STATUS = 20;
+inline constexpr size_t ISSUE_CLASSIFICATION = 26;
+inline constexpr size_t AUTHENTICITY = 29;
+inline constexpr size_t LENGTH = 39;
+} // namespace directory
+
+// 'A' / 'F' add order (F appends a 4-byte attribution)
+namespace add {
+inline constexpr size_t ORDER_REF = 11;
+inline constexpr size_t SIDE = 19;
+inline constexpr size_t SHARES = 20;
+inline constexpr size_t STOCK = 24;
+inline constexpr size_t PRICE = 32;
+inline constexpr size_t LENGTH = 36;
+} // namespace add
+
+// 'E' executed, 'C' executed with price, 'X' cancel, 'D' delete
+namespace modify {
+inline constexpr size_t ORDER_REF = 11;
+inline constexpr size_t SHARES = 19;        // executed / cancelled shares
+inline constexpr size_t DELETE_LENGTH = 19;
+inline constexpr size_t CANCEL_LENGTH = 23;
+inline constexpr size_t EXECUTE_LENGTH = 31;
+inline constexpr size_t EXECUTE_PRICE_LENGTH = 36;
+} // namespace modify
+
+// 'U' replace
+namespace replace {
+inline constexpr size_t ORIGINAL_REF = 11;
+inline constexpr size_t NEW_REF = 19;
+inline constexpr size_t SHARES = 27;
+inline constexpr size_t PRICE = 31;
+inline constexpr size_t LENGTH = 35;
+} // namespace replace
+
+// Shortest valid length of the order messages the engines consume, 0 for
+// types that are not applied to a book
+inline size_t order_message_length(char type) {
+    switch (type) {
+        case 'A': return add::LENGTH;
+        case 'F': return add::LENGTH + 4;
+        case 'D': return modify::DELETE_LENGTH;
+        case 'X': return modify::CANCEL_LENGTH;
+        case 'E': return modify::EXECUTE_LENGTH;
+        case 'C': return modify::EXECUTE_PRICE_LENGTH;
+        case 'U': return replace::LENGTH;
+        default: return 0;
+    }
+}
+
+// Prices are fixed point with four implied decimals
+inline constexpr double PRICE_SCALE = 10000.0;
+
+} // namespace itch
+
+#endif // FEED_ITCHMESSAGE_H
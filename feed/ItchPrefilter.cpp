@@ -0,0 +1,125 @@
+#include "ItchPrefilter.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ORDERBOOK_PREFILTER_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// type byte + 2-byte locate: the least a message must hold to be tested
+constexpr uint16_t MIN_TESTABLE = 3;
+
+} // namespace
+
+ItchPrefilter::ItchPrefilter(bool allow_simd)
+    : simd_(allow_simd && cpu_has_avx2()) {
+    survivors_.reserve(BATCH);
+}
+
+bool ItchPrefilter::cpu_has_avx2() {
+#ifdef ORDERBOOK_PREFILTER_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const char* ItchPrefilter::scan(const char* begin, const char* end, std::vector<uint32_t>& survivors,
+                                uint64_t& scanned) const {
+    return simd_ ? scan_avx2(begin, end, survivors, scanned) : scan_scalar(begin, begin, end, survivors, scanned);
+}
+
+const char* ItchPrefilter::scan_scalar(const char* begin, const char* from, const char* end,
+                                       std::vector<uint32_t>& survivors, uint64_t& scanned) const {
+    const char* p = from;
+    while (survivors.size() < BATCH && end - p >= 2) {
+        const uint16_t length = itch::read_be16(p);
+        if (length < MIN_TESTABLE || end - p < 2 + length) break;
+
+        const char type = p[2];
+        ++scanned;
+        if (type == 'R' || tracked(itch::read_be16(p + 3))) {
+            survivors.push_back(static_cast<uint32_t>(p - begin));
+            if (type == 'R') return p + 2 + length;
+        }
+        p += 2 + length;
+    }
+    return p;
+}
+
+#ifdef ORDERBOOK_PREFILTER_AVX2
+
+__attribute__((target("avx2")))
+const char* ItchPrefilter::scan_avx2(const char* begin, const char* end, std::vector<uint32_t>& survivors,
+                                     uint64_t& scanned) const {
+    const char* p = begin;
+    alignas(32) int32_t offsets[8];
+
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i directory = _mm256_set1_epi32('R');
+    const __m256i ones = _mm256_set1_epi32(1);
+    const __m256i bit_mask = _mm256_set1_epi32(31);
+    const __m256i zero = _mm256_setzero_si256();
+
+    while (survivors.size() + 8 <= BATCH) {
+        // framing is a dependent walk; collect eight whole, testable messages
+        const char* q = p;
+        int n = 0;
+        for (; n < 8 && end - q >= 2; ++n) {
+            const uint16_t length = itch::read_be16(q);
+            if (length < MIN_TESTABLE || end - q < 2 + length) break;
+            offsets[n] = static_cast<int32_t>(q - begin);
+            q += 2 + length;
+        }
+        if (n < 8) break;   // the scalar tail finishes the block
+
+        // one 32-bit gather from the low length byte picks up
+        // [len_lo, type, locate_hi, locate_lo] without reading past the message
+        const __m256i idx = _mm256_load_si256(reinterpret_cast<const __m256i*>(offsets));
+        const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(begin + 1), idx, 1);
+
+        const __m256i type = _mm256_and_si256(_mm256_srli_epi32(words, 8), byte_mask);
+        const __m256i locate = _mm256_or_si256(
+            _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(words, 16), byte_mask), 8),
+            _mm256_srli_epi32(words, 24));
+
+        const __m256i bitmap_words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(bitmap_.data()),
+                                                            _mm256_srli_epi32(locate, 5), 4);
+        const __m256i bit = _mm256_sllv_epi32(ones, _mm256_and_si256(locate, bit_mask));
+        const __m256i untracked = _mm256_cmpeq_epi32(_mm256_and_si256(bitmap_words, bit), zero);
+        const __m256i is_directory = _mm256_cmpeq_epi32(type, directory);
+
+        unsigned keep = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(untracked))) & 0xFFu;
+        const unsigned directories = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(is_directory)));
+        keep |= directories;
+
+        if (directories) {
+            // stop after the first 'R' so its locate can be tracked before the rest is tested
+            const int first = __builtin_ctz(directories);
+            keep &= (2u << first) - 1;
+            for (; keep; keep &= keep - 1)
+                survivors.push_back(static_cast<uint32_t>(offsets[__builtin_ctz(keep)]));
+            scanned += first + 1;
+            const char* r = begin + offsets[first];
+            return r + 2 + itch::read_be16(r);
+        }
+
+        for (; keep; keep &= keep - 1)
+            survivors.push_back(static_cast<uint32_t>(offsets[__builtin_ctz(keep)]));
+        scanned += 8;
+        p = q;
+    }
+
+    // partial batch at the block end, or the survivor buffer is nearly full
+    return scan_scalar(begin, p, end, survivors, scanned);
+}
+
+#else
+
+const char* ItchPrefilter::scan_avx2(const char* begin, const char* end, std::vector<uint32_t>& survivors,
+                                     uint64_t& scanned) const {
+    return scan_scalar(begin, begin, end, survivors, scanned);
+}
+
+#endif
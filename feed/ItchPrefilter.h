@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ItchFramer.h"
+#include "ItchMessage.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Drops messages for untracked locates before they reach the decoder. A scan
+// walks the length-prefixed framing of the current block, batches the message
+// offsets and tests type + locate against a tracked-locate bitmap, eight
+// messages at a time with AVX2 gathers when the CPU has them (chosen at
+// runtime) and one at a time otherwise. Only stock directory ('R') messages
+// and messages of tracked locates survive.
+//
+// A scan stops right after each 'R' so the caller can track() the new locate
+// before anything behind it is tested, and at any message it cannot vouch
+// for (shorter than type + locate, or cut by the block end); that message
+// goes through the ordinary ItchFramer::next() path.
+class ItchPrefilter
+{
+public:
+    // Upper bound on survivors returned by one scan, so the offsets stay in L1
+    static constexpr size_t BATCH = 1024;
+
+    explicit ItchPrefilter(bool allow_simd = true);
+
+    void track(uint16_t locate) { bitmap_[locate >> 5] |= 1u << (locate & 31); }
+    bool tracked(uint16_t locate) const { return bitmap_[locate >> 5] & (1u << (locate & 31)); }
+
+    // True when scans use the AVX2 kernel
+    bool simd() const { return simd_; }
+    static bool cpu_has_avx2();
+
+    // Scans whole messages in [begin, end) and appends the offsets (of the
+    // length prefix, relative to `begin`) of the survivors to `survivors`.
+    // `scanned` is increased by the number of messages walked over. Returns
+    // where the scan stopped.
+    const char *scan(const char *begin, const char *end, std::vector<uint32_t> &survivors, uint64_t &scanned) const;
+
+    // Frames `framer` to the end of the stream, calling on_message(data,
+    // length) for each survivor plus each message the scans stopped at, in
+    // stream order. Returns the number of messages framed, filtered or not.
+    template <typename OnMessage>
+    uint64_t run(ItchFramer &framer, OnMessage &&on_message)
+    {
+        uint64_t messages = 0;
+        ItchMessageView msg;
+        while (true) {
+            survivors_.clear();
+            const char *base = framer.cursor();
+            framer.advance_to(scan(base, framer.block_end(), survivors_, messages));
+            for (uint32_t offset : survivors_)
+                on_message(base + offset + 2, itch::read_be16(base + offset));
+
+            if (!framer.next(msg)) break;
+            ++messages;
+            on_message(msg.data, msg.length);
+        }
+        return messages;
+    }
+
+private:
+    // Offsets are relative to `begin`; scanning starts at `from`
+    const char *scan_scalar(const char *begin, const char *from, const char *end,
+                            std::vector<uint32_t> &survivors, uint64_t &scanned) const;
+    const char *scan_avx2(const char *begin, const char *end, std::vector<uint32_t> &survivors, uint64_t &scanned) const;
+
+    alignas(64) std::array<uint32_t, 65536 / 32> bitmap_{};
+    bool simd_;
+    std::vector<uint32_t> survivors_;
+};
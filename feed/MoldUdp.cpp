@@ -0,0 +1,490 @@
+#include "MoldUdp.h"
+#include "ItchFramer.h"
+#include "ItchMessage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t realtime_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t steady_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+sockaddr_in make_address(const std::string& host, uint16_t port, const char* what) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error(std::string(what) + ": bad address " + host);
+    }
+    return addr;
+}
+
+std::runtime_error socket_error(const char* what, const std::string& detail = {}) {
+    std::string message = std::string(what) + (detail.empty() ? "" : " " + detail) + ": " + std::strerror(errno);
+    return std::runtime_error(message);
+}
+
+void put_be(char* dst, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        dst[bytes - 1 - i] = static_cast<char>((v >> (8 * i)) & 0xff);
+    }
+}
+
+} // namespace
+
+// --- moldudp64 ---
+
+namespace moldudp64 {
+
+bool parse_header(const char* packet, size_t size, Header& header) {
+    if (size < HEADER_SIZE) return false;
+    std::memcpy(header.session.data(), packet, SESSION_LENGTH);
+    header.sequence = itch::read_be64(packet + SESSION_LENGTH);
+    header.count = itch::read_be16(packet + SESSION_LENGTH + 8);
+    return true;
+}
+
+void write_header(char* dst, const Header& header) {
+    std::memcpy(dst, header.session.data(), SESSION_LENGTH);
+    put_be(dst + SESSION_LENGTH, header.sequence, 8);
+    put_be(dst + SESSION_LENGTH + 8, header.count, 2);
+}
+
+std::array<char, SESSION_LENGTH> make_session(const std::string& name) {
+    std::array<char, SESSION_LENGTH> session;
+    session.fill(' ');
+    std::memcpy(session.data(), name.data(), std::min(name.size(), SESSION_LENGTH));
+    return session;
+}
+
+} // namespace moldudp64
+
+// --- MoldUdpReceiver ---
+
+MoldUdpReceiver::MoldUdpReceiver(MoldUdpReceiverConfig config) : config_(std::move(config)) {
+    if (config_.batch == 0 || config_.max_packet < moldudp64::HEADER_SIZE) {
+        throw std::invalid_argument("MoldUdpReceiver: batch must be > 0 and max_packet must hold a header");
+    }
+
+    sockaddr_in addr = make_address(config_.bind_address, config_.port, "MoldUdpReceiver");
+    fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) throw socket_error("MoldUdpReceiver: socket()");
+
+    int one = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &config_.receive_buffer, sizeof(config_.receive_buffer));
+    // kernel receive timestamps for packet-to-book latency; the user space
+    // clock at recvmmsg is the fallback
+    ::setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one));
+
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::runtime_error error = socket_error("MoldUdpReceiver: cannot bind",
+                                                config_.bind_address + ":" + std::to_string(config_.port));
+        ::close(fd_);
+        throw error;
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    try {
+        if (!config_.group.empty()) {
+            ip_mreq membership{};
+            membership.imr_multiaddr = make_address(config_.group, 0, "MoldUdpReceiver").sin_addr;
+            membership.imr_interface = make_address(config_.interface_address, 0, "MoldUdpReceiver").sin_addr;
+            if (::setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+                throw socket_error("MoldUdpReceiver: cannot join", config_.group);
+            }
+        }
+        set_request_server(config_.request_address, config_.request_port);
+    } catch (...) {
+        ::close(fd_);
+        throw;
+    }
+
+    if (config_.busy_poll) {
+        ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    } else {
+        // wake up now and then to check stop() and the timeouts
+        timeval timeout{0, 10'000};
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    buffers_.resize(config_.batch * config_.max_packet);
+    controls_.resize(config_.batch);
+    iovecs_.resize(config_.batch);
+    headers_.resize(config_.batch);
+    for (size_t i = 0; i < config_.batch; ++i) {
+        iovecs_[i].iov_base = buffers_.data() + i * config_.max_packet;
+        iovecs_[i].iov_len = config_.max_packet;
+        headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+        headers_[i].msg_hdr.msg_iovlen = 1;
+        headers_[i].msg_hdr.msg_control = controls_[i].data();
+    }
+
+    if (config_.first_sequence != 0) {
+        expected_ = known_end_ = config_.first_sequence;
+        synced_ = true;
+    }
+    last_packet_ns_ = realtime_ns();
+}
+
+MoldUdpReceiver::~MoldUdpReceiver() {
+    ::close(fd_);
+}
+
+void MoldUdpReceiver::set_request_server(const std::string& address, uint16_t port) {
+    if (port != 0) request_addr_ = make_address(address, port, "MoldUdpReceiver");
+    request_port_ = port;
+}
+
+bool MoldUdpReceiver::receive_batch() {
+    for (auto& h : headers_) {
+        h.msg_hdr.msg_controllen = sizeof(controls_[0]);
+        h.msg_hdr.msg_flags = 0;
+    }
+    const int flags = config_.busy_poll ? MSG_DONTWAIT : MSG_WAITFORONE;
+    const int n = ::recvmmsg(fd_, headers_.data(), static_cast<unsigned>(headers_.size()), flags, nullptr);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return false;
+        throw socket_error("MoldUdpReceiver: recvmmsg");
+    }
+    received_ = static_cast<size_t>(n);
+    next_slot_ = 0;
+    if (n > 0) last_packet_ns_ = realtime_ns();
+    return n > 0;
+}
+
+void MoldUdpReceiver::open_gap(uint64_t upto) {
+    const uint64_t first = expected_, count = upto - expected_;
+    ++stats_.gaps;
+    gap_until_ = upto;
+    gap_opened_ns_ = steady_ns();
+    if (on_gap_) on_gap_(first, count);
+    send_request(first, count);
+}
+
+void MoldUdpReceiver::send_request(uint64_t first, uint64_t count) {
+    if (request_port_ == 0) return;
+
+    // one request per gap; the count field tops out below END_OF_SESSION
+    moldudp64::Header header;
+    header.session = session_;
+    header.sequence = first;
+    header.count = static_cast<uint16_t>(std::min<uint64_t>(count, moldudp64::END_OF_SESSION - 1));
+    char request[moldudp64::HEADER_SIZE];
+    moldudp64::write_header(request, header);
+    ::sendto(fd_, request, sizeof(request), 0, reinterpret_cast<const sockaddr*>(&request_addr_),
+             sizeof(request_addr_));
+    stats_.requested += header.count;
+}
+
+std::span<const char> MoldUdpReceiver::accept(const char* packet, size_t size, uint64_t time_ns) {
+    moldudp64::Header header;
+    if (!moldudp64::parse_header(packet, size, header)) {
+        ++stats_.ignored;
+        return {};
+    }
+    if (!have_session_) {
+        session_ = header.session;
+        have_session_ = true;
+    } else if (header.session != session_) {
+        ++stats_.ignored;
+        return {};
+    }
+    if (!synced_) {
+        expected_ = known_end_ = header.sequence;
+        synced_ = true;
+    }
+
+    // heartbeats and the end of session carry the next sequence to expect
+    if (header.count == moldudp64::END_OF_SESSION || header.count == 0) {
+        known_end_ = std::max(known_end_, header.sequence);
+        end_of_session_ |= header.count == moldudp64::END_OF_SESSION;
+        return {};
+    }
+
+    const uint64_t end = header.sequence + header.count;
+    known_end_ = std::max(known_end_, end);
+    if (end <= expected_) {
+        ++stats_.duplicates;
+        return {};
+    }
+    if (header.sequence > expected_) {
+        // beyond a gap: keep a copy, the slot is reused by the next recvmmsg
+        if (pending_.try_emplace(header.sequence, Pending{std::vector<char>(packet, packet + size), time_ns}).second) {
+            return {};
+        }
+        ++stats_.duplicates;
+        return {};
+    }
+    return deliver(packet, size, header, time_ns);
+}
+
+std::span<const char> MoldUdpReceiver::deliver(const char* packet, size_t size, const moldudp64::Header& header,
+                                               uint64_t time_ns) {
+    // walk the message blocks: skip the ones already delivered and make sure
+    // the rest lie inside the packet, so the framer never reads past it
+    const char* p = packet + moldudp64::HEADER_SIZE;
+    const char* const limit = packet + size;
+    const uint64_t skip = expected_ - header.sequence;
+    const char* first = p;
+    for (uint64_t k = 0; k < header.count; ++k) {
+        if (k == skip) first = p;
+        if (limit - p < 2 || limit - p < 2 + itch::read_be16(p)) {
+            ++stats_.ignored;
+            return {};
+        }
+        p += 2 + itch::read_be16(p);
+    }
+
+    stats_.messages += header.count - skip;
+    expected_ = header.sequence + header.count;
+    packet_time_ns_ = time_ns;
+    return {first, static_cast<size_t>(p - first)};
+}
+
+std::span<const char> MoldUdpReceiver::next_block() {
+    while (true) {
+        if (!pending_.empty()) {
+            const uint64_t first = pending_.begin()->first;
+            if (first <= expected_) {
+                // the gap in front of a held packet has filled
+                current_ = std::move(pending_.begin()->second);
+                pending_.erase(pending_.begin());
+                auto block = accept(current_.bytes.data(), current_.bytes.size(), current_.time_ns);
+                if (!block.empty()) return block;
+                continue;
+            }
+        }
+
+        if (expected_ < gap_until_) {
+            const bool expired = steady_ns() - gap_opened_ns_ > config_.gap_timeout_ms * 1'000'000ULL;
+            if (expired || pending_.size() > config_.max_pending_packets) {
+                // give up on the missing range and carry on from the next held packet
+                const uint64_t resume = pending_.empty() ? gap_until_ : std::min(pending_.begin()->first, gap_until_);
+                stats_.lost += resume - expected_;
+                expected_ = resume;
+                continue;
+            }
+        } else if (expected_ < known_end_) {
+            open_gap(pending_.empty() ? known_end_ : pending_.begin()->first);
+            continue;
+        }
+
+        if (end_of_session_ && expected_ >= known_end_) return {};
+
+        if (next_slot_ < received_) {
+            mmsghdr& slot = headers_[next_slot_];
+            const char* packet = buffers_.data() + next_slot_ * config_.max_packet;
+            ++next_slot_;
+            ++stats_.packets;
+
+            uint64_t time_ns = last_packet_ns_;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&slot.msg_hdr); c; c = CMSG_NXTHDR(&slot.msg_hdr, c)) {
+                if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                    timespec ts;
+                    std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                    time_ns = static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + static_cast<uint64_t>(ts.tv_nsec);
+                }
+            }
+
+            // a truncated datagram cannot be trusted
+            if (slot.msg_hdr.msg_flags & MSG_TRUNC) {
+                ++stats_.ignored;
+                continue;
+            }
+            auto block = accept(packet, slot.msg_len, time_ns);
+            if (!block.empty()) return block;
+            continue;
+        }
+
+        if (stop_.load(std::memory_order_relaxed)) return {};
+        if (!receive_batch() && config_.idle_timeout_ms != 0 &&
+            realtime_ns() - last_packet_ns_ > config_.idle_timeout_ms * 1'000'000ULL) {
+            return {};
+        }
+    }
+}
+
+// --- MoldUdpPublisher ---
+
+MoldUdpPublisher::MoldUdpPublisher(MoldUdpPublisherConfig config) : config_(std::move(config)) {
+    if (config_.max_payload < 2 || config_.max_payload > 65000) {
+        throw std::invalid_argument("MoldUdpPublisher: max_payload must be in 2..65000");
+    }
+
+    dest_ = make_address(config_.address, config_.port, "MoldUdpPublisher");
+    session_ = moldudp64::make_session(config_.session);
+
+    fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) throw socket_error("MoldUdpPublisher: socket()");
+    int send_buffer = 8 << 20;
+    ::setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer));
+    if (IN_MULTICAST(ntohl(dest_.sin_addr.s_addr))) {
+        unsigned char ttl = static_cast<unsigned char>(config_.ttl), loop = 1;
+        ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    }
+
+    if (config_.serve_requests) {
+        request_fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(config_.request_port);
+        if (request_fd_ < 0 || ::bind(request_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::runtime_error error =
+                socket_error("MoldUdpPublisher: cannot bind request port", std::to_string(config_.request_port));
+            if (request_fd_ >= 0) ::close(request_fd_);
+            ::close(fd_);
+            throw error;
+        }
+        socklen_t len = sizeof(addr);
+        ::getsockname(request_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        request_port_ = ntohs(addr.sin_port);
+        ::fcntl(request_fd_, F_SETFL, ::fcntl(request_fd_, F_GETFL) | O_NONBLOCK);
+    }
+
+    packet_.reserve(moldudp64::HEADER_SIZE + config_.max_payload);
+    packet_.resize(moldudp64::HEADER_SIZE);
+}
+
+MoldUdpPublisher::~MoldUdpPublisher() {
+    ::close(fd_);
+    if (request_fd_ >= 0) ::close(request_fd_);
+}
+
+void MoldUdpPublisher::send_packet(const char* data, size_t size, bool droppable) {
+    ++stats_.packets;
+    if (droppable && config_.drop_every != 0 && stats_.packets % config_.drop_every == 0) {
+        ++stats_.dropped;
+        return;
+    }
+    if (::sendto(fd_, data, size, 0, reinterpret_cast<const sockaddr*>(&dest_), sizeof(dest_)) < 0) {
+        throw socket_error("MoldUdpPublisher: sendto");
+    }
+}
+
+void MoldUdpPublisher::flush() {
+    if (packet_count_ == 0) return;
+
+    moldudp64::Header header;
+    header.session = session_;
+    header.sequence = next_sequence_;
+    header.count = packet_count_;
+    moldudp64::write_header(packet_.data(), header);
+    send_packet(packet_.data(), packet_.size(), true);
+
+    if (request_fd_ >= 0) {
+        history_.push_back({next_sequence_, packet_count_, packet_});
+        if (history_.size() > config_.history_packets) history_.pop_front();
+    }
+    next_sequence_ += packet_count_;
+    packet_.resize(moldudp64::HEADER_SIZE);
+    packet_count_ = 0;
+
+    serve_requests();
+}
+
+void MoldUdpPublisher::serve_requests() {
+    if (request_fd_ < 0) return;
+
+    char request[64];
+    sockaddr_in from{};
+    socklen_t from_len = sizeof(from);
+    ssize_t n;
+    while ((n = ::recvfrom(request_fd_, request, sizeof(request), 0, reinterpret_cast<sockaddr*>(&from),
+                           &from_len)) >= 0) {
+        moldudp64::Header header;
+        if (!moldudp64::parse_header(request, static_cast<size_t>(n), header) || header.session != session_) {
+            from_len = sizeof(from);
+            continue;
+        }
+
+        // resend every kept packet that overlaps [sequence, sequence + count)
+        const uint64_t end = header.sequence + header.count;
+        auto it = std::upper_bound(history_.begin(), history_.end(), header.sequence,
+                                   [](uint64_t seq, const Sent& sent) { return seq < sent.sequence; });
+        if (it != history_.begin()) --it;
+        for (; it != history_.end() && it->sequence < end; ++it) {
+            if (it->sequence + it->count <= header.sequence) continue;
+            ::sendto(request_fd_, it->bytes.data(), it->bytes.size(), 0, reinterpret_cast<const sockaddr*>(&from),
+                     from_len);
+            ++stats_.retransmitted;
+        }
+        from_len = sizeof(from);
+    }
+}
+
+void MoldUdpPublisher::pace() {
+    if (config_.messages_per_second == 0) return;
+
+    const uint64_t due = start_ns_ + stats_.messages * 1'000'000'000ULL / config_.messages_per_second;
+    if (steady_ns() >= due) return;
+
+    // ahead of schedule: send what is packed so far rather than hold it back
+    flush();
+    while (steady_ns() < due) {
+        serve_requests();
+        std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<uint64_t>(due - steady_ns(), 1'000'000)));
+    }
+}
+
+MoldUdpPublisher::Stats MoldUdpPublisher::run(BlockSource& source) {
+    ItchFramer framer(source);
+    ItchMessageView msg;
+    start_ns_ = steady_ns();
+
+    while (framer.next(msg)) {
+        pace();
+        const size_t block = 2 + static_cast<size_t>(msg.length);
+        if (packet_.size() + block > moldudp64::HEADER_SIZE + config_.max_payload ||
+            packet_count_ == moldudp64::END_OF_SESSION - 1) {
+            flush();
+        }
+        packet_.push_back(static_cast<char>(msg.length >> 8));
+        packet_.push_back(static_cast<char>(msg.length & 0xff));
+        packet_.insert(packet_.end(), msg.data, msg.data + msg.length);
+        ++packet_count_;
+        ++stats_.messages;
+    }
+    flush();
+
+    // end of session, sent a few times since it may be lost too
+    moldudp64::Header header;
+    header.session = session_;
+    header.sequence = next_sequence_;
+    header.count = moldudp64::END_OF_SESSION;
+    char end[moldudp64::HEADER_SIZE];
+    moldudp64::write_header(end, header);
+    for (int i = 0; i < 3; ++i) {
+        send_packet(end, sizeof(end), false);
+    }
+
+    const uint64_t linger_until = steady_ns() + config_.linger_ms * 1'000'000ULL;
+    while (steady_ns() < linger_until) {
+        serve_requests();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return stats_;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "BlockSource.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// MoldUDP64 framing. A downstream packet is a 20-byte header followed by
+// `count` message blocks, each a 2-byte big-endian length and the message,
+// which is exactly the length-prefixed layout of an ITCH file. A request
+// packet is the header alone, asking for `count` messages from `sequence`.
+namespace moldudp64 {
+
+inline constexpr size_t SESSION_LENGTH = 10;
+inline constexpr size_t HEADER_SIZE = 20;
+inline constexpr uint16_t END_OF_SESSION = 0xFFFF;
+
+struct Header {
+    std::array<char, SESSION_LENGTH> session{};
+    uint64_t sequence = 0;      // of the first message in the packet
+    uint16_t count = 0;         // 0 is a heartbeat
+};
+
+// False if the packet is too short to carry a header
+bool parse_header(const char *packet, size_t size, Header &header);
+void write_header(char *dst, const Header &header);
+
+// Space-padded or truncated to SESSION_LENGTH
+std::array<char, SESSION_LENGTH> make_session(const std::string &name);
+
+} // namespace moldudp64
+
+struct MoldUdpReceiverConfig {
+    std::string bind_address = "0.0.0.0";
+    uint16_t port = 0;                  // 0 picks an ephemeral port (see MoldUdpReceiver::port)
+    std::string group;                  // multicast group to join; empty for unicast
+    std::string interface_address = "0.0.0.0";
+
+    // Retransmission server sent a request for every gap; port 0 disables
+    std::string request_address;
+    uint16_t request_port = 0;
+
+    size_t batch = 64;                  // packets per recvmmsg
+    size_t max_packet = 2048;
+    int receive_buffer = 8 << 20;       // SO_RCVBUF bytes; the kernel may cap it
+    bool busy_poll = true;              // spin on a non-blocking socket instead of sleeping in recvmmsg
+    uint64_t first_sequence = 0;        // 0 syncs to the first packet seen
+    uint64_t gap_timeout_ms = 200;      // give up on a gap after this long
+    size_t max_pending_packets = 4096;  // held while a gap is open; overflowing gives up on it
+    uint64_t idle_timeout_ms = 0;       // end the stream after this long without packets; 0 waits forever
+};
+
+// Receives a MoldUDP64 stream and serves it as a BlockSource: each block is
+// the message blocks of one packet, in sequence order, pointing straight into
+// the recvmmsg buffers, so an ItchFramer over it (and everything downstream
+// of the file replay) runs unchanged.
+//
+// Packets are received `batch` at a time. Duplicates are dropped and packets
+// that overlap what was already delivered are trimmed to their new messages.
+// A packet ahead of the expected sequence opens a gap: a request for the
+// missing range goes to the retransmission server (if configured), the gap
+// callback fires, and later packets are copied aside until the gap fills.
+// If it does not fill within gap_timeout_ms, or too many packets pile up,
+// the missing messages are counted as lost and delivery resumes after them.
+//
+// The stream ends on an end-of-session packet, after idle_timeout_ms without
+// traffic, or once stop() is called.
+class MoldUdpReceiver : public BlockSource
+{
+public:
+    using GapCallback = std::function<void(uint64_t first, uint64_t count)>;
+
+    struct Stats {
+        uint64_t packets = 0;           // received, including duplicates and heartbeats
+        uint64_t messages = 0;          // delivered
+        uint64_t duplicates = 0;        // packets with nothing new
+        uint64_t gaps = 0;
+        uint64_t requested = 0;         // messages asked for again
+        uint64_t lost = 0;              // messages given up on
+        uint64_t ignored = 0;           // malformed or from another session
+    };
+
+    explicit MoldUdpReceiver(MoldUdpReceiverConfig config);
+    ~MoldUdpReceiver() override;
+
+    MoldUdpReceiver(const MoldUdpReceiver &) = delete;
+    MoldUdpReceiver &operator=(const MoldUdpReceiver &) = delete;
+
+    std::span<const char> next_block() override;
+
+    // Where gap requests go (as configured by request_address/request_port);
+    // port 0 stops requesting
+    void set_request_server(const std::string &address, uint16_t port);
+
+    // Called with each newly detected gap, before any request is sent
+    void set_gap_callback(GapCallback callback) { on_gap_ = std::move(callback); }
+
+    // Ends the stream at the next poll; safe from any thread
+    void stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    // CLOCK_REALTIME ns at which the packet behind the current block reached
+    // the socket (the kernel timestamp when available)
+    uint64_t packet_time_ns() const { return packet_time_ns_; }
+
+    uint16_t port() const { return port_; }
+    uint64_t next_sequence() const { return expected_; }
+    const Stats &stats() const { return stats_; }
+
+private:
+    struct Pending {
+        std::vector<char> bytes;
+        uint64_t time_ns;
+    };
+
+    bool receive_batch();
+    std::span<const char> accept(const char *packet, size_t size, uint64_t time_ns);
+    std::span<const char> deliver(const char *packet, size_t size, const moldudp64::Header &header,
+                                  uint64_t time_ns);
+    void open_gap(uint64_t upto);
+    void send_request(uint64_t first, uint64_t count);
+
+    MoldUdpReceiverConfig config_;
+    int fd_ = -1;
+    uint16_t port_ = 0;
+    uint16_t request_port_ = 0;
+    sockaddr_in request_addr_{};
+
+    // recvmmsg slots
+    std::vector<char> buffers_;
+    std::vector<std::array<char, 64>> controls_;
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> headers_;
+    size_t received_ = 0;
+    size_t next_slot_ = 0;
+
+    // sequencing
+    std::array<char, moldudp64::SESSION_LENGTH> session_{};
+    bool have_session_ = false;
+    bool synced_ = false;
+    uint64_t expected_ = 0;                 // next sequence to deliver
+    uint64_t known_end_ = 0;                // one past the highest sequence announced so far
+    uint64_t gap_until_ = 0;                // a gap is open while expected_ < gap_until_
+    uint64_t gap_opened_ns_ = 0;
+    std::map<uint64_t, Pending> pending_;   // packets beyond a gap, by first sequence
+    Pending current_;                       // held packet being delivered
+    bool end_of_session_ = false;
+
+    uint64_t packet_time_ns_ = 0;
+    uint64_t last_packet_ns_ = 0;
+    GapCallback on_gap_;
+    std::atomic<bool> stop_{false};
+    Stats stats_;
+};
+
+struct MoldUdpPublisherConfig {
+    std::string address = "127.0.0.1";     // unicast or multicast destination
+    uint16_t port = 0;
+    std::string session = "LOCAL";
+    size_t max_payload = 1400;              // bytes of message blocks per packet
+    uint64_t messages_per_second = 0;       // 0 sends as fast as the socket takes them
+    int ttl = 1;                            // multicast hops
+    uint64_t drop_every = 0;                // skip sending every Nth packet (gap testing); 0 sends all
+    bool serve_requests = false;            // answer retransmission requests on request_port
+    uint16_t request_port = 0;              // 0 picks an ephemeral port (see request_port())
+    size_t history_packets = 1 << 16;       // packets kept for retransmission
+    uint64_t linger_ms = 0;                 // keep serving requests this long after the end of session
+};
+
+// Replays an ITCH stream as MoldUDP64, packing as many messages per packet
+// as fit in max_payload and finishing with an end-of-session packet. With a
+// request port it also answers retransmission requests for recent packets,
+// replying to the requester's address. Meant for loopback testing of
+// MoldUdpReceiver against recorded files.
+class MoldUdpPublisher
+{
+public:
+    struct Stats {
+        uint64_t messages = 0;
+        uint64_t packets = 0;
+        uint64_t dropped = 0;           // packets skipped by drop_every
+        uint64_t retransmitted = 0;     // packets resent on request
+    };
+
+    explicit MoldUdpPublisher(MoldUdpPublisherConfig config);
+    ~MoldUdpPublisher();
+
+    MoldUdpPublisher(const MoldUdpPublisher &) = delete;
+    MoldUdpPublisher &operator=(const MoldUdpPublisher &) = delete;
+
+    // Sends the whole stream; returns once the session has ended and the
+    // linger period is over
+    Stats run(BlockSource &source);
+
+    uint16_t request_port() const { return request_port_; }
+
+private:
+    struct Sent {
+        uint64_t sequence;
+        uint16_t count;
+        std::vector<char> bytes;
+    };
+
+    void flush();
+    void send_packet(const char *data, size_t size, bool droppable);
+    void serve_requests();
+    void pace();
+
+    MoldUdpPublisherConfig config_;
+    int fd_ = -1;
+    int request_fd_ = -1;
+    uint16_t request_port_ = 0;
+    sockaddr_in dest_{};
+
+    std::array<char, moldudp64::SESSION_LENGTH> session_{};
+    uint64_t next_sequence_ = 1;
+    std::vector<char> packet_;
+    uint16_t packet_count_ = 0;
+    std::deque<Sent> history_;
+
+    uint64_t start_ns_ = 0;
+    Stats stats_;
+};
@@ -0,0 +1,75 @@
+#ifndef ORDERBOOK_BOOKSTATS_H
+#define ORDERBOOK_BOOKSTATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Counter with a single writer (the thread that owns the book) and any number
+// of readers. The increment is a relaxed load + store, which compiles to a
+// plain add - no locked instruction on the hot path - while still letting a
+// stats thread read a torn-free value.
+class StatCounter {
+    private:
+        std::atomic<uint64_t> value{0};
+
+    public:
+        void add(uint64_t n = 1) {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void update_max(uint64_t candidate) {
+            if (candidate > value.load(std::memory_order_relaxed))
+                value.store(candidate, std::memory_order_relaxed);
+        }
+
+        uint64_t get() const { return value.load(std::memory_order_relaxed); }
+        void reset() { value.store(0, std::memory_order_relaxed); }
+};
+
+// Hot-path counters for one book. Aligned to its own cache lines so books
+// owned by different threads never false-share their counters.
+struct alignas(64) BookCounters {
+    StatCounter adds;
+    StatCounter cancels;
+    StatCounter reduces;
+    StatCounter replaces;
+    StatCounter fills;              // resting orders hit, by matching or executions
+    StatCounter filled_quantity;
+    StatCounter matches;            // incoming orders that traded on arrival
+    StatCounter levels_crossed;     // summed over matches
+    StatCounter max_levels_crossed;
+    StatCounter max_queue_depth;    // longest FIFO seen at any level
+};
+
+// Point-in-time copy of the counters plus memory accounting, produced by
+// LimitOrderBook::get_stats() on the owning thread.
+struct BookStats {
+    uint64_t adds = 0;
+    uint64_t cancels = 0;
+    uint64_t reduces = 0;
+    uint64_t replaces = 0;
+    uint64_t fills = 0;
+    uint64_t filled_quantity = 0;
+    uint64_t matches = 0;
+    uint64_t levels_crossed = 0;
+    uint64_t max_levels_crossed = 0;
+    uint64_t max_queue_depth = 0;
+
+    size_t pool_capacity = 0;
+    size_t pool_in_use = 0;
+    size_t pool_high_water = 0;
+
+    size_t id_index_size = 0;
+    size_t id_index_buckets = 0;
+    double id_index_load = 0.0;
+
+    size_t active_bid_levels = 0;
+    size_t active_ask_levels = 0;
+
+    size_t ladder_bytes = 0;        // level array plus per-level FIFO storage
+    size_t pool_bytes = 0;          // order slots plus free list
+    size_t id_index_bytes = 0;      // estimate: buckets plus nodes
+};
+
+#endif // ORDERBOOK_BOOKSTATS_H
@@ -0,0 +1,129 @@
+#include "LevelScan.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ORDERBOOK_LEVELSCAN_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace level_scan {
+namespace {
+
+int64_t sum_scalar(const int32_t* q, size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += q[i];
+    return total;
+}
+
+void prefix_sums_scalar(const int32_t* q, size_t n, int64_t* out, int64_t carry) {
+    for (size_t i = 0; i < n; ++i) {
+        carry += q[i];
+        out[i] = carry;
+    }
+}
+
+size_t find_cumulative_scalar(const int32_t* q, size_t from, size_t n, int64_t target,
+                              int64_t& before, int64_t& weighted) {
+    for (size_t i = from; i < n; ++i) {
+        if (before + q[i] >= target) return i;
+        before += q[i];
+        weighted += static_cast<int64_t>(q[i]) * static_cast<int64_t>(i);
+    }
+    return n;
+}
+
+#ifdef ORDERBOOK_LEVELSCAN_AVX2
+
+__attribute__((target("avx2")))
+int64_t hsum(__m256i v) {
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+__attribute__((target("avx2")))
+int64_t sum_avx2(const int32_t* q, size_t n) {
+    __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        lo = _mm256_add_epi64(lo, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i))));
+        hi = _mm256_add_epi64(hi, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i + 4))));
+    }
+    return hsum(_mm256_add_epi64(lo, hi)) + sum_scalar(q + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void prefix_sums_avx2(const int32_t* q, size_t n, int64_t* out) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry = zero;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        // in-register scan over four 64-bit lanes: shift by one lane, then two
+        __m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i)));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+        x = _mm256_add_epi64(x, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+        carry = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    prefix_sums_scalar(q + i, n - i, out + i, i ? out[i - 1] : 0);
+}
+
+__attribute__((target("avx2")))
+size_t find_cumulative_avx2(const int32_t* q, size_t n, int64_t target, int64_t& before, int64_t& weighted) {
+    // whole chunks of eight are added while the target stays out of reach;
+    // the chunk that reaches it is finished by the scalar loop
+    const __m256i lane_lo = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i lane_hi = _mm256_setr_epi64x(4, 5, 6, 7);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i lo = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i)));
+        const __m256i hi = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i + 4)));
+        const int64_t chunk = hsum(_mm256_add_epi64(lo, hi));
+        if (before + chunk >= target) break;
+
+        const int64_t lane_weighted = hsum(_mm256_add_epi64(_mm256_mul_epi32(lo, lane_lo), _mm256_mul_epi32(hi, lane_hi)));
+        weighted += lane_weighted + chunk * static_cast<int64_t>(i);
+        before += chunk;
+    }
+    return find_cumulative_scalar(q, i, n, target, before, weighted);
+}
+
+#endif
+
+// resolved during static initialisation, hence the explicit cpu_init
+const bool use_avx2 = [] {
+#ifdef ORDERBOOK_LEVELSCAN_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}();
+
+} // namespace
+
+bool simd() { return use_avx2; }
+
+int64_t sum(const int32_t* q, size_t n) {
+#ifdef ORDERBOOK_LEVELSCAN_AVX2
+    if (use_avx2) return sum_avx2(q, n);
+#endif
+    return sum_scalar(q, n);
+}
+
+void prefix_sums(const int32_t* q, size_t n, int64_t* out) {
+#ifdef ORDERBOOK_LEVELSCAN_AVX2
+    if (use_avx2) return prefix_sums_avx2(q, n, out);
+#endif
+    prefix_sums_scalar(q, n, out, 0);
+}
+
+size_t find_cumulative(const int32_t* q, size_t n, int64_t target, int64_t& before, int64_t& weighted) {
+    before = 0;
+    weighted = 0;
+#ifdef ORDERBOOK_LEVELSCAN_AVX2
+    if (use_avx2) return find_cumulative_avx2(q, n, target, before, weighted);
+#endif
+    return find_cumulative_scalar(q, 0, n, target, before, weighted);
+}
+
+} // namespace level_scan
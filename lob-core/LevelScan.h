@@ -0,0 +1,29 @@
+#ifndef ORDERBOOK_LEVELSCAN_H
+#define ORDERBOOK_LEVELSCAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels over a contiguous run of level totals (one int32 per tick, zero for
+// an empty level), used by the book's depth and market-impact queries. AVX2
+// versions are picked at runtime when the CPU has them; results are identical
+// to the scalar loops. Accumulation is in 64 bits throughout.
+namespace level_scan {
+
+// True when the AVX2 kernels are in use
+bool simd();
+
+// q[0] + ... + q[n-1]
+int64_t sum(const int32_t *q, size_t n);
+
+// out[i] = q[0] + ... + q[i]
+void prefix_sums(const int32_t *q, size_t n, int64_t *out);
+
+// Index of the first level at which the running total reaches `target`, or n
+// if it never does. `before` receives the total of the levels ahead of that
+// index and `weighted` the sum of q[i] * i over them.
+size_t find_cumulative(const int32_t *q, size_t n, int64_t target, int64_t &before, int64_t &weighted);
+
+} // namespace level_scan
+
+#endif // ORDERBOOK_LEVELSCAN_H
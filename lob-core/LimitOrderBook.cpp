@@ -1,9 +1,38 @@
 #include "LimitOrderBook.h"
+#include "LevelScan.h"
 #include <iostream>
 #include <functional>
 #include <optional>
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+void PriceLevel::rebuild_queue() {
+    const size_t live = orders.size();
+    const size_t capacity = std::max<size_t>(16, std::bit_ceil(2 * live));
+
+    // linear Fenwick build from the FIFO; partial sums must be pushed up
+    // through the empty tail as well
+    queue_tree.assign(capacity, 0);
+    for (size_t i = 0; i < capacity; ++i) {
+        if (i < live) {
+            orders[i]->queue_seq = static_cast<uint32_t>(i);
+            queue_tree[i] += orders[i]->quantity;
+        }
+        size_t parent = i | (i + 1);
+        if (parent < capacity) queue_tree[parent] += queue_tree[i];
+    }
+    next_seq = static_cast<uint32_t>(live);
+}
 
 void LimitOrderBook::process_order(int64_t order_id, double price, int32_t quantity, OrderSide side, 
+    const std::function<void(const Order&, const Order&, double, int32_t)>& onTrade) {
+    counters.adds.add();
+    add_order(order_id, price, quantity, side, onTrade);
+}
+
+void LimitOrderBook::add_order(int64_t order_id, double price, int32_t quantity, OrderSide side,
     const std::function<void(const Order&, const Order&, double, int32_t)>& onTrade) {
     price = std::round(price / TICK_SIZE) * TICK_SIZE;
     Order* new_order_ptr = order_pool.allocate();
@@ -16,6 +45,12 @@ void LimitOrderBook::process_order(int64_t order_id, double price, int32_t quant
     // try to match
     match(new_order_ptr, onTrade);
 
+    if (lifecycle) {
+        // fills taken on arrival count towards the fill ratio, not time to first fill
+        times(new_order_ptr) = {now_ns, quantity, quantity - new_order_ptr->quantity};
+        if (new_order_ptr->quantity == 0) ++lifecycle->filled_on_arrival;
+    }
+
     // if still has quantity, insert into book
     if (new_order_ptr->quantity > 0) {
         insert_order(new_order_ptr);
@@ -31,12 +66,16 @@ void LimitOrderBook::process_order(int64_t order_id, double price, int32_t quant
 }
 
 void LimitOrderBook::match(Order* incoming, const std::function<void(const Order&, const Order&, double, int32_t)>& onTrade) {
+    const int32_t initial_quantity = incoming->quantity;
+    uint64_t levels_touched = 0;
+
     if (incoming->side == OrderSide::Buy) {
         while (incoming->quantity > 0 && !active_asks.empty()) {
             size_t best_ask_idx = *active_asks.begin();
             double best_ask_price = min_price + best_ask_idx * TICK_SIZE;
 
             if (incoming->price + EPSILON < best_ask_price) break;
+            ++levels_touched;
 
             auto& level = price_levels[best_ask_idx];
             auto& orders_vec = level.orders;
@@ -50,14 +89,18 @@ void LimitOrderBook::match(Order* incoming, const std::function<void(const Order
                     incoming->quantity -= trade_qty;
                     resting->quantity -= trade_qty;
                     level.total_quantity -= trade_qty;
-                    total_trades++;
+                    ask_totals[best_ask_idx] -= trade_qty;
+                    level.queue_add(resting->queue_seq, -trade_qty);
+                    counters.fills.add();
 
                     if (onTrade) {
                         onTrade(*incoming, *resting, best_ask_price, trade_qty);
                     }
+                    if (lifecycle) on_resting_fill(resting, trade_qty);
                 }
 
                 if (resting->quantity == 0) {
+                    if (lifecycle) retire(resting, Exit::Filled);
                     orders_by_id.erase(resting->order_id);
                     order_pool.deallocate(resting);
                     it = orders_vec.erase(it);
@@ -76,6 +119,7 @@ void LimitOrderBook::match(Order* incoming, const std::function<void(const Order
             double best_bid_price = min_price + best_bid_idx * TICK_SIZE;
 
             if (incoming->price - EPSILON > best_bid_price) break;
+            ++levels_touched;
 
             auto& level = price_levels[best_bid_idx];
             auto& orders_vec = level.orders;
@@ -89,14 +133,18 @@ void LimitOrderBook::match(Order* incoming, const std::function<void(const Order
                     incoming->quantity -= trade_qty;
                     resting->quantity -= trade_qty;
                     level.total_quantity -= trade_qty;
-                    total_trades++;
+                    bid_totals[num_levels - 1 - best_bid_idx] -= trade_qty;
+                    level.queue_add(resting->queue_seq, -trade_qty);
+                    counters.fills.add();
 
                     if (onTrade) {
                         onTrade(*incoming, *resting, best_bid_price, trade_qty);
                     }
+                    if (lifecycle) on_resting_fill(resting, trade_qty);
                 }
 
                 if (resting->quantity == 0) {
+                    if (lifecycle) retire(resting, Exit::Filled);
                     orders_by_id.erase(resting->order_id);
                     order_pool.deallocate(resting);
                     it = orders_vec.erase(it);
@@ -110,6 +158,13 @@ void LimitOrderBook::match(Order* incoming, const std::function<void(const Order
             }
         }
     }
+
+    if (incoming->quantity != initial_quantity) {
+        counters.filled_quantity.add(initial_quantity - incoming->quantity);
+        counters.matches.add();
+        counters.levels_crossed.add(levels_touched);
+        counters.max_levels_crossed.update_max(levels_touched);
+    }
 }
 
 
@@ -123,21 +178,36 @@ void LimitOrderBook::insert_order(Order* incoming) {
     if (level.orders.empty()) {
         if (incoming->side == OrderSide::Buy) active_bids.insert(idx);
         else active_asks.insert(idx);
+        level.next_seq = 0;
     }
 
+    if (level.next_seq == level.queue_tree.size()) level.rebuild_queue();
+    incoming->queue_seq = level.next_seq++;
+    level.queue_add(incoming->queue_seq, incoming->quantity);
+
     level.orders.push_back(incoming);
     level.total_quantity += incoming->quantity;
+    side_total(incoming->side, idx) += incoming->quantity;
+    counters.max_queue_depth.update_max(level.orders.size());
 }
 
 void LimitOrderBook::cancel_order(int64_t order_id) {
     auto it = orders_by_id.find(order_id);
     if (it == orders_by_id.end()) return;
 
+    counters.cancels.add();
+    remove_order(it, Exit::Cancelled);
+}
+
+void LimitOrderBook::remove_order(std::pmr::unordered_map<int64_t, Order*>::iterator it, Exit how) {
     Order* order_ptr = it->second;
+    int64_t order_id = order_ptr->order_id;
     size_t idx = price_to_index(order_ptr->price);
     auto& level = price_levels[idx];
 
     level.total_quantity -= order_ptr->quantity;
+    side_total(order_ptr->side, idx) -= order_ptr->quantity;
+    level.queue_add(order_ptr->queue_seq, -order_ptr->quantity);
 
     auto& orders_vec = level.orders;
     for (size_t i = 0; i < orders_vec.size(); ++i) {
@@ -152,33 +222,162 @@ void LimitOrderBook::cancel_order(int64_t order_id) {
         else active_asks.erase(idx);
     }
 
+    if (lifecycle) retire(order_ptr, how);
     orders_by_id.erase(it);
     order_pool.deallocate(order_ptr);
 }
 
+void LimitOrderBook::decrement_order(std::pmr::unordered_map<int64_t, Order*>::iterator it, int32_t shares, bool fill) {
+    Order* order_ptr = it->second;
+
+    if (lifecycle && fill) on_resting_fill(order_ptr, std::min(shares, order_ptr->quantity));
+
+    if (shares >= order_ptr->quantity) {
+        remove_order(it, fill ? Exit::Filled : Exit::Cancelled);
+        return;
+    }
+
+    order_ptr->quantity -= shares;
+
+    const size_t idx = price_to_index(order_ptr->price);
+    auto& level = price_levels[idx];
+    level.total_quantity -= shares;
+    side_total(order_ptr->side, idx) -= shares;
+    level.queue_add(order_ptr->queue_seq, -shares);
+}
+
 void LimitOrderBook::reduce_order(int64_t order_id, int32_t cancelled_shares) {
     auto it = orders_by_id.find(order_id);
     if (it == orders_by_id.end()) return;
 
-    Order* order_ptr = it->second;
+    counters.reduces.add();
+    decrement_order(it, cancelled_shares, false);
+}
+
+void LimitOrderBook::execute_order(int64_t order_id, int32_t executed_shares) {
+    auto it = orders_by_id.find(order_id);
+    if (it == orders_by_id.end()) return;
+
+    counters.fills.add();
+    counters.filled_quantity.add(std::min(executed_shares, it->second->quantity));
+    decrement_order(it, executed_shares, true);
+}
+
+bool LimitOrderBook::replace_order(int64_t old_order_id, int64_t new_order_id, double price, int32_t quantity,
+    const std::function<void(const Order&, const Order&, double, int32_t)>& onTrade) {
+    auto it = orders_by_id.find(old_order_id);
+    if (it == orders_by_id.end()) return false;
+
+    OrderSide side = it->second->side;
+    counters.replaces.add();
+    remove_order(it, Exit::Replaced);
+    add_order(new_order_id, price, quantity, side, onTrade);
+    return true;
+}
 
-    if (cancelled_shares >= order_ptr->quantity) {
-        cancel_order(order_id);
+void LimitOrderBook::enable_lifecycle_stats() {
+    if (lifecycle) return;
+    lifecycle = std::make_unique<OrderLifecycleStats>();
+    order_times.assign(order_pool.capacity(), OrderTimes{});
+}
+
+void LimitOrderBook::enable_published_depth(size_t depth) {
+    if (depth == 0 || depth > DepthView::MAX_DEPTH)
+        throw std::invalid_argument("LimitOrderBook: published depth must be 1.." + std::to_string(DepthView::MAX_DEPTH));
+    published_levels = depth;
+    if (published) return;
+    published = std::make_unique<SeqLock<DepthView>>();
+    last_published = std::make_unique<DepthView>();
+}
+
+void LimitOrderBook::store_published_depth() {
+    DepthView next;
+    next.time = now_ns;
+    next.bid_levels = static_cast<uint32_t>(get_top_levels(OrderSide::Buy, published_levels, next.bids));
+    next.ask_levels = static_cast<uint32_t>(get_top_levels(OrderSide::Sell, published_levels, next.asks));
+
+    // most commands land behind the top levels; readers only see a new
+    // version when what they can observe moved
+    const DepthView& last = *last_published;
+    bool same = next.bid_levels == last.bid_levels && next.ask_levels == last.ask_levels;
+    for (uint32_t i = 0; same && i < next.bid_levels; ++i)
+        same = next.bids[i].price == last.bids[i].price && next.bids[i].quantity == last.bids[i].quantity;
+    for (uint32_t i = 0; same && i < next.ask_levels; ++i)
+        same = next.asks[i].price == last.asks[i].price && next.asks[i].quantity == last.asks[i].quantity;
+    if (same && published->version() > 0) return;
+
+    published->store(next);
+    *last_published = next;
+}
+
+void LimitOrderBook::on_resting_fill(const Order* order, int32_t shares) {
+    OrderTimes& t = times(order);
+    if (t.filled == 0) lifecycle->time_to_first_fill_ns.add(now_ns > t.added ? now_ns - t.added : 0);
+    t.filled += shares;
+}
+
+void LimitOrderBook::retire(const Order* order, Exit how) {
+    const OrderTimes& t = times(order);
+    const uint64_t lifetime = now_ns > t.added ? now_ns - t.added : 0;
+    lifecycle->fill_ratio_deciles[t.original > 0 ? 10 * int64_t{t.filled} / t.original : 0]++;
+
+    if (how == Exit::Filled) {
+        lifecycle->filled_lifetime_ns.add(lifetime);
+        ++lifecycle->fully_filled;
         return;
     }
 
-    order_ptr->quantity -= cancelled_shares;
-
-    size_t idx = price_to_index(order_ptr->price);
-    price_levels[idx].total_quantity -= cancelled_shares;
+    lifecycle->cancelled_lifetime_ns.add(lifetime);
+    if (t.filled > 0) ++lifecycle->cancelled_partial;
+    else ++lifecycle->cancelled_unfilled;
+    if (how == Exit::Replaced) ++lifecycle->replaced;
 }
 
 size_t LimitOrderBook::get_total_trades() const {
-    return total_trades;
+    return counters.fills.get();
 }
 
 void LimitOrderBook::reset_trade_counter() {
-    total_trades = 0;
+    counters.fills.reset();
+}
+
+BookStats LimitOrderBook::get_stats() const {
+    BookStats stats;
+    stats.adds = counters.adds.get();
+    stats.cancels = counters.cancels.get();
+    stats.reduces = counters.reduces.get();
+    stats.replaces = counters.replaces.get();
+    stats.fills = counters.fills.get();
+    stats.filled_quantity = counters.filled_quantity.get();
+    stats.matches = counters.matches.get();
+    stats.levels_crossed = counters.levels_crossed.get();
+    stats.max_levels_crossed = counters.max_levels_crossed.get();
+    stats.max_queue_depth = counters.max_queue_depth.get();
+
+    stats.pool_capacity = order_pool.capacity();
+    stats.pool_in_use = order_pool.allocated();
+    stats.pool_high_water = order_pool.high_water_mark();
+    stats.pool_bytes = order_pool.memory_bytes();
+
+    stats.id_index_size = orders_by_id.size();
+    stats.id_index_buckets = orders_by_id.bucket_count();
+    stats.id_index_load = orders_by_id.load_factor();
+    // node = key/value pair + next pointer + cached hash (libstdc++ layout)
+    stats.id_index_bytes = orders_by_id.bucket_count() * sizeof(void*) +
+        orders_by_id.size() * (sizeof(std::pair<const int64_t, Order*>) + 2 * sizeof(void*));
+
+    stats.active_bid_levels = active_bids.size();
+    stats.active_ask_levels = active_asks.size();
+
+    // emptied levels keep their FIFO capacity, so walk the whole ladder
+    size_t ladder = price_levels.capacity() * sizeof(PriceLevel) +
+        (ask_totals.capacity() + bid_totals.capacity()) * sizeof(int32_t);
+    for (const auto& level : price_levels) {
+        ladder += level.orders.capacity() * sizeof(Order*) + level.queue_tree.capacity() * sizeof(int64_t);
+    }
+    stats.ladder_bytes = ladder;
+
+    return stats;
 }
 
 std::optional<OrderSide> LimitOrderBook::get_side(int64_t order_id) {
@@ -217,4 +416,143 @@ LimitOrderBook::BestLevel LimitOrderBook::get_best_bid() const {
         price_levels[best_bid_idx].total_quantity,
         true
     };
-}
\ No newline at end of file
+}
+
+int32_t LimitOrderBook::level_quantity(OrderSide side, double price) const {
+    const auto& level = price_levels[price_to_index(price)];
+    if (level.orders.empty() || level.orders.front()->side != side) return 0;
+    return level.total_quantity;
+}
+
+std::optional<int64_t> LimitOrderBook::queue_ahead(int64_t order_id) const {
+    auto it = orders_by_id.find(order_id);
+    if (it == orders_by_id.end()) return std::nullopt;
+
+    const Order* order = it->second;
+    return price_levels[price_to_index(order->price)].queue_prefix(order->queue_seq);
+}
+
+size_t LimitOrderBook::get_top_levels(OrderSide side, size_t depth, BestLevel* out) const {
+    size_t written = 0;
+
+    if (side == OrderSide::Buy) {
+        for (auto it = active_bids.rbegin(); it != active_bids.rend() && written < depth; ++it) {
+            out[written++] = {min_price + *it * TICK_SIZE, price_levels[*it].total_quantity, true};
+        }
+    } else {
+        for (auto it = active_asks.begin(); it != active_asks.end() && written < depth; ++it) {
+            out[written++] = {min_price + *it * TICK_SIZE, price_levels[*it].total_quantity, true};
+        }
+    }
+
+    return written;
+}
+
+
+const char* LimitOrderBook::check_top_of_book() const {
+    if (!active_bids.empty()) {
+        size_t best_bid_idx = *active_bids.rbegin();
+        if (price_levels[best_bid_idx].total_quantity <= 0) return "non-positive quantity at best bid";
+        if (!active_asks.empty() && best_bid_idx >= *active_asks.begin()) return "crossed book";
+    }
+    if (!active_asks.empty() && price_levels[*active_asks.begin()].total_quantity <= 0) {
+        return "non-positive quantity at best ask";
+    }
+    return nullptr;
+}
+
+bool LimitOrderBook::check_invariants(std::string* error) const {
+    auto fail = [error](std::string what) {
+        if (error) *error = std::move(what);
+        return false;
+    };
+
+    if (const char* top = check_top_of_book()) return fail(top);
+
+    for (size_t idx = 0; idx < price_levels.size(); ++idx) {
+        const auto& level = price_levels[idx];
+        int64_t sum = 0;
+        for (const Order* o : level.orders) {
+            if (o->quantity <= 0) return fail("non-positive order quantity at index " + std::to_string(idx));
+            sum += o->quantity;
+        }
+        if (sum != level.total_quantity) return fail("level total mismatch at index " + std::to_string(idx));
+        const int32_t mirrored = ask_totals[idx] + bid_totals[num_levels - 1 - idx];
+        if (mirrored != level.total_quantity || (ask_totals[idx] && bid_totals[num_levels - 1 - idx]))
+            return fail("side totals out of sync at index " + std::to_string(idx));
+        if (!level.orders.empty() && level.queue_prefix(level.next_seq) != sum)
+            return fail("queue tree out of sync at index " + std::to_string(idx));
+
+        bool listed = active_bids.count(idx) || active_asks.count(idx);
+        if (listed == level.orders.empty()) return fail("active set out of sync at index " + std::to_string(idx));
+    }
+
+    return true;
+}
+
+LimitOrderBook::Impact LimitOrderBook::market_impact(OrderSide taker_side, int64_t quantity) const {
+    Impact impact;
+    const bool buy = taker_side == OrderSide::Buy;
+    if (quantity <= 0 || (buy ? active_asks.empty() : active_bids.empty())) return impact;
+
+    // populated region of the resting side, best level first
+    const size_t best = buy ? *active_asks.begin() : *active_bids.rbegin();
+    const size_t worst = buy ? *active_asks.rbegin() : *active_bids.begin();
+    const int32_t* q = buy ? &ask_totals[best] : &bid_totals[num_levels - 1 - best];
+    const size_t span = (buy ? worst - best : best - worst) + 1;
+
+    int64_t before = 0, weighted = 0;
+    const size_t last = level_scan::find_cumulative(q, span, quantity, before, weighted);
+
+    // shares at k ticks from best pay best_price +/- k ticks
+    const double best_price = min_price + best * TICK_SIZE;
+    const double direction = buy ? TICK_SIZE : -TICK_SIZE;
+    int64_t filled = before;
+    double notional = before * best_price + weighted * direction;
+    size_t offset = last;
+    if (last < span) {
+        const int64_t take = quantity - before;
+        filled += take;
+        notional += take * (best_price + last * direction);
+        impact.complete = true;
+    } else {
+        // side exhausted; the worst populated level was the last one touched
+        offset = span - 1;
+    }
+
+    impact.filled = filled;
+    impact.notional = notional;
+    impact.average_price = notional / filled;
+    impact.worst_price = best_price + offset * direction;
+    for (size_t k = 0; k <= offset; ++k) impact.levels += q[k] != 0;
+    return impact;
+}
+
+int64_t LimitOrderBook::depth_within_bps(OrderSide side, double bps) const {
+    const bool bid = side == OrderSide::Buy;
+    if (!(bps >= 0.0) || (bid ? active_bids.empty() : active_asks.empty())) return 0;
+
+    const size_t best = bid ? *active_bids.rbegin() : *active_asks.begin();
+    const size_t worst = bid ? *active_bids.begin() : *active_asks.rbegin();
+    const double best_price = min_price + best * TICK_SIZE;
+    // clamped in floating point: a band wider than the side would overflow size_t
+    const double band = std::floor(best_price * bps / 10000.0 / TICK_SIZE + EPSILON);
+    const size_t populated = (bid ? best - worst : worst - best) + 1;
+    const size_t span = band + 1 >= static_cast<double>(populated) ? populated : static_cast<size_t>(band) + 1;
+
+    const int32_t* q = bid ? &bid_totals[num_levels - 1 - best] : &ask_totals[best];
+    return level_scan::sum(q, span);
+}
+
+size_t LimitOrderBook::depth_curve(OrderSide side, size_t ticks, int64_t* out) const {
+    const bool bid = side == OrderSide::Buy;
+    if (ticks == 0 || (bid ? active_bids.empty() : active_asks.empty())) return 0;
+
+    const size_t best = bid ? *active_bids.rbegin() : *active_asks.begin();
+    const size_t worst = bid ? *active_bids.begin() : *active_asks.rbegin();
+    const size_t span = std::min(ticks, (bid ? best - worst : worst - best) + 1);
+
+    const int32_t* q = bid ? &bid_totals[num_levels - 1 - best] : &ask_totals[best];
+    level_scan::prefix_sums(q, span, out);
+    return span;
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Order.h"
+#include "BookStats.h"
+#include "OrderLifecycle.h"
+#include "SeqLock.h"
 #include <vector>
 #include <set>
 #include <list>
@@ -9,6 +12,9 @@
 #include <MemoryPool.h>
 #include <cmath>
 #include <optional>
+#include <memory>
+#include <string>
+#include <memory_resource>
 
 // Represents a collection of orders at a single price level
 class PriceLevel
@@ -17,6 +23,31 @@ public:
     // Use a list to maintain Price-Time Priority
     std::vector<Order *> orders;
     int32_t total_quantity = 0;
+
+    // Fenwick tree over arrival slots (Order::queue_seq) holding each resting
+    // order's remaining quantity, so shares queued ahead of an order is a
+    // prefix sum. Slots are handed out in FIFO order and renumbered only when
+    // they run out; an empty level sums to zero and simply restarts at slot 0.
+    std::vector<int64_t> queue_tree;
+    uint32_t next_seq = 0;
+
+    void queue_add(uint32_t seq, int64_t delta)
+    {
+        for (size_t i = seq; i < queue_tree.size(); i |= i + 1)
+            queue_tree[i] += delta;
+    }
+
+    // Sum of remaining quantity in slots [0, seq)
+    int64_t queue_prefix(uint32_t seq) const
+    {
+        int64_t sum = 0;
+        for (int64_t i = static_cast<int64_t>(seq) - 1; i >= 0; i = (i & (i + 1)) - 1)
+            sum += queue_tree[i];
+        return sum;
+    }
+
+    // Renumbers the live orders 0..n-1 and rebuilds the tree with room to grow
+    void rebuild_queue();
 };
 
 class LimitOrderBook
@@ -32,10 +63,38 @@ private:
     std::vector<PriceLevel> price_levels;
     MemoryPool<Order> order_pool;
 
-    static inline size_t total_trades = 0;
+    BookCounters counters;
+
+    // Level totals laid out contiguously per side, best price first once the
+    // best index is known: asks by ladder index, bids mirrored (num_levels - 1
+    // - index) so both sides are scanned upwards. Mirrors
+    // PriceLevel::total_quantity; the depth and impact queries read only these.
+    std::vector<int32_t> ask_totals;
+    std::vector<int32_t> bid_totals;
 
-    std::set<size_t> active_bids; // indices of price levels with buy orders
-    std::set<size_t> active_asks; // indices of price levels with sell orders
+    // Exchange clock and optional lifecycle tracking; order_times is indexed
+    // by order pool slot
+    uint64_t now_ns = 0;
+    std::unique_ptr<OrderLifecycleStats> lifecycle;
+    std::vector<OrderTimes> order_times;
+
+    enum class Exit { Filled, Cancelled, Replaced };
+    OrderTimes &times(const Order *order) { return order_times[order_pool.index_of(order)]; }
+    void on_resting_fill(const Order *order, int32_t shares);
+    void retire(const Order *order, Exit how);
+
+    int32_t &side_total(OrderSide side, size_t idx)
+    {
+        return side == OrderSide::Buy ? bid_totals[num_levels - 1 - idx] : ask_totals[idx];
+    }
+
+    // Recycles the tree and hash nodes below, so once the book has seen its
+    // working set of orders and levels the hot path stops calling operator new.
+    // Declared before the containers that draw from it.
+    std::pmr::unsynchronized_pool_resource node_pool{std::pmr::pool_options{0, 64}};
+
+    std::pmr::set<size_t> active_bids{&node_pool}; // indices of price levels with buy orders
+    std::pmr::set<size_t> active_asks{&node_pool}; // indices of price levels with sell orders
 
     size_t price_to_index(double price) const
     {
@@ -52,9 +111,13 @@ private:
         return static_cast<size_t>(rounded);
     }
 
+    void add_order(int64_t order_id, double price, int32_t quantity, OrderSide side,
+                   const std::function<void(const Order &, const Order &, double, int32_t)> &onTrade);
     void match(Order *incoming,
                const std::function<void(const Order &, const Order &, double, int32_t)> &onTrade = nullptr);
     void insert_order(Order *incoming);
+    void remove_order(std::pmr::unordered_map<int64_t, Order *>::iterator it, Exit how);
+    void decrement_order(std::pmr::unordered_map<int64_t, Order *>::iterator it, int32_t shares, bool fill);
 
 public:
     // For GUI feedback
@@ -64,9 +127,24 @@ public:
         bool valid = false;
     };
 
-    std::unordered_map<int64_t, Order *> orders_by_id;
+    // Top levels of both sides as of the end of one command, copied out for
+    // readers on other threads (see enable_published_depth)
+    struct DepthView {
+        static constexpr size_t MAX_DEPTH = 10;
+        uint64_t time = 0;          // book clock of the command that produced it
+        uint32_t bid_levels = 0;
+        uint32_t ask_levels = 0;
+        BestLevel bids[MAX_DEPTH];  // best price first
+        BestLevel asks[MAX_DEPTH];
+    };
+
+    std::pmr::unordered_map<int64_t, Order *> orders_by_id{&node_pool};
+
+    static constexpr double tick_size() { return TICK_SIZE; }
+
     explicit LimitOrderBook(double min_price, double max_price, size_t pool_size = 1'000'000)
-        : min_price(min_price), max_price(max_price), num_levels((max_price - min_price) / TICK_SIZE + 1), price_levels(num_levels), order_pool(pool_size)
+        : min_price(min_price), max_price(max_price), num_levels((max_price - min_price) / TICK_SIZE + 1), price_levels(num_levels), order_pool(pool_size),
+          ask_totals(num_levels, 0), bid_totals(num_levels, 0)
     {
         orders_by_id.reserve(100'000);
     }
@@ -78,14 +156,113 @@ public:
 
     void cancel_order(int64_t order_id);
     void reduce_order(int64_t order_id, int32_t cancelled_shares);
+    // Same book effect as reduce_order, but counted as a fill (ITCH E/C messages)
+    void execute_order(int64_t order_id, int32_t executed_shares);
+    // Cancels old_order_id and submits new_order_id on the same side. Returns
+    // false (and does nothing) if the old order is unknown.
+    bool replace_order(int64_t old_order_id, int64_t new_order_id, double price, int32_t quantity,
+                       const std::function<void(const Order &, const Order &, double, int32_t)> &onTrade = nullptr);
     std::optional<OrderSide> get_side(int64_t order_id);
 
     // Getter for vector of price levels
     const std::vector<PriceLevel> &get_price_levels() const { return price_levels; }
 
+    // Exchange time (ns since midnight) stamped on orders as they enter and
+    // leave the book; MatchingEngine::apply sets it from each command
+    void set_time(uint64_t ns) { now_ns = ns; }
+    uint64_t time() const { return now_ns; }
+
+    // Starts per-order lifecycle tracking (lifetimes, time to first fill, fill
+    // ratio). Call before the first order; costs a 16-byte side-table slot per
+    // pool entry and O(1) work per fill and per order exit.
+    void enable_lifecycle_stats();
+    const OrderLifecycleStats *lifecycle_stats() const { return lifecycle.get(); }
+
+    // Faults in the pool storage the first `orders` orders will use (the
+    // ladder is written by the constructor already). Call before the first
+    // order, typically on the thread that builds the book.
+    void prefault(size_t orders) { order_pool.prefault(orders); }
+
+    // Keeps a copy of the top `depth` levels (at most DepthView::MAX_DEPTH)
+    // behind a sequence lock, so other threads can read a consistent BBO and
+    // depth while the owner keeps mutating the book. Call before the book is
+    // shared; the owner refreshes the copy with publish_depth().
+    void enable_published_depth(size_t depth);
+
+    // Owner thread only, between mutations (MatchingEngine calls it after
+    // every command). Never waits; stores only when the levels changed.
+    void publish_depth()
+    {
+        if (published) store_published_depth();
+    }
+
+    // Any thread. Copies the latest published view; false if publishing is
+    // off or every attempt overlapped a publish.
+    bool read_depth(DepthView &out) const { return published && published->try_load(out); }
+    // Any thread. Views published so far; unchanged means nothing to re-read.
+    uint64_t depth_version() const { return published ? published->version() : 0; }
+
     size_t get_total_trades() const;
     void reset_trade_counter();
 
+    // Live counters, safe to read from another thread
+    const BookCounters &get_counters() const { return counters; }
+    // Counters plus memory accounting; walks the ladder, so call it from the
+    // owning thread and not per message
+    BookStats get_stats() const;
+
     BestLevel get_best_bid() const;
     BestLevel get_best_ask() const;
+
+    // O(1) sanity check of the top of book, cheap enough to run after every
+    // command. Returns nullptr when healthy, else a description of the problem.
+    const char *check_top_of_book() const;
+
+    // O(levels) check: every level total matches its FIFO and is non-negative,
+    // and the active bid/ask sets agree with the ladder.
+    bool check_invariants(std::string *error = nullptr) const;
+
+    // Resting quantity at `price` on `side`; 0 if the level is empty or holds
+    // the other side
+    int32_t level_quantity(OrderSide side, double price) const;
+
+    // Shares resting ahead of `order_id` at its price level, or nullopt if
+    // the order is not in the book. O(log n) in the level's queue length.
+    std::optional<int64_t> queue_ahead(int64_t order_id) const;
+
+    // Copies up to `depth` levels of one side into `out`, best price first.
+    // Returns the number of levels written.
+    size_t get_top_levels(OrderSide side, size_t depth, BestLevel *out) const;
+
+    // Result of sweeping the book with a marketable order
+    struct Impact {
+        int64_t filled = 0;         // shares available up to the requested size
+        double notional = 0.0;      // sum of price * shares over the sweep
+        double average_price = 0.0;
+        double worst_price = 0.0;   // last level touched
+        size_t levels = 0;          // price levels touched
+        bool complete = false;      // the side held the full size
+    };
+
+    // Cost of a `taker_side` order for `quantity` shares taking liquidity at
+    // any price (a buy walks the asks). Scans only the populated region.
+    Impact market_impact(OrderSide taker_side, int64_t quantity) const;
+
+    // Resting shares on `side` priced within `bps` basis points of that side's
+    // best price (inclusive); 0 for an empty side or a negative `bps`
+    int64_t depth_within_bps(OrderSide side, double bps) const;
+
+    // Cumulative resting shares on `side` at 0..ticks-1 ticks from its best
+    // price: out[k] holds everything within k ticks. Stops at the last
+    // populated level and returns the number of entries written.
+    size_t depth_curve(OrderSide side, size_t ticks, int64_t *out) const;
+
+private:
+    void store_published_depth();
+
+    // Optional top-of-book copy for other threads, and the owner's last
+    // stored view to compare against
+    std::unique_ptr<SeqLock<DepthView>> published;
+    std::unique_ptr<DepthView> last_published;
+    size_t published_levels = 0;
 };
\ No newline at end of file
@@ -1,36 +1,68 @@
 #ifndef ORDERBOOK_MEMORYPOOL_H
 #define ORDERBOOK_MEMORYPOOL_H
 
-#include <vector>
-#include <stack>
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
 
 template <typename T>
 class MemoryPool {
     private:
-        std::vector<T> pool;            // actual storage - contiguous
-        std::stack<size_t> free_list;   // stack of free indexes in pool
+        // Slots come from the stack of returned ones first, then fresh from
+        // the front of the storage (a bump pointer). Neither array is written
+        // up front, so a pool costs one allocation each and its pages are
+        // faulted in only as it fills, or ahead of time through prefault().
+        std::unique_ptr<T[]> pool;
+        // stack of free indexes in pool; sized for the worst case so pushes
+        // never allocate
+        std::unique_ptr<size_t[]> free_list;
+        size_t slots;
+        size_t next_fresh = 0;
+        size_t free_count = 0;
+        size_t in_use = 0;
+        size_t high_water = 0;
 
     public:
-        explicit MemoryPool(size_t capacity) {
-            pool.resize(capacity);
-            for (size_t i = 0; i < capacity; i++) {
-                free_list.push(i);
-            }
-        }
+        explicit MemoryPool(size_t capacity)
+            : pool(new T[capacity]), free_list(new size_t[capacity]), slots(capacity) {}
 
         T* allocate() {
-            if (free_list.empty()) {
+            size_t idx;
+            if (free_count > 0) {
+                idx = free_list[--free_count];
+            } else if (next_fresh < slots) {
+                idx = next_fresh++;
+            } else {
                 throw std::runtime_error("MemoryPool exhausted!");
             }
-            size_t idx = free_list.top();
-            free_list.pop();
+            if (++in_use > high_water) high_water = in_use;
             return &pool[idx];
         }
 
         void deallocate(T* ptr) {
             size_t idx = ptr - &pool[0];
-            free_list.push(idx);
+            free_list[free_count++] = idx;
+            --in_use;
+        }
+
+        // Writes the first `count` slots (the next ones the bump pointer hands
+        // out) and their free-list entries, so the first orders of a book do
+        // not page-fault. Meant for a background builder before the pool is
+        // shared with the thread that allocates from it.
+        void prefault(size_t count) {
+            count = std::min(count, slots);
+            std::fill_n(pool.get(), count, T{});
+            std::fill_n(free_list.get(), count, size_t{0});
         }
+
+        // Slot number of a pointer handed out by allocate(), for side tables
+        size_t index_of(const T* ptr) const { return ptr - pool.get(); }
+
+        size_t capacity() const { return slots; }
+        size_t allocated() const { return in_use; }
+        size_t high_water_mark() const { return high_water; }
+
+        // Slots plus the free-list entries that index them
+        size_t memory_bytes() const { return slots * (sizeof(T) + sizeof(size_t)); }
 };
-#endif // ORDERBOOK_MEMORYPOOL_H
\ No newline at end of file
+#endif // ORDERBOOK_MEMORYPOOL_H
@@ -13,6 +13,7 @@ struct Order {
     double price;
     int32_t quantity;
     OrderSide side;
+    uint32_t queue_seq;     // arrival slot within its price level (see PriceLevel)
 };
 
 #endif // ORDERBOOK_ORDER_H
\ No newline at end of file
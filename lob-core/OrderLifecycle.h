@@ -0,0 +1,66 @@
+#ifndef ORDERBOOK_ORDERLIFECYCLE_H
+#define ORDERBOOK_ORDERLIFECYCLE_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Counts per power-of-two bucket: bucket 0 holds zero, bucket k holds
+// [2^(k-1), 2^k). Adding is a bit_width and an increment.
+struct Log2Histogram {
+    static constexpr size_t BUCKETS = 65;
+
+    std::array<uint64_t, BUCKETS> counts{};
+    uint64_t total = 0;
+    uint64_t max = 0;
+
+    void add(uint64_t value) {
+        ++counts[std::bit_width(value)];
+        ++total;
+        if (value > max) max = value;
+    }
+
+    // Smallest value v with at least `fraction` of the samples <= v, to
+    // bucket precision (the upper edge of the bucket it falls in); 0 if empty
+    uint64_t quantile(double fraction) const {
+        if (total == 0) return 0;
+        const double rank = fraction * static_cast<double>(total);
+        uint64_t seen = 0;
+        for (size_t k = 0; k < BUCKETS; ++k) {
+            seen += counts[k];
+            if (seen > 0 && static_cast<double>(seen) >= rank)
+                return k == 0 ? 0 : (k == 64 ? max : std::min<uint64_t>(max, (uint64_t{1} << k) - 1));
+        }
+        return max;
+    }
+};
+
+// Per-order bookkeeping, kept beside the order pool only while lifecycle
+// stats are enabled so Order itself stays small.
+struct OrderTimes {
+    uint64_t added = 0;         // exchange ns when the order entered the book
+    int32_t original = 0;       // quantity on entry
+    int32_t filled = 0;         // shares filled so far, aggressor fills included
+};
+
+// How orders left the book, in exchange time. Updated in O(1) as each order
+// dies; nothing here needs a second pass over the data.
+struct OrderLifecycleStats {
+    Log2Histogram filled_lifetime_ns;       // entry -> last share filled
+    Log2Histogram cancelled_lifetime_ns;    // entry -> cancelled, reduced to zero or replaced
+    Log2Histogram time_to_first_fill_ns;    // entry -> first fill, resting orders only
+
+    // Share of the original quantity filled when the order died, in 10%
+    // steps (index 10 = fully filled)
+    std::array<uint64_t, 11> fill_ratio_deciles{};
+
+    uint64_t filled_on_arrival = 0;         // fully filled by matching, never rested
+    uint64_t fully_filled = 0;
+    uint64_t cancelled_unfilled = 0;
+    uint64_t cancelled_partial = 0;         // cancelled after some fills
+    uint64_t replaced = 0;                  // subset of the cancels, via replace_order
+};
+
+#endif // ORDERBOOK_ORDERLIFECYCLE_H
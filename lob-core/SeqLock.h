@@ -0,0 +1,64 @@
+#ifndef ORDERBOOK_SEQLOCK_H
+#define ORDERBOOK_SEQLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Sequence lock around a trivially copyable value with a single writer (the
+// thread that owns the book) and any number of readers. The writer never
+// waits; a reader that overlaps a write retries. The payload is kept in
+// relaxed atomic words, so the racing copies are well defined, and the type
+// has no pointers, so it also works when placed in shared memory.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock payload must be trivially copyable");
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    public:
+        void store(const T& value) {
+            uint64_t buf[WORDS] = {};
+            std::memcpy(buf, &value, sizeof(T));
+
+            const uint64_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORDS; ++i)
+                words[i].store(buf[i], std::memory_order_relaxed);
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        // False if every attempt overlapped a write
+        bool try_load(T& out, int attempts = 64) const {
+            uint64_t buf[WORDS];
+            for (int a = 0; a < attempts; ++a) {
+                const uint64_t before = sequence.load(std::memory_order_acquire);
+                if (before & 1) continue;
+                for (size_t i = 0; i < WORDS; ++i)
+                    buf[i] = words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == before) {
+                    std::memcpy(&out, buf, sizeof(T));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        T load() const {
+            T out;
+            while (!try_load(out)) {}
+            return out;
+        }
+
+        // Number of completed stores
+        uint64_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+    private:
+        alignas(64) std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> words[WORDS] = {};
+};
+
+#endif // ORDERBOOK_SEQLOCK_H
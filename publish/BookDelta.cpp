@@ -0,0 +1,110 @@
+#include "BookDelta.h"
+
+#include <cstring>
+
+namespace book_delta {
+
+namespace {
+
+void put_le(std::string& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i)
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+}
+
+uint64_t get_le(const char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        v = (v << 8) | static_cast<uint8_t>(p[i]);
+    return v;
+}
+
+void put_entry(std::string& out, uint8_t slot, int32_t price, int32_t qty) {
+    out.push_back(static_cast<char>(slot));
+    put_le(out, static_cast<uint32_t>(price), 4);
+    put_le(out, static_cast<uint32_t>(qty), 4);
+}
+
+// A level past the side's level count reads as empty
+void level(const BookSnapshot& s, bool ask, size_t i, int32_t& price, int32_t& qty) {
+    const size_t count = ask ? s.ask_levels : s.bid_levels;
+    price = i < count ? (ask ? s.ask_price[i] : s.bid_price[i]) : 0;
+    qty = i < count ? (ask ? s.ask_qty[i] : s.bid_qty[i]) : 0;
+}
+
+} // namespace
+
+bool encode(const BookSnapshot* prev, const BookSnapshot& cur, size_t depth, std::string& out) {
+    const size_t start = out.size();
+    out.push_back(static_cast<char>(prev ? DELTA : FULL));
+    put_le(out, cur.locate, 2);
+    put_le(out, cur.timestamp, 8);
+    out.push_back(0);   // entry count, patched below
+
+    uint8_t entries = 0;
+    for (int side = 0; side < 2; ++side) {
+        const bool ask = side == 1;
+        for (size_t i = 0; i < depth; ++i) {
+            int32_t price, qty;
+            level(cur, ask, i, price, qty);
+            if (prev) {
+                int32_t old_price, old_qty;
+                level(*prev, ask, i, old_price, old_qty);
+                if (price == old_price && qty == old_qty) continue;
+            }
+            put_entry(out, static_cast<uint8_t>((ask ? ASK_SLOT : 0) + i), price, qty);
+            ++entries;
+        }
+    }
+    if (!prev || cur.last_price != prev->last_price || cur.last_qty != prev->last_qty) {
+        put_entry(out, TRADE_SLOT, cur.last_price, cur.last_qty);
+        ++entries;
+    }
+
+    if (prev && entries == 0) {
+        out.resize(start);
+        return false;
+    }
+    out[start + HEADER_SIZE - 1] = static_cast<char>(entries);
+    return true;
+}
+
+bool apply(BookSnapshot& state, const char* data, size_t length) {
+    if (length < HEADER_SIZE) return false;
+    const uint8_t kind = static_cast<uint8_t>(data[0]);
+    const uint8_t entries = static_cast<uint8_t>(data[HEADER_SIZE - 1]);
+    if ((kind != FULL && kind != DELTA) || length != HEADER_SIZE + entries * ENTRY_SIZE) return false;
+
+    if (kind == FULL) state = BookSnapshot{};
+    state.locate = static_cast<uint16_t>(get_le(data + 1, 2));
+    state.timestamp = get_le(data + 3, 8);
+
+    const char* p = data + HEADER_SIZE;
+    for (uint8_t e = 0; e < entries; ++e, p += ENTRY_SIZE) {
+        const uint8_t slot = static_cast<uint8_t>(p[0]);
+        const int32_t price = static_cast<int32_t>(get_le(p + 1, 4));
+        const int32_t qty = static_cast<int32_t>(get_le(p + 5, 4));
+
+        if (slot == TRADE_SLOT) {
+            state.last_price = price;
+            state.last_qty = qty;
+            continue;
+        }
+        const bool ask = slot >= ASK_SLOT;
+        const size_t i = slot - (ask ? ASK_SLOT : 0);
+        if (i >= BookSnapshot::MAX_DEPTH) return false;
+        (ask ? state.ask_price : state.bid_price)[i] = price;
+        (ask ? state.ask_qty : state.bid_qty)[i] = qty;
+    }
+
+    // levels are contiguous from the best price, so the count is the first gap
+    auto count = [](const int32_t* qty) {
+        uint8_t n = 0;
+        while (n < BookSnapshot::MAX_DEPTH && qty[n] != 0) ++n;
+        return n;
+    };
+    state.bid_levels = count(state.bid_qty);
+    state.ask_levels = count(state.ask_qty);
+    return true;
+}
+
+} // namespace book_delta
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "MarketState.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Binary book update sent to dashboard clients (little endian):
+//
+//   u8  kind        FULL (every slot present) or DELTA (changed slots only)
+//   u16 locate
+//   u64 timestamp
+//   u8  entry count
+//   entries: u8 slot, i32 price ticks, i32 quantity
+//
+// Slots 0..9 are bid levels, 64..73 ask levels and 128 the last trade. A
+// level entry with quantity 0 means the level is gone.
+namespace book_delta {
+
+inline constexpr uint8_t FULL = 1;
+inline constexpr uint8_t DELTA = 2;
+inline constexpr uint8_t ASK_SLOT = 64;
+inline constexpr uint8_t TRADE_SLOT = 128;
+inline constexpr size_t HEADER_SIZE = 12;
+inline constexpr size_t ENTRY_SIZE = 9;
+
+// Appends an update taking a client from `prev` to `cur` (a FULL one when
+// `prev` is null). Returns false, appending nothing, if nothing changed.
+bool encode(const BookSnapshot *prev, const BookSnapshot &cur, size_t depth, std::string &out);
+
+// Applies one encoded update to `state`; false if the message is malformed
+bool apply(BookSnapshot &state, const char *data, size_t length);
+
+} // namespace book_delta
@@ -0,0 +1,509 @@
+#include "DashboardServer.h"
+#include "BookDelta.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr size_t MAX_REQUEST_BYTES = 8192;
+
+const char *PAGE = R"HTML(<!doctype html>
+<html><head><meta charset="utf-8"><title>ITCH replay</title>
+<style>
+body{font-family:monospace;background:#111;color:#ddd;margin:2em}
+table{border-collapse:collapse}td,th{padding:2px 12px;text-align:right}
+.b{color:#6c6}.a{color:#e66}#last{margin-top:1em}
+</style></head>
+<body>
+<h3>ITCH replay <select id="sym"></select> <span id="ts"></span></h3>
+<table><thead><tr><th>bid qty</th><th>bid</th><th>ask</th><th>ask qty</th></tr></thead><tbody id="book"></tbody></table>
+<div id="last"></div>
+<script>
+const ws = new WebSocket(`ws://${location.host}/ws`);
+ws.binaryType = 'arraybuffer';
+const sel = document.getElementById('sym');
+let cur = null, locate = -1, locates = {};
+let st;
+function reset() { st = {bp: [], bq: [], ap: [], aq: [], lp: 0, lq: 0}; }
+reset();
+sel.onchange = () => {
+  if (cur) ws.send('unsub ' + cur);
+  cur = sel.value; locate = locates[cur]; reset(); render(0);
+  ws.send('sub ' + cur);
+};
+const px = t => (t / 100).toFixed(2);
+function clock(ns) {
+  const ms = Math.floor(ns / 1e6), h = Math.floor(ms / 3.6e6), m = Math.floor(ms / 6e4) % 60;
+  const s = Math.floor(ms / 1000) % 60, pad = (v, n) => String(v).padStart(n, '0');
+  return `${pad(h, 2)}:${pad(m, 2)}:${pad(s, 2)}.${pad(ms % 1000, 3)}`;
+}
+function render(ts) {
+  let rows = '';
+  for (let i = 0; i < 10; i++) {
+    const b = st.bq[i] > 0, a = st.aq[i] > 0;
+    if (!b && !a) continue;
+    rows += `<tr><td class="b">${b ? st.bq[i] : ''}</td><td class="b">${b ? px(st.bp[i]) : ''}</td>` +
+            `<td class="a">${a ? px(st.ap[i]) : ''}</td><td class="a">${a ? st.aq[i] : ''}</td></tr>`;
+  }
+  document.getElementById('book').innerHTML = rows;
+  document.getElementById('last').textContent = st.lq ? `last ${st.lq} @ ${px(st.lp)}` : '';
+  document.getElementById('ts').textContent = ts ? clock(ts) : '';
+}
+ws.onmessage = e => {
+  if (typeof e.data === 'string') {
+    const m = JSON.parse(e.data);
+    if (!m.symbols) return;
+    locates = {};
+    for (const [s, l] of m.symbols) locates[s] = l;
+    const keep = sel.value;
+    sel.innerHTML = m.symbols.map(([s]) => `<option>${s}</option>`).join('');
+    if (keep) sel.value = keep; else if (m.symbols.length) sel.onchange();
+    return;
+  }
+  const v = new DataView(e.data);
+  if (v.getUint16(1, true) !== locate) return;
+  if (v.getUint8(0) === 1) reset();
+  const n = v.getUint8(11);
+  for (let i = 0, o = 12; i < n; i++, o += 9) {
+    const s = v.getUint8(o), p = v.getInt32(o + 1, true), q = v.getInt32(o + 5, true);
+    if (s === 128) { st.lp = p; st.lq = q; }
+    else if (s >= 64) { st.ap[s - 64] = p; st.aq[s - 64] = q; }
+    else { st.bp[s] = p; st.bq[s] = q; }
+  }
+  render(Number(v.getBigUint64(3, true)));
+};
+</script></body></html>
+)HTML";
+
+void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+std::string lower(std::string s)
+{
+    for (char &c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// Value of `name` (lower case) in a raw header block, or empty
+std::string header_value(const std::string &headers, const std::string &name)
+{
+    size_t pos = 0;
+    while ((pos = headers.find("\r\n", pos)) != std::string::npos)
+    {
+        pos += 2;
+        size_t colon = headers.find(':', pos);
+        size_t eol = headers.find("\r\n", pos);
+        if (colon == std::string::npos || eol == std::string::npos || colon > eol)
+            continue;
+        if (lower(headers.substr(pos, colon - pos)) != name)
+            continue;
+        size_t start = headers.find_first_not_of(' ', colon + 1);
+        return start < eol ? headers.substr(start, eol - start) : std::string();
+    }
+    return {};
+}
+
+// Client text quoted back inside a JSON string
+std::string json_escape(const std::string &s)
+{
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string http_response(const std::string &status, const std::string &type, const std::string &body)
+{
+    return "HTTP/1.1 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n" + body;
+}
+
+} // namespace
+
+DashboardServer::DashboardServer(MarketStateStore &store, uint16_t port, std::chrono::milliseconds push_interval,
+                                 const std::string &bind_address)
+    : store_(store), push_interval_(push_interval)
+{
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0)
+        throw std::runtime_error("dashboard: socket() failed");
+
+    int one = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (::inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1)
+    {
+        ::close(listen_fd_);
+        throw std::runtime_error("dashboard: bad bind address " + bind_address);
+    }
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd_, 16) != 0)
+    {
+        std::string why = std::strerror(errno);
+        ::close(listen_fd_);
+        throw std::runtime_error("dashboard: cannot listen on " + bind_address + ":" + std::to_string(port) + ": " + why);
+    }
+    set_nonblocking(listen_fd_);
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    if (::pipe(wake_pipe_) != 0)
+    {
+        ::close(listen_fd_);
+        throw std::runtime_error("dashboard: pipe() failed");
+    }
+    set_nonblocking(wake_pipe_[0]);
+}
+
+DashboardServer::~DashboardServer()
+{
+    stop();
+    for (auto &client : clients_)
+        ::close(client->fd);
+    ::close(listen_fd_);
+    ::close(wake_pipe_[0]);
+    ::close(wake_pipe_[1]);
+}
+
+void DashboardServer::start()
+{
+    if (running_.exchange(true))
+        return;
+    thread_ = std::thread([this] { run(); });
+}
+
+void DashboardServer::stop()
+{
+    if (!running_.exchange(false))
+        return;
+    char byte = 0;
+    [[maybe_unused]] ssize_t n = ::write(wake_pipe_[1], &byte, 1);
+    thread_.join();
+}
+
+void DashboardServer::run()
+{
+    using clock = std::chrono::steady_clock;
+    auto next_push = clock::now() + push_interval_;
+    std::vector<pollfd> fds;
+
+    while (running_.load(std::memory_order_relaxed))
+    {
+        fds.clear();
+        fds.push_back({listen_fd_, POLLIN, 0});
+        fds.push_back({wake_pipe_[0], POLLIN, 0});
+        for (const auto &client : clients_)
+            fds.push_back({client->fd, static_cast<short>(POLLIN | (client->out.empty() ? 0 : POLLOUT)), 0});
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_push - clock::now()).count();
+        ::poll(fds.data(), fds.size(), static_cast<int>(std::max<int64_t>(wait, 0)));
+
+        if (fds[1].revents & POLLIN)
+        {
+            char drain[64];
+            while (::read(wake_pipe_[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (fds[0].revents & POLLIN)
+            accept_clients();
+
+        // clients accepted this round have no pollfd yet
+        for (size_t i = 2; i < fds.size(); ++i)
+        {
+            Client &client = *clients_[i - 2];
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                read_client(client);
+            if (!client.dead && (fds[i].revents & POLLOUT))
+                write_client(client);
+        }
+
+        if (clock::now() >= next_push)
+        {
+            for (auto &client : clients_)
+            {
+                if (client->websocket && !client->dead && !client->close_after_write)
+                {
+                    push_updates(*client);
+                    write_client(*client);
+                }
+            }
+            next_push = clock::now() + push_interval_;
+        }
+
+        for (auto &client : clients_)
+        {
+            if (client->dead)
+                close_client(*client);
+        }
+        std::erase_if(clients_, [](const std::unique_ptr<Client> &c) { return c->fd < 0; });
+        client_count_.store(clients_.size(), std::memory_order_relaxed);
+    }
+}
+
+void DashboardServer::accept_clients()
+{
+    while (true)
+    {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0)
+            return;
+        set_nonblocking(fd);
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+        clients_.push_back(std::move(client));
+    }
+}
+
+void DashboardServer::read_client(Client &client)
+{
+    char buf[4096];
+    while (true)
+    {
+        ssize_t n = ::recv(client.fd, buf, sizeof(buf), 0);
+        if (n > 0)
+        {
+            client.in.append(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            client.dead = true;
+        break;
+    }
+    if (client.dead)
+        return;
+
+    if (!client.websocket)
+    {
+        handle_http(client);
+        // a client may pipeline its first frames behind the upgrade request
+        if (!client.websocket || client.dead)
+            return;
+    }
+
+    size_t pos = 0;
+    websocket::Frame frame;
+    while (!client.dead && !client.close_after_write)
+    {
+        size_t used = websocket::parse_frame(std::string_view(client.in).substr(pos), frame);
+        if (used == 0)
+            break;
+        if (used == std::numeric_limits<size_t>::max())
+        {
+            client.dead = true;
+            break;
+        }
+        pos += used;
+        handle_frame(client, frame);
+    }
+    client.in.erase(0, pos);
+}
+
+void DashboardServer::write_client(Client &client)
+{
+    while (!client.out.empty())
+    {
+        ssize_t n = ::send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (n > 0)
+        {
+            client.out.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            client.dead = true;
+        return;
+    }
+    if (client.close_after_write)
+        client.dead = true;
+}
+
+void DashboardServer::handle_http(Client &client)
+{
+    size_t end = client.in.find("\r\n\r\n");
+    if (end == std::string::npos)
+    {
+        if (client.in.size() > MAX_REQUEST_BYTES)
+            client.dead = true;
+        return;
+    }
+
+    const std::string headers = client.in.substr(0, end + 2);
+    client.in.erase(0, end + 4);
+
+    const size_t sp1 = headers.find(' ');
+    const size_t sp2 = headers.find(' ', sp1 + 1);
+    const std::string method = headers.substr(0, sp1);
+    const std::string path = sp1 == std::string::npos ? "" : headers.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    client.close_after_write = true;
+    if (method != "GET")
+    {
+        client.out += http_response("405 Method Not Allowed", "text/plain", "GET only\n");
+    }
+    else if (path == "/" || path == "/index.html")
+    {
+        client.out += http_response("200 OK", "text/html; charset=utf-8", PAGE);
+    }
+    else if (path == "/ws" && lower(header_value(headers, "upgrade")) == "websocket" &&
+             !header_value(headers, "sec-websocket-key").empty())
+    {
+        client.out += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                      "Sec-WebSocket-Accept: " +
+                      websocket::accept_key(header_value(headers, "sec-websocket-key")) + "\r\n\r\n";
+        client.websocket = true;
+        client.close_after_write = false;
+        send_symbols(client);
+    }
+    else
+    {
+        client.out += http_response("404 Not Found", "text/plain", "not found\n");
+    }
+    write_client(client);
+}
+
+void DashboardServer::handle_frame(Client &client, const websocket::Frame &frame)
+{
+    // RFC 6455 requires clients to mask every frame. Commands are short and
+    // never fragmented, so a fragment is treated as a protocol error as well
+    // rather than parsed as a partial command.
+    if (!frame.masked || !frame.fin || frame.opcode == websocket::CONTINUATION)
+    {
+        websocket::append_frame(client.out, websocket::CLOSE, std::string("\x03\xea", 2)); // 1002
+        client.close_after_write = true;
+        return;
+    }
+
+    switch (frame.opcode)
+    {
+    case websocket::CLOSE:
+        websocket::append_frame(client.out, websocket::CLOSE, frame.payload.substr(0, 2));
+        client.close_after_write = true;
+        return;
+    case websocket::PING:
+        websocket::append_frame(client.out, websocket::PONG, frame.payload);
+        return;
+    case websocket::TEXT:
+        break;
+    default:
+        return;
+    }
+
+    const std::string &text = frame.payload;
+    const size_t space = text.find(' ');
+    const std::string verb = text.substr(0, space);
+    const std::string symbol = space == std::string::npos ? "" : text.substr(space + 1);
+
+    auto locate = store_.find(symbol);
+    if (!locate)
+    {
+        websocket::append_frame(client.out, websocket::TEXT, "{\"error\":\"unknown symbol " + json_escape(symbol) + "\"}");
+        return;
+    }
+
+    auto it = std::find_if(client.subs.begin(), client.subs.end(),
+                           [&](const Subscription &s) { return s.locate == *locate; });
+    if (verb == "sub" && it == client.subs.end())
+    {
+        Subscription sub;
+        sub.locate = *locate;
+        client.subs.push_back(sub);
+        store_.watch(*locate);
+    }
+    else if (verb == "unsub" && it != client.subs.end())
+    {
+        client.subs.erase(it);
+        store_.unwatch(*locate);
+    }
+}
+
+void DashboardServer::push_updates(Client &client)
+{
+    if (client.symbols_generation != store_.symbols_generation())
+        send_symbols(client);
+
+    std::string payload;
+    for (auto &sub : client.subs)
+    {
+        // conflation: a client still draining earlier output waits for the
+        // next round and then gets one diff against what it actually has
+        if (client.out.size() >= MAX_PENDING_BYTES)
+            return;
+
+        const uint64_t version = store_.version(sub.locate);
+        if (sub.have_sent && version == sub.sent_version)
+            continue;
+
+        BookSnapshot snap;
+        if (!store_.read(sub.locate, snap))
+            continue;
+
+        payload.clear();
+        if (book_delta::encode(sub.have_sent ? &sub.sent : nullptr, snap, store_.depth(), payload))
+            websocket::append_frame(client.out, websocket::BINARY, payload);
+        sub.sent = snap;
+        sub.sent_version = version;
+        sub.have_sent = true;
+    }
+}
+
+void DashboardServer::send_symbols(Client &client)
+{
+    client.symbols_generation = store_.symbols_generation();
+
+    auto symbols = store_.symbols();
+    std::sort(symbols.begin(), symbols.end(), [](const auto &a, const auto &b) { return a.second < b.second; });
+
+    std::string json = "{\"symbols\":[";
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        if (i)
+            json += ',';
+        json += "[\"" + json_escape(symbols[i].second) + "\"," + std::to_string(symbols[i].first) + "]";
+    }
+    json += "]}";
+    websocket::append_frame(client.out, websocket::TEXT, json);
+}
+
+void DashboardServer::close_client(Client &client)
+{
+    for (const auto &sub : client.subs)
+        store_.unwatch(sub.locate);
+    client.subs.clear();
+    ::close(client.fd);
+    client.fd = -1;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "MarketState.h"
+#include "WebSocket.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Embedded HTTP / WebSocket server for watching books during a replay.
+//
+//   GET /     a small self-contained page (symbol picker + L2 ladder)
+//   GET /ws   WebSocket; the server sends a JSON symbol list as text, the
+//             client sends "sub SYM" / "unsub SYM", and the server pushes
+//             book_delta binary frames for each subscribed symbol
+//
+// Everything runs on one I/O thread with non-blocking sockets and poll().
+// Updates are conflated per client: every push interval the server diffs
+// the latest MarketStateStore snapshot against what that client last
+// received, and a client with unsent output gets nothing new until it
+// drains. A slow browser therefore sees fewer, larger jumps rather than a
+// growing backlog, and the replay thread never waits on any of it.
+class DashboardServer
+{
+public:
+    // Binds and listens immediately (port 0 picks a free port); throws
+    // std::runtime_error if the socket cannot be set up
+    DashboardServer(MarketStateStore &store, uint16_t port,
+                    std::chrono::milliseconds push_interval = std::chrono::milliseconds(50),
+                    const std::string &bind_address = "127.0.0.1");
+    ~DashboardServer();
+
+    DashboardServer(const DashboardServer &) = delete;
+    DashboardServer &operator=(const DashboardServer &) = delete;
+
+    void start();
+    void stop();
+
+    uint16_t port() const { return port_; }
+    size_t client_count() const { return client_count_.load(std::memory_order_relaxed); }
+
+    // Output a client may have queued before it stops receiving updates
+    static constexpr size_t MAX_PENDING_BYTES = 64 * 1024;
+
+private:
+    struct Subscription {
+        uint16_t locate = 0;
+        uint64_t sent_version = 0;
+        bool have_sent = false;
+        BookSnapshot sent;
+    };
+
+    struct Client {
+        int fd = -1;
+        bool websocket = false;
+        bool close_after_write = false;
+        bool dead = false;
+        std::string in;
+        std::string out;
+        std::vector<Subscription> subs;
+        uint64_t symbols_generation = 0;
+    };
+
+    void run();
+    void accept_clients();
+    void read_client(Client &client);
+    void write_client(Client &client);
+    void handle_http(Client &client);
+    void handle_frame(Client &client, const websocket::Frame &frame);
+    void push_updates(Client &client);
+    void send_symbols(Client &client);
+    void close_client(Client &client);
+
+    MarketStateStore &store_;
+    std::chrono::milliseconds push_interval_;
+    int listen_fd_ = -1;
+    int wake_pipe_[2] = {-1, -1};
+    uint16_t port_ = 0;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::vector<std::unique_ptr<Client>> clients_;
+    std::atomic<size_t> client_count_{0};
+};
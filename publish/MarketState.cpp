@@ -0,0 +1,122 @@
+#include "MarketState.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+int32_t to_ticks(double price)
+{
+    return static_cast<int32_t>(std::llround(price / LimitOrderBook::tick_size()));
+}
+
+} // namespace
+
+MarketStateStore::MarketStateStore(size_t depth)
+    : depth_(std::clamp<size_t>(depth, 1, BookSnapshot::MAX_DEPTH)),
+      slots_(new std::atomic<Slot *>[UINT16_MAX + 1])
+{
+    for (size_t i = 0; i <= UINT16_MAX; ++i)
+        slots_[i].store(nullptr, std::memory_order_relaxed);
+}
+
+MarketStateStore::~MarketStateStore()
+{
+    for (size_t i = 0; i <= UINT16_MAX; ++i)
+        delete slots_[i].load(std::memory_order_relaxed);
+}
+
+void MarketStateStore::add_symbol(uint16_t locate, const std::string &symbol)
+{
+    if (slots_[locate].load(std::memory_order_relaxed))
+        return;
+
+    auto *slot = new Slot();
+    BookSnapshot empty;
+    empty.locate = locate;
+    slot->state.store(empty);
+    slots_[locate].store(slot, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(symbols_mutex_);
+    symbols_.emplace_back(locate, symbol);
+    symbols_generation_.fetch_add(1, std::memory_order_release);
+}
+
+void MarketStateStore::record_trade(uint16_t locate, double price, int32_t quantity)
+{
+    Slot *slot = slots_[locate].load(std::memory_order_relaxed);
+    if (!slot)
+        return;
+    slot->last_price = to_ticks(price);
+    slot->last_qty = quantity;
+}
+
+void MarketStateStore::publish_now(uint16_t locate, const LimitOrderBook &book, uint64_t timestamp)
+{
+    Slot *slot = slots_[locate].load(std::memory_order_relaxed);
+
+    LimitOrderBook::BestLevel levels[BookSnapshot::MAX_DEPTH];
+    BookSnapshot snap;
+    snap.locate = locate;
+    snap.timestamp = timestamp;
+    snap.sequence = ++slot->sequence;
+    snap.last_price = slot->last_price;
+    snap.last_qty = slot->last_qty;
+
+    snap.bid_levels = static_cast<uint8_t>(book.get_top_levels(OrderSide::Buy, depth_, levels));
+    for (size_t i = 0; i < snap.bid_levels; ++i)
+    {
+        snap.bid_price[i] = to_ticks(levels[i].price);
+        snap.bid_qty[i] = levels[i].quantity;
+    }
+    snap.ask_levels = static_cast<uint8_t>(book.get_top_levels(OrderSide::Sell, depth_, levels));
+    for (size_t i = 0; i < snap.ask_levels; ++i)
+    {
+        snap.ask_price[i] = to_ticks(levels[i].price);
+        snap.ask_qty[i] = levels[i].quantity;
+    }
+
+    slot->state.store(snap);
+}
+
+bool MarketStateStore::read(uint16_t locate, BookSnapshot &out) const
+{
+    const Slot *slot = slots_[locate].load(std::memory_order_acquire);
+    return slot && slot->state.try_load(out);
+}
+
+uint64_t MarketStateStore::version(uint16_t locate) const
+{
+    const Slot *slot = slots_[locate].load(std::memory_order_acquire);
+    return slot ? slot->state.version() : 0;
+}
+
+void MarketStateStore::watch(uint16_t locate)
+{
+    if (Slot *slot = slots_[locate].load(std::memory_order_acquire))
+        slot->watchers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MarketStateStore::unwatch(uint16_t locate)
+{
+    if (Slot *slot = slots_[locate].load(std::memory_order_acquire))
+        slot->watchers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::vector<std::pair<uint16_t, std::string>> MarketStateStore::symbols() const
+{
+    std::lock_guard<std::mutex> lock(symbols_mutex_);
+    return symbols_;
+}
+
+std::optional<uint16_t> MarketStateStore::find(const std::string &symbol) const
+{
+    std::lock_guard<std::mutex> lock(symbols_mutex_);
+    for (const auto &[locate, name] : symbols_)
+    {
+        if (name == symbol)
+            return locate;
+    }
+    return std::nullopt;
+}
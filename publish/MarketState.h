@@ -0,0 +1,100 @@
+#pragma once
+
+#include "LimitOrderBook.h"
+#include "SeqLock.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Latest published view of one book. Prices are in book ticks (0.01) so the
+// struct stays small and fixed size.
+struct BookSnapshot {
+    static constexpr size_t MAX_DEPTH = 10;
+
+    uint64_t timestamp = 0;     // ITCH ns since midnight of the last update
+    uint64_t sequence = 0;      // publishes so far for this symbol
+    int32_t bid_price[MAX_DEPTH] = {};
+    int32_t bid_qty[MAX_DEPTH] = {};
+    int32_t ask_price[MAX_DEPTH] = {};
+    int32_t ask_qty[MAX_DEPTH] = {};
+    int32_t last_price = 0;     // last trade, 0 until one happens
+    int32_t last_qty = 0;
+    uint16_t locate = 0;
+    uint8_t bid_levels = 0;
+    uint8_t ask_levels = 0;
+};
+
+// Conflated per-symbol state shared between the replay thread (the only
+// writer) and readers such as DashboardServer. Each symbol holds only its
+// latest snapshot behind a SeqLock: publishing never blocks or allocates,
+// and readers that fall behind simply see the newest state.
+//
+// Publishing is skipped for symbols nobody watches, so a full-market replay
+// only pays for the books someone has open.
+class MarketStateStore
+{
+public:
+    explicit MarketStateStore(size_t depth = 5);
+    ~MarketStateStore();
+
+    MarketStateStore(const MarketStateStore &) = delete;
+    MarketStateStore &operator=(const MarketStateStore &) = delete;
+
+    // --- writer (replay thread) ---
+    void add_symbol(uint16_t locate, const std::string &symbol);
+
+    bool watched(uint16_t locate) const
+    {
+        const Slot *slot = slots_[locate].load(std::memory_order_acquire);
+        return slot && slot->watchers.load(std::memory_order_relaxed) > 0;
+    }
+
+    // Snapshots the top of `book` if anyone watches `locate`
+    void publish(uint16_t locate, const LimitOrderBook &book, uint64_t timestamp)
+    {
+        if (watched(locate))
+            publish_now(locate, book, timestamp);
+    }
+
+    // Folded into the next publish for the symbol
+    void record_trade(uint16_t locate, double price, int32_t quantity);
+
+    // --- readers (any thread) ---
+    size_t depth() const { return depth_; }
+    bool read(uint16_t locate, BookSnapshot &out) const;
+    // Completed publishes for `locate` (0 if unknown)
+    uint64_t version(uint16_t locate) const;
+
+    void watch(uint16_t locate);
+    void unwatch(uint16_t locate);
+
+    std::vector<std::pair<uint16_t, std::string>> symbols() const;
+    std::optional<uint16_t> find(const std::string &symbol) const;
+    // Bumped whenever a symbol is added
+    uint64_t symbols_generation() const { return symbols_generation_.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        SeqLock<BookSnapshot> state;
+        std::atomic<uint32_t> watchers{0};
+        // writer-only
+        int32_t last_price = 0;
+        int32_t last_qty = 0;
+        uint64_t sequence = 0;
+    };
+
+    void publish_now(uint16_t locate, const LimitOrderBook &book, uint64_t timestamp);
+
+    size_t depth_;
+    std::unique_ptr<std::atomic<Slot *>[]> slots_;
+
+    mutable std::mutex symbols_mutex_;
+    std::vector<std::pair<uint16_t, std::string>> symbols_;
+    std::atomic<uint64_t> symbols_generation_{0};
+};
@@ -0,0 +1,225 @@
+#include "SharedBook.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shared_book {
+
+namespace {
+
+constexpr size_t align_up(size_t n, size_t a) {
+    return (n + a - 1) / a * a;
+}
+
+constexpr size_t symbols_offset() {
+    return align_up(sizeof(Header), 64);
+}
+
+constexpr size_t slots_offset() {
+    return align_up(symbols_offset() + SLOT_COUNT * sizeof(SymbolEntry), 4096);
+}
+
+} // namespace
+
+size_t segment_size() {
+    return slots_offset() + SLOT_COUNT * sizeof(Slot);
+}
+
+} // namespace shared_book
+
+namespace {
+
+int32_t to_ticks(double price) {
+    return static_cast<int32_t>(std::llround(price / LimitOrderBook::tick_size()));
+}
+
+bool same_book(const BookSnapshot& a, const BookSnapshot& b, size_t depth) {
+    if (a.bid_levels != b.bid_levels || a.ask_levels != b.ask_levels) return false;
+    if (a.last_price != b.last_price || a.last_qty != b.last_qty) return false;
+    for (size_t i = 0; i < depth; ++i) {
+        if (a.bid_price[i] != b.bid_price[i] || a.bid_qty[i] != b.bid_qty[i] ||
+            a.ask_price[i] != b.ask_price[i] || a.ask_qty[i] != b.ask_qty[i])
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------- Publisher ----------
+
+SharedBookPublisher::SharedBookPublisher(const std::string& name, size_t depth, bool unlink_on_close)
+    : name_(name), depth_(std::clamp<size_t>(depth, 1, BookSnapshot::MAX_DEPTH)),
+      unlink_on_close_(unlink_on_close), last_(shared_book::SLOT_COUNT) {
+    // start from a fresh, zeroed segment so stale readers never see old data
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        throw std::runtime_error("cannot create shared memory " + name + ": " + std::strerror(errno));
+
+    map_size_ = shared_book::segment_size();
+    if (::ftruncate(fd, static_cast<off_t>(map_size_)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("cannot size shared memory " + name);
+    }
+    map_ = ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("cannot map shared memory " + name);
+    }
+
+    // ftruncate zero-fills, which is a valid initial state for every atomic
+    // and SeqLock in the segment; only the header needs values
+    char* base = static_cast<char*>(map_);
+    header_ = new (base) shared_book::Header{};
+    header_->version = shared_book::VERSION;
+    header_->depth = static_cast<uint32_t>(depth_);
+    header_->slot_count = shared_book::SLOT_COUNT;
+    header_->slot_size = sizeof(shared_book::Slot);
+    header_->symbols_offset = shared_book::symbols_offset();
+    header_->slots_offset = shared_book::slots_offset();
+    header_->writer_pid.store(static_cast<uint32_t>(::getpid()), std::memory_order_relaxed);
+    symbols_ = reinterpret_cast<shared_book::SymbolEntry*>(base + shared_book::symbols_offset());
+    slots_ = reinterpret_cast<shared_book::Slot*>(base + shared_book::slots_offset());
+
+    std::memcpy(header_->magic, shared_book::MAGIC, sizeof(header_->magic));
+    header_->ready.store(1, std::memory_order_release);
+}
+
+SharedBookPublisher::~SharedBookPublisher() {
+    if (map_) ::munmap(map_, map_size_);
+    if (unlink_on_close_) ::shm_unlink(name_.c_str());
+}
+
+void SharedBookPublisher::add_symbol(uint16_t locate, const std::string& symbol) {
+    shared_book::SymbolEntry& entry = symbols_[locate];
+    if (entry.ready.load(std::memory_order_relaxed)) return;
+
+    std::memset(entry.symbol, ' ', sizeof(entry.symbol));
+    std::memcpy(entry.symbol, symbol.data(), std::min(symbol.size(), sizeof(entry.symbol)));
+
+    BookSnapshot empty;
+    empty.locate = locate;
+    slots_[locate].state.store(empty);
+    last_[locate] = std::make_unique<LastState>();
+    last_[locate]->published = empty;
+
+    entry.ready.store(1, std::memory_order_release);
+}
+
+void SharedBookPublisher::record_trade(uint16_t locate, double price, int32_t quantity) {
+    LastState* last = last_[locate].get();
+    if (!last) return;
+    last->last_price = to_ticks(price);
+    last->last_qty = quantity;
+    last->trade_pending = true;
+}
+
+bool SharedBookPublisher::publish(uint16_t locate, const LimitOrderBook& book, uint64_t timestamp) {
+    LastState* last = last_[locate].get();
+    if (!last) return false;
+
+    LimitOrderBook::BestLevel levels[BookSnapshot::MAX_DEPTH];
+    BookSnapshot snap;
+    snap.locate = locate;
+    snap.timestamp = timestamp;
+    snap.last_price = last->last_price;
+    snap.last_qty = last->last_qty;
+
+    snap.bid_levels = static_cast<uint8_t>(book.get_top_levels(OrderSide::Buy, depth_, levels));
+    for (size_t i = 0; i < snap.bid_levels; ++i) {
+        snap.bid_price[i] = to_ticks(levels[i].price);
+        snap.bid_qty[i] = levels[i].quantity;
+    }
+    snap.ask_levels = static_cast<uint8_t>(book.get_top_levels(OrderSide::Sell, depth_, levels));
+    for (size_t i = 0; i < snap.ask_levels; ++i) {
+        snap.ask_price[i] = to_ticks(levels[i].price);
+        snap.ask_qty[i] = levels[i].quantity;
+    }
+
+    // a repeated trade at the same price and size still counts as a change
+    if (!last->trade_pending && same_book(snap, last->published, depth_)) return false;
+
+    snap.sequence = last->published.sequence + 1;
+    slots_[locate].state.store(snap);
+    last->published = snap;
+    last->trade_pending = false;
+    header_->heartbeat.store(header_->heartbeat.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+}
+
+// ---------- Reader ----------
+
+SharedBookReader::SharedBookReader(const std::string& name) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw std::runtime_error("cannot open shared memory " + name + ": " + std::strerror(errno));
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < shared_book::segment_size()) {
+        ::close(fd);
+        throw std::runtime_error("shared memory " + name + " is not a book segment");
+    }
+    map_size_ = static_cast<size_t>(st.st_size);
+    map_ = ::mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        throw std::runtime_error("cannot map shared memory " + name);
+    }
+
+    const char* base = static_cast<const char*>(map_);
+    header_ = reinterpret_cast<const shared_book::Header*>(base);
+    if (header_->ready.load(std::memory_order_acquire) == 0 ||
+        std::memcmp(header_->magic, shared_book::MAGIC, sizeof(header_->magic)) != 0 ||
+        header_->version != shared_book::VERSION || header_->slot_size != sizeof(shared_book::Slot) ||
+        header_->slot_count != shared_book::SLOT_COUNT) {
+        ::munmap(map_, map_size_);
+        map_ = nullptr;
+        throw std::runtime_error("shared memory " + name + " has an unknown layout");
+    }
+    symbols_ = reinterpret_cast<const shared_book::SymbolEntry*>(base + header_->symbols_offset);
+    slots_ = reinterpret_cast<const shared_book::Slot*>(base + header_->slots_offset);
+}
+
+SharedBookReader::~SharedBookReader() {
+    if (map_) ::munmap(map_, map_size_);
+}
+
+bool SharedBookReader::has_symbol(uint16_t locate) const {
+    return symbols_[locate].ready.load(std::memory_order_acquire) != 0;
+}
+
+std::vector<std::pair<uint16_t, std::string>> SharedBookReader::symbols() const {
+    std::vector<std::pair<uint16_t, std::string>> out;
+    for (size_t locate = 0; locate < shared_book::SLOT_COUNT; ++locate) {
+        if (!has_symbol(static_cast<uint16_t>(locate))) continue;
+        std::string symbol(symbols_[locate].symbol, sizeof(symbols_[locate].symbol));
+        while (!symbol.empty() && symbol.back() == ' ') symbol.pop_back();
+        out.emplace_back(static_cast<uint16_t>(locate), std::move(symbol));
+    }
+    return out;
+}
+
+std::optional<uint16_t> SharedBookReader::find(const std::string& symbol) const {
+    for (const auto& [locate, name] : symbols()) {
+        if (name == symbol) return locate;
+    }
+    return std::nullopt;
+}
+
+bool SharedBookReader::read(uint16_t locate, BookSnapshot& out) const {
+    if (!has_symbol(locate)) return false;
+    return slots_[locate].state.try_load(out);
+}
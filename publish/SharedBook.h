@@ -0,0 +1,122 @@
+#pragma once
+
+#include "MarketState.h"
+#include "SeqLock.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// POSIX shared-memory segment of per-locate book state, for other processes
+// on the box. The layout is a fixed header, a symbol table and a flat array
+// of 65536 cache-line-aligned SeqLock<BookSnapshot> slots indexed by stock
+// locate, so a reader finds any symbol with one array index and reads it
+// with no syscalls or locks. Only pages of locates actually written are
+// ever touched.
+namespace shared_book {
+
+inline constexpr char MAGIC[8] = {'I', 'T', 'C', 'H', 'S', 'H', 'M', '1'};
+inline constexpr uint32_t VERSION = 1;
+inline constexpr size_t SLOT_COUNT = UINT16_MAX + 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t depth;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    uint64_t symbols_offset;
+    uint64_t slots_offset;
+    std::atomic<uint64_t> heartbeat;    // publishes so far, to spot a stalled writer
+    std::atomic<uint32_t> writer_pid;
+    std::atomic<uint32_t> ready;        // stored last; the other fields are valid once set
+};
+
+struct SymbolEntry {
+    char symbol[8];                     // space padded
+    std::atomic<uint32_t> ready;        // set after `symbol` is written
+    uint32_t reserved;
+};
+
+struct alignas(64) Slot {
+    SeqLock<BookSnapshot> state;
+};
+
+size_t segment_size();
+
+} // namespace shared_book
+
+// Writer side; owned by the replay thread. Publishing compares the new top
+// of book with what this slot last held and only stores when it changed.
+class SharedBookPublisher
+{
+public:
+    // `name` is a POSIX shm name such as "/itch_books". An existing segment
+    // of that name is replaced. Throws std::runtime_error on failure.
+    explicit SharedBookPublisher(const std::string &name, size_t depth = 5, bool unlink_on_close = true);
+    ~SharedBookPublisher();
+
+    SharedBookPublisher(const SharedBookPublisher &) = delete;
+    SharedBookPublisher &operator=(const SharedBookPublisher &) = delete;
+
+    void add_symbol(uint16_t locate, const std::string &symbol);
+    void record_trade(uint16_t locate, double price, int32_t quantity);
+
+    // Returns true if the slot was rewritten
+    bool publish(uint16_t locate, const LimitOrderBook &book, uint64_t timestamp);
+
+    const std::string &name() const { return name_; }
+
+private:
+    struct LastState {
+        BookSnapshot published;
+        int32_t last_price = 0;
+        int32_t last_qty = 0;
+        bool trade_pending = false;
+    };
+
+    std::string name_;
+    size_t depth_;
+    bool unlink_on_close_;
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+    shared_book::Header *header_ = nullptr;
+    shared_book::SymbolEntry *symbols_ = nullptr;
+    shared_book::Slot *slots_ = nullptr;
+    std::vector<std::unique_ptr<LastState>> last_;
+};
+
+// Reader side; any number per process, any thread.
+class SharedBookReader
+{
+public:
+    // Throws std::runtime_error if the segment is missing or not (yet) valid
+    explicit SharedBookReader(const std::string &name);
+    ~SharedBookReader();
+
+    SharedBookReader(const SharedBookReader &) = delete;
+    SharedBookReader &operator=(const SharedBookReader &) = delete;
+
+    size_t depth() const { return header_->depth; }
+    bool has_symbol(uint16_t locate) const;
+    std::optional<uint16_t> find(const std::string &symbol) const;
+    std::vector<std::pair<uint16_t, std::string>> symbols() const;
+
+    // Latest snapshot for `locate`; false if the symbol is unknown
+    bool read(uint16_t locate, BookSnapshot &out) const;
+    // Completed writes to the slot, for cheap change polling
+    uint64_t version(uint16_t locate) const { return slots_[locate].state.version(); }
+    uint64_t heartbeat() const { return header_->heartbeat.load(std::memory_order_relaxed); }
+    uint32_t writer_pid() const { return header_->writer_pid.load(std::memory_order_relaxed); }
+
+private:
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+    const shared_book::Header *header_ = nullptr;
+    const shared_book::SymbolEntry *symbols_ = nullptr;
+    const shared_book::Slot *slots_ = nullptr;
+};
@@ -0,0 +1,130 @@
+#include "WebSocket.h"
+
+#include <cstring>
+#include <limits>
+
+namespace websocket {
+
+namespace {
+
+uint32_t rotl(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+} // namespace
+
+std::array<uint8_t, 20> sha1(std::string_view data) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    // message + 0x80 + zero pad + 64-bit big-endian bit length, in 64-byte blocks
+    std::string msg(data);
+    const uint64_t bit_length = static_cast<uint64_t>(data.size()) * 8;
+    msg.push_back(static_cast<char>(0x80));
+    while (msg.size() % 64 != 56) msg.push_back(0);
+    for (int i = 7; i >= 0; --i) msg.push_back(static_cast<char>((bit_length >> (8 * i)) & 0xff));
+
+    for (size_t block = 0; block < msg.size(); block += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const auto* p = reinterpret_cast<const uint8_t*>(msg.data() + block + 4 * i);
+            w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        }
+        for (int i = 16; i < 80; ++i) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            uint32_t t = rotl(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rotl(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    std::array<uint8_t, 20> digest;
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 4; ++j) digest[4 * i + j] = static_cast<uint8_t>(h[i] >> (24 - 8 * j));
+    return digest;
+}
+
+std::string base64(const uint8_t* data, size_t length) {
+    static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((length + 2) / 3 * 4);
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t v = uint32_t(data[i]) << 16;
+        if (i + 1 < length) v |= uint32_t(data[i + 1]) << 8;
+        if (i + 2 < length) v |= data[i + 2];
+        out.push_back(ALPHABET[(v >> 18) & 63]);
+        out.push_back(ALPHABET[(v >> 12) & 63]);
+        out.push_back(i + 1 < length ? ALPHABET[(v >> 6) & 63] : '=');
+        out.push_back(i + 2 < length ? ALPHABET[v & 63] : '=');
+    }
+    return out;
+}
+
+std::string accept_key(std::string_view client_key) {
+    std::string joined(client_key);
+    joined += "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    auto digest = sha1(joined);
+    return base64(digest.data(), digest.size());
+}
+
+void append_frame(std::string& out, Opcode opcode, std::string_view payload) {
+    out.push_back(static_cast<char>(0x80 | opcode));
+    const size_t n = payload.size();
+    if (n < 126) {
+        out.push_back(static_cast<char>(n));
+    } else if (n <= 0xffff) {
+        out.push_back(126);
+        out.push_back(static_cast<char>(n >> 8));
+        out.push_back(static_cast<char>(n & 0xff));
+    } else {
+        out.push_back(127);
+        for (int i = 7; i >= 0; --i) out.push_back(static_cast<char>((uint64_t(n) >> (8 * i)) & 0xff));
+    }
+    out.append(payload);
+}
+
+size_t parse_frame(std::string_view buffer, Frame& frame, size_t max_payload) {
+    if (buffer.size() < 2) return 0;
+    const auto* p = reinterpret_cast<const uint8_t*>(buffer.data());
+
+    frame.fin = p[0] & 0x80;
+    frame.opcode = static_cast<Opcode>(p[0] & 0x0f);
+    const bool masked = p[1] & 0x80;
+    frame.masked = masked;
+    uint64_t length = p[1] & 0x7f;
+    size_t pos = 2;
+
+    if (length == 126) {
+        if (buffer.size() < 4) return 0;
+        length = (uint64_t(p[2]) << 8) | p[3];
+        pos = 4;
+    } else if (length == 127) {
+        if (buffer.size() < 10) return 0;
+        length = 0;
+        for (int i = 0; i < 8; ++i) length = (length << 8) | p[2 + i];
+        pos = 10;
+    }
+    if (length > max_payload) return std::numeric_limits<size_t>::max();
+
+    uint8_t mask[4] = {0, 0, 0, 0};
+    if (masked) {
+        if (buffer.size() < pos + 4) return 0;
+        std::memcpy(mask, p + pos, 4);
+        pos += 4;
+    }
+    if (buffer.size() < pos + length) return 0;
+
+    frame.payload.assign(buffer.data() + pos, length);
+    if (masked) {
+        for (size_t i = 0; i < length; ++i) frame.payload[i] ^= static_cast<char>(mask[i % 4]);
+    }
+    return pos + length;
+}
+
+} // namespace websocket
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// The small slice of RFC 6455 the dashboard needs: the handshake key,
+// unmasked server frames and parsing of (masked) client frames.
+namespace websocket {
+
+enum Opcode : uint8_t {
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA
+};
+
+std::array<uint8_t, 20> sha1(std::string_view data);
+std::string base64(const uint8_t *data, size_t length);
+
+// Sec-WebSocket-Accept for a client's Sec-WebSocket-Key
+std::string accept_key(std::string_view client_key);
+
+// Appends one unfragmented server frame
+void append_frame(std::string &out, Opcode opcode, std::string_view payload);
+
+struct Frame {
+    Opcode opcode = TEXT;
+    bool fin = true;
+    bool masked = false;    // as sent; clients must mask every frame
+    std::string payload;    // unmasked
+};
+
+// Parses one frame from the front of `buffer`. Returns the bytes consumed,
+// 0 if the frame is incomplete, or SIZE_MAX if it exceeds `max_payload`.
+size_t parse_frame(std::string_view buffer, Frame &frame, size_t max_payload = 1 << 16);
+
+} // namespace websocket
@@ -0,0 +1,85 @@
+#ifndef STORAGE_SNAPSHOTFORMAT_H
+#define STORAGE_SNAPSHOTFORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+
+// On-disk layout of a book snapshot file (all integers little endian):
+//
+//   FileHeader
+//   chunk 0 .. chunk N-1          one symbol per chunk, columnar payload
+//   symbol table                  u32 count, then SymbolEntry[count]
+//   chunk index                   u32 count, then ChunkInfo[count]
+//   Trailer                       points back at the symbol table
+//
+// A chunk payload (before optional zstd) is a u32 column count, a u32 byte
+// length per column, then the column bytes back to back. Column 0 holds the
+// sample timestamps, then each level contributes bid price, bid qty, ask
+// price, ask qty. Every column is delta encoded against the previous row and
+// written as zigzag varints, so unchanged levels cost one byte per row.
+namespace snapshot_format {
+
+inline constexpr char MAGIC[8] = {'I', 'T', 'C', 'H', 'S', 'N', 'A', 'P'};
+inline constexpr uint32_t VERSION = 1;
+
+inline constexpr size_t COLUMNS_PER_LEVEL = 4;
+
+enum class Codec : uint8_t {
+    Varint = 0,     // delta + zigzag varint only
+    VarintZstd = 1  // varint payload additionally compressed with zstd
+};
+
+enum LevelColumn : size_t {
+    BidPrice = 0,
+    BidQty = 1,
+    AskPrice = 2,
+    AskQty = 3
+};
+
+inline constexpr size_t column_count(uint32_t depth) {
+    return 1 + COLUMNS_PER_LEVEL * depth;
+}
+
+inline constexpr size_t level_column(size_t level, LevelColumn which) {
+    return 1 + level * COLUMNS_PER_LEVEL + which;
+}
+
+#pragma pack(push, 1)
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t depth;
+    uint64_t interval_ns;
+};
+
+struct SymbolEntry {
+    uint16_t locate;
+    char symbol[8];
+};
+
+struct ChunkInfo {
+    uint64_t offset;
+    uint64_t first_ts;
+    uint64_t last_ts;
+    uint32_t stored_size;
+    uint32_t raw_size;
+    uint32_t rows;
+    uint16_t locate;
+    uint8_t codec;
+    uint8_t reserved;
+};
+
+struct Trailer {
+    uint64_t footer_offset;
+    char magic[8];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FileHeader) == 24);
+static_assert(sizeof(SymbolEntry) == 10);
+static_assert(sizeof(ChunkInfo) == 40);
+static_assert(sizeof(Trailer) == 16);
+
+} // namespace snapshot_format
+
+#endif // STORAGE_SNAPSHOTFORMAT_H
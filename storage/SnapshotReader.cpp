@@ -0,0 +1,172 @@
+#include "SnapshotReader.h"
+#include "Varint.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef ORDERBOOK_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace snapshot_format;
+
+SnapshotReader::SnapshotReader(const std::string& path)
+    : in_(path, std::ios::binary)
+{
+    if (!in_) {
+        throw std::runtime_error("SnapshotReader: cannot open " + path);
+    }
+
+    in_.read(reinterpret_cast<char*>(&header_), sizeof(header_));
+    if (!in_ || std::memcmp(header_.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("SnapshotReader: not a snapshot file: " + path);
+    }
+    if (header_.version != VERSION) {
+        throw std::runtime_error("SnapshotReader: unsupported version " + std::to_string(header_.version));
+    }
+
+    Trailer trailer{};
+    in_.seekg(0, std::ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(in_.tellg());
+    in_.seekg(-static_cast<std::streamoff>(sizeof(trailer)), std::ios::end);
+    in_.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    if (!in_ || std::memcmp(trailer.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("SnapshotReader: missing trailer (file not finished?): " + path);
+    }
+
+    // the footer sits between footer_offset and the trailer; counts that
+    // would not fit there are corrupt and must not size an allocation
+    const uint64_t footer_end = file_size - sizeof(trailer);
+    auto corrupt = [&] { return std::runtime_error("SnapshotReader: corrupt footer: " + path); };
+    if (trailer.footer_offset > footer_end) {
+        throw corrupt();
+    }
+    uint64_t footer_left = footer_end - trailer.footer_offset;
+    in_.seekg(static_cast<std::streamoff>(trailer.footer_offset));
+
+    uint32_t nsymbols = 0;
+    in_.read(reinterpret_cast<char*>(&nsymbols), sizeof(nsymbols));
+    if (!in_ || footer_left < sizeof(nsymbols) + uint64_t{nsymbols} * sizeof(SymbolEntry)) {
+        throw corrupt();
+    }
+    footer_left -= sizeof(nsymbols) + uint64_t{nsymbols} * sizeof(SymbolEntry);
+    symbols_.resize(nsymbols);
+    in_.read(reinterpret_cast<char*>(symbols_.data()), nsymbols * sizeof(SymbolEntry));
+
+    uint32_t nchunks = 0;
+    in_.read(reinterpret_cast<char*>(&nchunks), sizeof(nchunks));
+    if (!in_ || footer_left < sizeof(nchunks) + uint64_t{nchunks} * sizeof(ChunkInfo)) {
+        throw corrupt();
+    }
+    index_.resize(nchunks);
+    in_.read(reinterpret_cast<char*>(index_.data()), nchunks * sizeof(ChunkInfo));
+
+    if (!in_) {
+        throw corrupt();
+    }
+}
+
+int32_t SnapshotReader::find_locate(const std::string& symbol) const {
+    for (const auto& entry : symbols_) {
+        std::string name(entry.symbol, sizeof(entry.symbol));
+        while (!name.empty() && name.back() == ' ')
+            name.pop_back();
+        if (name == symbol)
+            return entry.locate;
+    }
+    return -1;
+}
+
+std::vector<size_t> SnapshotReader::chunks_for(uint16_t locate) const {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < index_.size(); ++i) {
+        if (index_[i].locate == locate)
+            result.push_back(i);
+    }
+    return result;
+}
+
+const uint8_t* SnapshotReader::load_payload(size_t chunk) {
+    const ChunkInfo& info = index_.at(chunk);
+
+    stored_.resize(info.stored_size);
+    in_.clear();
+    in_.seekg(static_cast<std::streamoff>(info.offset));
+    in_.read(reinterpret_cast<char*>(stored_.data()), info.stored_size);
+    if (!in_) {
+        throw std::runtime_error("SnapshotReader: short read on chunk " + std::to_string(chunk));
+    }
+
+    if (info.codec == static_cast<uint8_t>(Codec::Varint)) {
+        return stored_.data();
+    }
+
+#ifdef ORDERBOOK_HAVE_ZSTD
+    if (info.codec == static_cast<uint8_t>(Codec::VarintZstd)) {
+        raw_.resize(info.raw_size);
+        size_t n = ZSTD_decompress(raw_.data(), raw_.size(), stored_.data(), stored_.size());
+        if (ZSTD_isError(n) || n != info.raw_size) {
+            throw std::runtime_error("SnapshotReader: zstd decode failed on chunk " + std::to_string(chunk));
+        }
+        return raw_.data();
+    }
+#endif
+
+    throw std::runtime_error("SnapshotReader: unsupported codec on chunk " + std::to_string(chunk));
+}
+
+void SnapshotReader::decode_column(const uint8_t* payload, size_t size, uint32_t rows, size_t column,
+                                   std::vector<int64_t>& out) const {
+    if (size < sizeof(uint32_t)) {
+        throw std::runtime_error("SnapshotReader: truncated column table");
+    }
+    uint32_t ncols = 0;
+    std::memcpy(&ncols, payload, sizeof(ncols));
+    // widened before adding, so a corrupt count cannot wrap the table size
+    const size_t table = (size_t{1} + ncols) * sizeof(uint32_t);
+    if (column >= ncols || table > size) {
+        throw std::runtime_error("SnapshotReader: column out of range");
+    }
+
+    // column bytes start after the length table; skip the columns before ours
+    size_t offset = table;
+    uint32_t length = 0;
+    for (size_t c = 0; c <= column; ++c) {
+        std::memcpy(&length, payload + sizeof(uint32_t) * (1 + c), sizeof(length));
+        if (c < column)
+            offset += length;
+    }
+    if (offset + length > size) {
+        throw std::runtime_error("SnapshotReader: column overruns chunk");
+    }
+
+    const uint8_t* data = payload + offset;
+    size_t pos = 0;
+    int64_t value = 0;
+
+    out.resize(rows);
+    for (uint32_t r = 0; r < rows; ++r) {
+        value += varint::get_signed(data, length, pos);
+        out[r] = value;
+    }
+}
+
+void SnapshotReader::read_column(size_t chunk, size_t column, std::vector<int64_t>& out) {
+    const uint8_t* payload = load_payload(chunk);
+    decode_column(payload, index_[chunk].raw_size, index_[chunk].rows, column, out);
+}
+
+void SnapshotReader::read_chunk(size_t chunk, SnapshotChunk& out) {
+    const ChunkInfo& info = index_.at(chunk);
+    const uint8_t* payload = load_payload(chunk);
+    const size_t ncols = column_count(header_.depth);
+
+    out.locate = info.locate;
+    out.depth = header_.depth;
+    out.columns.resize(ncols);
+    for (size_t c = 0; c < ncols; ++c) {
+        decode_column(payload, info.raw_size, info.rows, c, out.columns[c]);
+    }
+
+    out.timestamps.assign(out.columns[0].begin(), out.columns[0].end());
+}
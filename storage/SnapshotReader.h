@@ -0,0 +1,60 @@
+#pragma once
+
+#include "SnapshotFormat.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// One decoded chunk. Columns are indexed as in SnapshotFormat.h, values are
+// absolute (deltas already resolved).
+struct SnapshotChunk {
+    uint16_t locate = 0;
+    uint32_t depth = 0;
+    std::vector<uint64_t> timestamps;
+    std::vector<std::vector<int64_t>> columns;
+
+    size_t rows() const { return timestamps.size(); }
+
+    const std::vector<int64_t> &level(size_t lvl, snapshot_format::LevelColumn which) const {
+        return columns[snapshot_format::level_column(lvl, which)];
+    }
+};
+
+// Random-access reader for snapshot files. The symbol table and chunk index are
+// loaded up front; chunk payloads are only read when requested, so a scan over
+// one symbol or one column touches a fraction of the file.
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(const std::string &path);
+
+    uint32_t depth() const { return header_.depth; }
+    uint64_t interval_ns() const { return header_.interval_ns; }
+
+    const std::vector<snapshot_format::SymbolEntry> &symbols() const { return symbols_; }
+    const std::vector<snapshot_format::ChunkInfo> &chunks() const { return index_; }
+
+    // Locate for a symbol, or -1 if the file does not contain it.
+    int32_t find_locate(const std::string &symbol) const;
+
+    // Indices into chunks() for one symbol, in file order (ascending time).
+    std::vector<size_t> chunks_for(uint16_t locate) const;
+
+    void read_chunk(size_t chunk, SnapshotChunk &out);
+
+    // Decodes a single column of a chunk without materialising the others.
+    void read_column(size_t chunk, size_t column, std::vector<int64_t> &out);
+
+private:
+    const uint8_t *load_payload(size_t chunk);
+    void decode_column(const uint8_t *payload, size_t size, uint32_t rows, size_t column,
+                       std::vector<int64_t> &out) const;
+
+    std::ifstream in_;
+    snapshot_format::FileHeader header_{};
+    std::vector<snapshot_format::SymbolEntry> symbols_;
+    std::vector<snapshot_format::ChunkInfo> index_;
+    std::vector<uint8_t> stored_;
+    std::vector<uint8_t> raw_;
+};
@@ -0,0 +1,56 @@
+#include "SnapshotSampler.h"
+
+#include <cmath>
+#include <stdexcept>
+
+SnapshotSampler::SnapshotSampler(SnapshotWriter& writer, uint64_t interval_ns)
+    : writer_(writer), interval_ns_(interval_ns),
+      scratch_(writer.depth()), bids_(writer.depth()), asks_(writer.depth())
+{
+    if (interval_ns_ == 0) {
+        throw std::invalid_argument("SnapshotSampler: interval must be non-zero");
+    }
+}
+
+void SnapshotSampler::track(uint16_t locate, const std::string& symbol, const LimitOrderBook* book) {
+    writer_.add_symbol(locate, symbol);
+    books_.push_back({locate, book});
+}
+
+void SnapshotSampler::sample_until(uint64_t timestamp) {
+    if (!started_) {
+        // first message only aligns the grid: there is no state to sample yet
+        started_ = true;
+        next_sample_ns_ = (timestamp / interval_ns_ + 1) * interval_ns_;
+        return;
+    }
+
+    while (next_sample_ns_ <= timestamp) {
+        sample_all(next_sample_ns_);
+        next_sample_ns_ += interval_ns_;
+    }
+}
+
+void SnapshotSampler::sample_all(uint64_t sample_ts) {
+    const size_t depth = writer_.depth();
+
+    auto copy_side = [&](const LimitOrderBook* book, OrderSide side, std::vector<SnapshotLevel>& out) {
+        size_t n = book->get_top_levels(side, depth, scratch_.data());
+        for (size_t i = 0; i < depth; ++i) {
+            if (i < n) {
+                out[i].price_ticks = std::llround(scratch_[i].price / LimitOrderBook::tick_size());
+                out[i].quantity = scratch_[i].quantity;
+            } else {
+                out[i] = SnapshotLevel{};
+            }
+        }
+    };
+
+    for (const auto& tracked : books_) {
+        copy_side(tracked.book, OrderSide::Buy, bids_);
+        copy_side(tracked.book, OrderSide::Sell, asks_);
+        writer_.append(tracked.locate, sample_ts, bids_.data(), asks_.data());
+    }
+
+    ++samples_taken_;
+}
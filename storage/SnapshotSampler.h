@@ -0,0 +1,46 @@
+#pragma once
+
+#include "LimitOrderBook.h"
+#include "SnapshotWriter.h"
+#include <cstdint>
+#include <vector>
+
+// Samples the top-N levels of every tracked book each time exchange time
+// crosses a multiple of the interval. Drive it with the ITCH timestamp of each
+// message *before* applying that message, so a sample at time T reflects
+// everything strictly earlier than T.
+class SnapshotSampler
+{
+public:
+    SnapshotSampler(SnapshotWriter &writer, uint64_t interval_ns);
+
+    void track(uint16_t locate, const std::string &symbol, const LimitOrderBook *book);
+
+    void advance(uint64_t timestamp)
+    {
+        if (timestamp >= next_sample_ns_)
+            sample_until(timestamp);
+    }
+
+    uint64_t samples_taken() const { return samples_taken_; }
+
+private:
+    struct Tracked {
+        uint16_t locate;
+        const LimitOrderBook *book;
+    };
+
+    void sample_until(uint64_t timestamp);
+    void sample_all(uint64_t sample_ts);
+
+    SnapshotWriter &writer_;
+    uint64_t interval_ns_;
+    uint64_t next_sample_ns_ = 0;
+    bool started_ = false;
+    uint64_t samples_taken_ = 0;
+
+    std::vector<Tracked> books_;
+    std::vector<LimitOrderBook::BestLevel> scratch_;
+    std::vector<SnapshotLevel> bids_;
+    std::vector<SnapshotLevel> asks_;
+};
@@ -0,0 +1,159 @@
+#include "SnapshotWriter.h"
+#include "Varint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef ORDERBOOK_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace snapshot_format;
+
+SnapshotWriter::SnapshotWriter(const std::string& path, uint32_t depth, uint64_t interval_ns,
+                               uint32_t chunk_rows)
+    : out_(path, std::ios::binary | std::ios::trunc), depth_(depth), chunk_rows_(chunk_rows)
+{
+    if (!out_) {
+        throw std::runtime_error("SnapshotWriter: cannot open " + path);
+    }
+    if (depth_ == 0 || chunk_rows_ == 0) {
+        throw std::invalid_argument("SnapshotWriter: depth and chunk_rows must be non-zero");
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.depth = depth_;
+    header.interval_ns = interval_ns;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    try {
+        finish();
+    } catch (...) {
+        // destructors must not throw; an explicit finish() reports errors
+    }
+}
+
+void SnapshotWriter::add_symbol(uint16_t locate, const std::string& symbol) {
+    SymbolEntry entry{};
+    entry.locate = locate;
+    std::memset(entry.symbol, ' ', sizeof(entry.symbol));
+    std::memcpy(entry.symbol, symbol.data(), std::min(symbol.size(), sizeof(entry.symbol)));
+    symbols_.push_back(entry);
+}
+
+void SnapshotWriter::append(uint16_t locate, uint64_t timestamp,
+                            const SnapshotLevel* bids, const SnapshotLevel* asks) {
+    auto& chunk = pending_[locate];
+    const size_t ncols = column_count(depth_);
+
+    if (chunk.columns.empty()) {
+        chunk.columns.resize(ncols);
+        chunk.previous.assign(ncols, 0);
+    }
+    if (chunk.rows == 0) {
+        chunk.first_ts = timestamp;
+        std::fill(chunk.previous.begin(), chunk.previous.end(), 0);
+    }
+
+    auto put = [&chunk](size_t col, int64_t value) {
+        varint::put_signed(chunk.columns[col], value - chunk.previous[col]);
+        chunk.previous[col] = value;
+    };
+
+    put(0, static_cast<int64_t>(timestamp));
+    for (size_t l = 0; l < depth_; ++l) {
+        put(level_column(l, BidPrice), bids[l].price_ticks);
+        put(level_column(l, BidQty), bids[l].quantity);
+        put(level_column(l, AskPrice), asks[l].price_ticks);
+        put(level_column(l, AskQty), asks[l].quantity);
+    }
+
+    chunk.last_ts = timestamp;
+    ++rows_written_;
+
+    if (++chunk.rows == chunk_rows_) {
+        flush_chunk(locate, chunk);
+    }
+}
+
+void SnapshotWriter::flush_chunk(uint16_t locate, PendingChunk& chunk) {
+    if (chunk.rows == 0) return;
+
+    // assemble the raw payload: column count, column lengths, column bytes
+    scratch_.clear();
+    auto put_u32 = [this](uint32_t v) {
+        const auto* p = reinterpret_cast<const uint8_t*>(&v);
+        scratch_.insert(scratch_.end(), p, p + sizeof(v));
+    };
+
+    put_u32(static_cast<uint32_t>(chunk.columns.size()));
+    for (const auto& col : chunk.columns) {
+        put_u32(static_cast<uint32_t>(col.size()));
+    }
+    for (const auto& col : chunk.columns) {
+        scratch_.insert(scratch_.end(), col.begin(), col.end());
+    }
+
+    ChunkInfo info{};
+    info.offset = static_cast<uint64_t>(out_.tellp());
+    info.first_ts = chunk.first_ts;
+    info.last_ts = chunk.last_ts;
+    info.raw_size = static_cast<uint32_t>(scratch_.size());
+    info.rows = chunk.rows;
+    info.locate = locate;
+    info.codec = static_cast<uint8_t>(Codec::Varint);
+
+#ifdef ORDERBOOK_HAVE_ZSTD
+    std::vector<uint8_t> compressed(ZSTD_compressBound(scratch_.size()));
+    size_t n = ZSTD_compress(compressed.data(), compressed.size(), scratch_.data(), scratch_.size(), 3);
+    if (!ZSTD_isError(n) && n < scratch_.size()) {
+        info.codec = static_cast<uint8_t>(Codec::VarintZstd);
+        info.stored_size = static_cast<uint32_t>(n);
+        out_.write(reinterpret_cast<const char*>(compressed.data()), n);
+    } else
+#endif
+    {
+        info.stored_size = info.raw_size;
+        out_.write(reinterpret_cast<const char*>(scratch_.data()), scratch_.size());
+    }
+
+    index_.push_back(info);
+
+    chunk.rows = 0;
+    for (auto& col : chunk.columns) {
+        col.clear();
+    }
+}
+
+void SnapshotWriter::finish() {
+    if (finished_) return;
+    finished_ = true;
+
+    for (auto& [locate, chunk] : pending_) {
+        flush_chunk(locate, chunk);
+    }
+
+    Trailer trailer{};
+    trailer.footer_offset = static_cast<uint64_t>(out_.tellp());
+    std::memcpy(trailer.magic, MAGIC, sizeof(trailer.magic));
+
+    uint32_t nsymbols = static_cast<uint32_t>(symbols_.size());
+    out_.write(reinterpret_cast<const char*>(&nsymbols), sizeof(nsymbols));
+    out_.write(reinterpret_cast<const char*>(symbols_.data()), symbols_.size() * sizeof(SymbolEntry));
+
+    uint32_t nchunks = static_cast<uint32_t>(index_.size());
+    out_.write(reinterpret_cast<const char*>(&nchunks), sizeof(nchunks));
+    out_.write(reinterpret_cast<const char*>(index_.data()), index_.size() * sizeof(ChunkInfo));
+
+    out_.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    out_.flush();
+
+    if (!out_) {
+        throw std::runtime_error("SnapshotWriter: write failed");
+    }
+}
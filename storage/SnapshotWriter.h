@@ -0,0 +1,63 @@
+#pragma once
+
+#include "SnapshotFormat.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SnapshotLevel {
+    int64_t price_ticks = 0;
+    int32_t quantity = 0;
+};
+
+// Writes top-N book samples into the chunked columnar format described in
+// SnapshotFormat.h. Rows are buffered per symbol and encoded column by column
+// as they arrive; a chunk is flushed once it holds `chunk_rows` rows.
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(const std::string &path, uint32_t depth, uint64_t interval_ns,
+                   uint32_t chunk_rows = 8192);
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter &) = delete;
+    SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+    void add_symbol(uint16_t locate, const std::string &symbol);
+
+    // `bids` and `asks` must each point at `depth` levels; missing levels are
+    // written as zero price / zero quantity.
+    void append(uint16_t locate, uint64_t timestamp,
+                const SnapshotLevel *bids, const SnapshotLevel *asks);
+
+    // Flushes every partial chunk and writes the index. Called by the
+    // destructor if not called explicitly.
+    void finish();
+
+    uint32_t depth() const { return depth_; }
+    uint64_t rows_written() const { return rows_written_; }
+
+private:
+    struct PendingChunk {
+        uint32_t rows = 0;
+        uint64_t first_ts = 0;
+        uint64_t last_ts = 0;
+        std::vector<int64_t> previous;              // last value per column
+        std::vector<std::vector<uint8_t>> columns;  // encoded bytes per column
+    };
+
+    void flush_chunk(uint16_t locate, PendingChunk &chunk);
+
+    std::ofstream out_;
+    uint32_t depth_;
+    uint32_t chunk_rows_;
+    uint64_t rows_written_ = 0;
+    bool finished_ = false;
+
+    std::unordered_map<uint16_t, PendingChunk> pending_;
+    std::vector<snapshot_format::SymbolEntry> symbols_;
+    std::vector<snapshot_format::ChunkInfo> index_;
+    std::vector<uint8_t> scratch_;
+};
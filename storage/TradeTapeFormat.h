@@ -0,0 +1,60 @@
+#ifndef STORAGE_TRADETAPEFORMAT_H
+#define STORAGE_TRADETAPEFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk layout of a per-symbol trade tape (all integers little endian):
+//
+//   <dir>/<SYMBOL>.tape       FileHeader, then TradeRecord[] in exchange time order
+//   <dir>/<SYMBOL>.tape.idx   FileHeader, then IndexEntry[] for every
+//                             index_every-th record
+//
+// Both files are only ever appended to, so a reader can map a tape while the
+// replay is still writing it; a trailing partial record is ignored. The index
+// is written after the records it points at, so it never runs ahead of the
+// tape, and records past the last index entry are found by searching the tail.
+namespace trade_tape {
+
+inline constexpr char MAGIC[8] = {'I', 'T', 'C', 'H', 'T', 'A', 'P', 'E'};
+inline constexpr char INDEX_MAGIC[8] = {'I', 'T', 'C', 'H', 'T', 'I', 'D', 'X'};
+inline constexpr uint32_t VERSION = 1;
+
+#pragma pack(push, 1)
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t index_every;
+    uint16_t locate;
+    char symbol[8];         // space padded
+    uint8_t reserved[2];
+};
+#pragma pack(pop)
+
+// One fill, as reported by the engine's trade callback
+struct TradeRecord {
+    uint64_t timestamp;     // exchange ns since midnight of the command that traded
+    uint64_t sequence;      // trade number across the whole replay
+    int64_t taker_id;
+    int64_t maker_id;
+    int64_t price_ticks;    // 1e-4 dollars, as in ITCH
+    int32_t quantity;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    uint64_t timestamp;     // of the record below
+    uint64_t record;
+};
+
+static_assert(sizeof(FileHeader) == 32);
+static_assert(sizeof(TradeRecord) == 48);
+static_assert(sizeof(IndexEntry) == 16);
+
+inline std::string index_path(const std::string &tape_path) { return tape_path + ".idx"; }
+
+} // namespace trade_tape
+
+#endif // STORAGE_TRADETAPEFORMAT_H
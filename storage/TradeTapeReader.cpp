@@ -0,0 +1,97 @@
+#include "TradeTapeReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace trade_tape;
+
+TradeTapeReader::TradeTapeReader(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("TradeTapeReader: cannot open " + path);
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("TradeTapeReader: not a trade tape: " + path);
+    }
+
+    map_size_ = static_cast<size_t>(st.st_size);
+    map_ = ::mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        throw std::runtime_error("TradeTapeReader: cannot map " + path);
+    }
+    // queries jump straight to a few index blocks
+    ::madvise(map_, map_size_, MADV_RANDOM);
+
+    const char* base = static_cast<const char*>(map_);
+    std::memcpy(&header_, base, sizeof(header_));
+
+    auto fail = [&](const std::string& why) {
+        ::munmap(map_, map_size_);
+        map_ = nullptr;
+        throw std::runtime_error("TradeTapeReader: " + path + ": " + why);
+    };
+    if (std::memcmp(header_.magic, MAGIC, sizeof(header_.magic)) != 0)
+        fail("not a trade tape");
+    if (header_.version != VERSION)
+        fail("unsupported version " + std::to_string(header_.version));
+    if (header_.record_size != sizeof(TradeRecord))
+        fail("record size mismatch");
+
+    // a tape still being written may end in a partial record
+    records_ = reinterpret_cast<const TradeRecord*>(base + sizeof(FileHeader));
+    count_ = (map_size_ - sizeof(FileHeader)) / sizeof(TradeRecord);
+
+    // a missing index only costs a search over the whole tape
+    std::ifstream in(index_path(path), std::ios::binary);
+    FileHeader index_header{};
+    if (in.read(reinterpret_cast<char*>(&index_header), sizeof(index_header)) &&
+        std::memcmp(index_header.magic, INDEX_MAGIC, sizeof(index_header.magic)) == 0) {
+        IndexEntry entry{};
+        while (in.read(reinterpret_cast<char*>(&entry), sizeof(entry)) && entry.record < count_) {
+            index_.push_back(entry);
+        }
+    }
+}
+
+TradeTapeReader::~TradeTapeReader() {
+    if (map_)
+        ::munmap(map_, map_size_);
+}
+
+std::string TradeTapeReader::symbol() const {
+    std::string name(header_.symbol, sizeof(header_.symbol));
+    while (!name.empty() && name.back() == ' ')
+        name.pop_back();
+    return name;
+}
+
+size_t TradeTapeReader::lower_bound(uint64_t ts) const {
+    // the first entry at or after ts bounds the answer from above, the one
+    // before it from below; only the records between them are searched
+    auto it = std::lower_bound(index_.begin(), index_.end(), ts,
+                               [](const IndexEntry& e, uint64_t t) { return e.timestamp < t; });
+    const size_t hi = it == index_.end() ? count_ : static_cast<size_t>(it->record);
+    const size_t lo = it == index_.begin() ? 0 : static_cast<size_t>(std::prev(it)->record);
+
+    const TradeRecord* found = std::lower_bound(records_ + lo, records_ + hi, ts,
+                                                [](const TradeRecord& r, uint64_t t) { return r.timestamp < t; });
+    return static_cast<size_t>(found - records_);
+}
+
+std::span<const TradeRecord> TradeTapeReader::range(uint64_t from_ns, uint64_t to_ns) const {
+    if (to_ns <= from_ns) return {};
+    const size_t first = lower_bound(from_ns);
+    const size_t last = lower_bound(to_ns);
+    return {records_ + first, last - first};
+}
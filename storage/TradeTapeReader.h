@@ -0,0 +1,42 @@
+#pragma once
+
+#include "TradeTapeFormat.h"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Read-only mapping of a trade tape. The sparse index is loaded up front; a
+// time range query binary-searches it for the two index blocks holding the
+// range ends and then searches only inside those, so it touches a few pages
+// of the tape however long the day was.
+class TradeTapeReader
+{
+public:
+    explicit TradeTapeReader(const std::string &path);
+    ~TradeTapeReader();
+
+    TradeTapeReader(const TradeTapeReader &) = delete;
+    TradeTapeReader &operator=(const TradeTapeReader &) = delete;
+
+    uint16_t locate() const { return header_.locate; }
+    std::string symbol() const;
+
+    // Whole records as of opening the tape
+    std::span<const trade_tape::TradeRecord> records() const { return {records_, count_}; }
+    const std::vector<trade_tape::IndexEntry> &index() const { return index_; }
+
+    // Records with from_ns <= timestamp < to_ns
+    std::span<const trade_tape::TradeRecord> range(uint64_t from_ns, uint64_t to_ns) const;
+
+    // Position of the first record with timestamp >= ts
+    size_t lower_bound(uint64_t ts) const;
+
+private:
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+    trade_tape::FileHeader header_{};
+    const trade_tape::TradeRecord *records_ = nullptr;
+    size_t count_ = 0;
+    std::vector<trade_tape::IndexEntry> index_;
+};
@@ -0,0 +1,93 @@
+#include "TradeTapeWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace trade_tape;
+
+namespace {
+
+FileHeader make_header(const char (&magic)[8], uint16_t locate, const std::string& symbol, uint32_t index_every) {
+    FileHeader header{};
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = VERSION;
+    header.record_size = sizeof(TradeRecord);
+    header.index_every = index_every;
+    header.locate = locate;
+    std::memset(header.symbol, ' ', sizeof(header.symbol));
+    std::memcpy(header.symbol, symbol.data(), std::min(symbol.size(), sizeof(header.symbol)));
+    return header;
+}
+
+} // namespace
+
+TradeTapeWriter::TradeTapeWriter(const std::string& path, uint16_t locate, const std::string& symbol,
+                                 uint32_t index_every, size_t buffer_records)
+    : tape_(path, std::ios::binary | std::ios::trunc),
+      index_(index_path(path), std::ios::binary | std::ios::trunc),
+      path_(path),
+      index_every_(index_every),
+      buffer_records_(buffer_records)
+{
+    if (!tape_ || !index_) {
+        throw std::runtime_error("TradeTapeWriter: cannot open " + path);
+    }
+    if (index_every_ == 0 || buffer_records_ == 0) {
+        throw std::invalid_argument("TradeTapeWriter: index_every and buffer_records must be non-zero");
+    }
+
+    FileHeader header = make_header(MAGIC, locate, symbol, index_every_);
+    tape_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    header = make_header(INDEX_MAGIC, locate, symbol, index_every_);
+    index_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    buffer_.reserve(buffer_records_);
+}
+
+TradeTapeWriter::~TradeTapeWriter() {
+    try {
+        finish();
+    } catch (...) {
+        // destructors must not throw; an explicit finish() reports errors
+    }
+}
+
+void TradeTapeWriter::append(const TradeRecord& record) {
+    if (records_ % index_every_ == 0) {
+        pending_index_.push_back({record.timestamp, records_});
+    }
+    buffer_.push_back(record);
+    ++records_;
+    if (buffer_.size() == buffer_records_) {
+        flush();
+    }
+}
+
+void TradeTapeWriter::flush() {
+    if (!buffer_.empty()) {
+        tape_.write(reinterpret_cast<const char*>(buffer_.data()),
+                    static_cast<std::streamsize>(buffer_.size() * sizeof(TradeRecord)));
+        buffer_.clear();
+    }
+    tape_.flush();
+
+    // only once the records are out, so the index never points past the tape
+    if (!pending_index_.empty()) {
+        index_.write(reinterpret_cast<const char*>(pending_index_.data()),
+                     static_cast<std::streamsize>(pending_index_.size() * sizeof(IndexEntry)));
+        pending_index_.clear();
+    }
+    index_.flush();
+
+    if (!tape_ || !index_) {
+        throw std::runtime_error("TradeTapeWriter: write failed on " + path_);
+    }
+}
+
+void TradeTapeWriter::finish() {
+    if (finished_) return;
+    finished_ = true;
+    flush();
+    tape_.close();
+    index_.close();
+}
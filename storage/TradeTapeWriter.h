@@ -0,0 +1,45 @@
+#pragma once
+
+#include "TradeTapeFormat.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Appends one symbol's fills to a trade tape and its sparse time index (see
+// TradeTapeFormat.h). Records are buffered and written in batches; the
+// index gets an entry for every `index_every`-th record. A writer is used by
+// one thread at a time, the one applying its symbol's commands.
+class TradeTapeWriter
+{
+public:
+    TradeTapeWriter(const std::string &path, uint16_t locate, const std::string &symbol,
+                    uint32_t index_every = 256, size_t buffer_records = 4096);
+    ~TradeTapeWriter();
+
+    TradeTapeWriter(const TradeTapeWriter &) = delete;
+    TradeTapeWriter &operator=(const TradeTapeWriter &) = delete;
+
+    // Timestamps must not go backwards; the reader binary-searches them
+    void append(const trade_tape::TradeRecord &record);
+
+    // Writes buffered records, then the index entries that point at them
+    void flush();
+
+    // Flushes and closes. Called by the destructor if not called explicitly.
+    void finish();
+
+    uint64_t records() const { return records_; }
+
+private:
+    std::ofstream tape_;
+    std::ofstream index_;
+    std::string path_;
+    uint32_t index_every_;
+    size_t buffer_records_;
+    uint64_t records_ = 0;
+    bool finished_ = false;
+
+    std::vector<trade_tape::TradeRecord> buffer_;
+    std::vector<trade_tape::IndexEntry> pending_index_;
+};
@@ -0,0 +1,55 @@
+#ifndef STORAGE_VARINT_H
+#define STORAGE_VARINT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// LEB128-style variable length integers plus zigzag mapping so that small
+// negative deltas stay small on disk.
+namespace varint {
+
+inline uint64_t zigzag_encode(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline void put(std::vector<uint8_t> &out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline void put_signed(std::vector<uint8_t> &out, int64_t v) {
+    put(out, zigzag_encode(v));
+}
+
+// Reads one value starting at `pos` and advances it. Throws on truncated input.
+inline uint64_t get(const uint8_t *data, size_t size, size_t &pos) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (pos >= size) {
+            throw std::runtime_error("varint: truncated input");
+        }
+        uint8_t byte = data[pos++];
+        result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return result;
+        }
+    }
+    throw std::runtime_error("varint: value too long");
+}
+
+inline int64_t get_signed(const uint8_t *data, size_t size, size_t &pos) {
+    return zigzag_decode(get(data, size, pos));
+}
+
+} // namespace varint
+
+#endif // STORAGE_VARINT_H
@@ -0,0 +1,221 @@
+#include "MatchingEngine.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+// ---------- Counting global allocator ----------
+// Every operator new in this binary lands here, so a test can bracket a call
+// and see exactly how many heap allocations it made.
+
+static std::atomic<uint64_t> g_allocations{0};
+
+static void* counted_alloc(std::size_t size, std::size_t align = 0) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void* p = align ? std::aligned_alloc(align, (size + align - 1) / align * align) : std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return counted_alloc(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return counted_alloc(size, static_cast<std::size_t>(align)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+static uint64_t allocations() { return g_allocations.load(std::memory_order_relaxed); }
+
+// ---------- Realistic command mix ----------
+// Passive adds on both sides of a fixed mid, cancels, partial reduces and
+// executions, replaces, and marketable adds that sweep a level or two. Prices
+// stay inside a 51-tick band and the live population is capped, which is the
+// "steady state" a warmed-up book is expected to handle without allocating.
+
+namespace {
+
+constexpr uint32_t MID = 1'000'000;      // 100.00 in ITCH fixed point
+constexpr uint32_t TICK = 100;           // 0.01
+constexpr int BAND = 25;                 // ticks either side of mid
+constexpr size_t MAX_LIVE = 2000;
+
+enum OpKind { PassiveAdd, MarketableAdd, Cancel, Reduce, Execute, Replace, OP_KINDS };
+const char* const OP_NAMES[OP_KINDS] = {"add (passive)", "add (marketable)", "cancel", "reduce", "execute", "replace"};
+
+class CommandMix {
+public:
+    explicit CommandMix(uint32_t seed) : rng_(seed) { live_.reserve(MAX_LIVE * 4); }
+
+    // Picks the next command against the engine's current book; stale ids
+    // (filled by matching) are pruned on the way
+    OpKind next(const LimitOrderBook& book, EngineCommand& cmd) {
+        cmd = EngineCommand{};
+        size_t pick = 0;
+        while (!live_.empty()) {
+            pick = rng_() % live_.size();
+            if (book.orders_by_id.count(live_[pick])) break;
+            live_[pick] = live_.back();
+            live_.pop_back();
+        }
+
+        const uint32_t roll = rng_() % 100;
+        if (live_.empty() || (live_.size() < MAX_LIVE && roll < 45)) return add(cmd, roll < 5);
+        if (roll < 50) return add(cmd, true);
+
+        cmd.order_id = live_[pick];
+        if (roll < 75) {
+            cmd.type = CommandType::Cancel;
+            return Cancel;
+        }
+        if (roll < 83) {
+            cmd.type = CommandType::Reduce;
+            cmd.quantity = 1 + static_cast<int32_t>(rng_() % 50);
+            return Reduce;
+        }
+        if (roll < 91) {
+            cmd.type = CommandType::Execute;
+            cmd.quantity = 1 + static_cast<int32_t>(rng_() % 100);
+            return Execute;
+        }
+        // replace keeps the side, so stay on the same half of the band
+        const OrderSide side = book.orders_by_id.at(cmd.order_id)->side;
+        cmd.type = CommandType::Replace;
+        cmd.new_order_id = next_id_++;
+        cmd.price = passive_price(side);
+        cmd.quantity = lot();
+        live_[pick] = cmd.new_order_id;
+        return Replace;
+    }
+
+private:
+    OpKind add(EngineCommand& cmd, bool marketable) {
+        const OrderSide side = rng_() % 2 ? OrderSide::Sell : OrderSide::Buy;
+        cmd.type = CommandType::Add;
+        cmd.order_id = next_id_++;
+        cmd.side = side == OrderSide::Sell ? 1 : 0;
+        cmd.quantity = lot();
+        if (marketable) {
+            // priced a couple of ticks through mid so it meets the other side
+            const int through = 1 + static_cast<int>(rng_() % 3);
+            cmd.price = side == OrderSide::Buy ? MID + through * TICK : MID - through * TICK;
+        } else {
+            cmd.price = passive_price(side);
+        }
+        live_.push_back(cmd.order_id);
+        return marketable ? MarketableAdd : PassiveAdd;
+    }
+
+    uint32_t passive_price(OrderSide side) {
+        const uint32_t offset = 1 + static_cast<uint32_t>(rng_() % BAND);
+        return side == OrderSide::Buy ? MID - offset * TICK : MID + offset * TICK;
+    }
+
+    int32_t lot() { return 100 * (1 + static_cast<int32_t>(rng_() % 5)); }
+
+    std::mt19937 rng_;
+    std::vector<int64_t> live_;
+    int64_t next_id_ = 1;
+};
+
+std::unique_ptr<MatchingEngine> make_engine() {
+    auto engine = std::make_unique<MatchingEngine>(std::make_unique<LimitOrderBook>(0.0, 1000.0, 50'000));
+    engine->setTradeCallback([](const TradeEvent&) {});
+    engine->setInvariantCallback([](MatchingEngine&, const char*) {});
+    engine->enable_flight_recorder(1024);
+    return engine;
+}
+
+// Touches every level of the band with a deep queue on both sides, then
+// clears it again: level FIFOs, queue trees and the node pool all reach
+// their working-set size before anything is measured
+void prime(MatchingEngine& engine) {
+    constexpr int DEPTH = 256;
+    int64_t id = 1'000'000'000;
+    for (int tick = -BAND - 3; tick <= BAND + 3; ++tick) {
+        const double price = (MID + tick * static_cast<int32_t>(TICK)) / 10000.0;
+        for (int i = 0; i < DEPTH; ++i)
+            engine.submitLimit(id + i, tick < 0 ? OrderSide::Buy : OrderSide::Sell, price, 100);
+        for (int i = 0; i < DEPTH; ++i)
+            engine.cancel(id + i);
+        id += DEPTH;
+    }
+}
+
+} // namespace
+
+// ---------- Tests ----------
+
+TEST(Allocation, CounterSeesColdBookAllocate) {
+    // guards against a vacuous pass: first touch of a level must allocate
+    auto engine = make_engine();
+    const uint64_t before = allocations();
+    engine->submitLimit(1, OrderSide::Buy, 100.00, 100);
+    EXPECT_GT(allocations() - before, 0u);
+}
+
+TEST(Allocation, WarmEngineIsAllocationFreeForEveryCommandType) {
+    auto engine = make_engine();
+    prime(*engine);
+
+    CommandMix mix(20240521);
+    EngineCommand cmd;
+    for (int i = 0; i < 100'000; ++i) {
+        mix.next(*engine->get_book(), cmd);
+        engine->apply(cmd);
+    }
+
+    uint64_t ops[OP_KINDS] = {};
+    uint64_t allocs[OP_KINDS] = {};
+    for (int i = 0; i < 200'000; ++i) {
+        const OpKind kind = mix.next(*engine->get_book(), cmd);
+        const uint64_t before = allocations();
+        engine->apply(cmd);
+        allocs[kind] += allocations() - before;
+        ++ops[kind];
+    }
+
+    std::printf("%-18s %10s %12s %10s\n", "command", "ops", "allocations", "per op");
+    for (int k = 0; k < OP_KINDS; ++k) {
+        std::printf("%-18s %10llu %12llu %10.4f\n", OP_NAMES[k], static_cast<unsigned long long>(ops[k]),
+                    static_cast<unsigned long long>(allocs[k]), ops[k] ? double(allocs[k]) / ops[k] : 0.0);
+    }
+
+    const auto stats = engine->stats();
+    EXPECT_GT(stats.matches, 0u);
+    EXPECT_GT(stats.replaces, 0u);
+    for (int k = 0; k < OP_KINDS; ++k) {
+        EXPECT_GT(ops[k], 0u) << OP_NAMES[k];
+        EXPECT_EQ(allocs[k], 0u) << OP_NAMES[k] << " allocated in steady state";
+    }
+    EXPECT_TRUE(engine->get_book()->check_invariants());
+}
+
+TEST(Allocation, BookReusesNodesAcrossFillAndDrain) {
+    // the same population added and torn down twice: the second round is
+    // served entirely from recycled storage
+    LimitOrderBook book(0.0, 1000.0, 10'000);
+    auto round = [&](int64_t base) {
+        for (int i = 0; i < 4000; ++i)
+            book.process_order(base + i, 99.00 + (i % 40) * 0.01, 100, OrderSide::Buy);
+        for (int i = 0; i < 4000; ++i)
+            book.process_order(base + 10'000 + i, 98.50, 100, OrderSide::Sell);
+    };
+
+    round(0);
+    ASSERT_TRUE(book.orders_by_id.empty());
+    const uint64_t before = allocations();
+    round(100'000);
+    EXPECT_EQ(allocations() - before, 0u);
+    EXPECT_TRUE(book.orders_by_id.empty());
+}
@@ -0,0 +1,196 @@
+#include "BacktestHarness.h"
+#include "BacktestSession.h"
+#include "JoinBestStrategy.h"
+#include <gtest/gtest.h>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+static const std::vector<std::pair<uint16_t, std::string>> SYMBOLS = {{1, "AAPL"}};
+
+static BacktestConfig small_books() {
+    BacktestConfig config;
+    config.max_price = 1000.0;
+    config.pool_size = 10'000;
+    return config;
+}
+
+static EngineCommand make(CommandType type, int64_t id, int32_t qty = 0, double price = 0.0, char side = 'B') {
+    EngineCommand cmd{};
+    cmd.type = type;
+    cmd.locate = 1;
+    cmd.order_id = id;
+    cmd.quantity = qty;
+    cmd.price = static_cast<uint32_t>(price * 10000 + 0.5);
+    cmd.side = side == 'B' ? 0 : 1;
+    return cmd;
+}
+
+// Runs hooks from on_book_update so tests can act at a given command
+class ScriptedStrategy : public Strategy {
+public:
+    std::function<void(StrategyContext&, const EngineCommand&)> on_update;
+    std::vector<VirtualFill> fills;
+
+    void on_book_update(StrategyContext& ctx, const EngineCommand& cmd) override {
+        if (on_update) on_update(ctx, cmd);
+    }
+    void on_fill(StrategyContext&, const VirtualFill& fill) override { fills.push_back(fill); }
+};
+
+// ---------- Virtual order queue model ----------
+
+TEST(BacktestSession, VirtualOrderWaitsForVolumeAhead) {
+    ScriptedStrategy strategy;
+    BacktestSession session(SYMBOLS, strategy, small_books());
+
+    uint64_t vid = 0;
+    strategy.on_update = [&](StrategyContext& ctx, const EngineCommand& cmd) {
+        if (cmd.order_id == 2 && cmd.type == CommandType::Add)
+            vid = ctx.place(OrderSide::Buy, 100.00, 50);
+    };
+
+    session.step(make(CommandType::Add, 1, 100, 100.00, 'B'));
+    session.step(make(CommandType::Add, 2, 200, 100.00, 'B'));   // virtual joins behind 300
+    ASSERT_NE(session.find_order(vid), nullptr);
+    EXPECT_EQ(session.find_order(vid)->queue_ahead, 300);
+
+    session.step(make(CommandType::Add, 3, 500, 100.00, 'B'));   // behind the virtual order
+    session.step(make(CommandType::Cancel, 3));
+    EXPECT_EQ(session.find_order(vid)->queue_ahead, 300);
+
+    session.step(make(CommandType::Reduce, 2, 80));              // ahead of it
+    EXPECT_EQ(session.find_order(vid)->queue_ahead, 220);
+
+    session.step(make(CommandType::Execute, 1, 100));
+    EXPECT_EQ(session.find_order(vid)->queue_ahead, 120);
+    EXPECT_TRUE(strategy.fills.empty());
+
+    // aggressive real sell: 120 clears the queue ahead, 30 fill the virtual order
+    session.step(make(CommandType::Add, 4, 150, 99.00, 'S'));
+    ASSERT_EQ(strategy.fills.size(), 1u);
+    EXPECT_EQ(strategy.fills[0].quantity, 30);
+    EXPECT_DOUBLE_EQ(strategy.fills[0].price, 100.00);
+    EXPECT_EQ(session.find_order(vid)->queue_ahead, 0);
+    EXPECT_EQ(session.find_order(vid)->remaining, 20);
+
+    // a real sell left resting at our bid would have hit us
+    session.step(make(CommandType::Add, 5, 40, 100.00, 'S'));
+    ASSERT_EQ(strategy.fills.size(), 2u);
+    EXPECT_EQ(strategy.fills[1].quantity, 20);
+    EXPECT_EQ(session.find_order(vid), nullptr);
+
+    BacktestResult r = session.result();
+    EXPECT_EQ(r.fills, 2u);
+    EXPECT_EQ(r.filled_quantity, 50);
+    EXPECT_EQ(r.net_position, 50);
+    EXPECT_DOUBLE_EQ(r.cash, -5000.0);
+}
+
+TEST(BacktestSession, MarketableOrderTakesDisplayedTouch) {
+    ScriptedStrategy strategy;
+    BacktestSession session(SYMBOLS, strategy, small_books());
+    strategy.on_update = [&](StrategyContext& ctx, const EngineCommand& cmd) {
+        if (cmd.order_id == 1) ctx.place(OrderSide::Buy, 101.00, 100);
+    };
+
+    session.step(make(CommandType::Add, 1, 60, 100.50, 'S'));
+    ASSERT_EQ(strategy.fills.size(), 1u);
+    EXPECT_TRUE(strategy.fills[0].aggressive);
+    EXPECT_EQ(strategy.fills[0].quantity, 60);
+    EXPECT_DOUBLE_EQ(strategy.fills[0].price, 100.50);
+
+    // the real book is untouched
+    EXPECT_EQ(session.book().get_best_ask().quantity, 60);
+    ASSERT_EQ(session.open_orders().size(), 1u);
+    EXPECT_EQ(session.open_orders()[0].remaining, 40);
+    EXPECT_THROW(session.place(OrderSide::Buy, 100.0, 0), std::invalid_argument);
+}
+
+// ---------- Harness ----------
+
+static std::vector<EngineCommand> random_flow(size_t n) {
+    std::mt19937 rng(11);
+    std::vector<EngineCommand> cmds;
+    std::vector<int64_t> live;
+    int64_t next_id = 1;
+    for (size_t i = 0; i < n; ++i) {
+        if (live.empty() || rng() % 3) {
+            char side = rng() % 2 ? 'B' : 'S';
+            double price = 100.00 + (side == 'B' ? -1.0 : 1.0) * (rng() % 4) * 0.01;
+            if (rng() % 10 == 0) price = side == 'B' ? 100.05 : 99.95;
+            cmds.push_back(make(CommandType::Add, next_id, 1 + rng() % 300, price, side));
+            live.push_back(next_id++);
+        } else {
+            size_t idx = rng() % live.size();
+            cmds.push_back(make(rng() % 2 ? CommandType::Cancel : CommandType::Execute, live[idx], 1 + rng() % 100));
+            live[idx] = live.back();
+            live.pop_back();
+        }
+        cmds.back().timestamp = i;
+    }
+    return cmds;
+}
+
+TEST(BacktestHarness, ParallelVariantsMatchSequentialRuns) {
+    const auto cmds = random_flow(20'000);
+    auto factory = [](size_t variant) {
+        JoinBestStrategy::Params params;
+        params.offset_ticks = static_cast<int32_t>(variant);
+        params.quote_size = 50;
+        return std::make_unique<JoinBestStrategy>(params);
+    };
+
+    BacktestConfig config = small_books();
+    config.threads = 3;
+    auto results = run_backtests(cmds, SYMBOLS, 4, factory, config);
+    ASSERT_EQ(results.size(), 4u);
+
+    for (size_t v = 0; v < results.size(); ++v) {
+        auto strategy = factory(v);
+        BacktestSession session(SYMBOLS, *strategy, small_books());
+        session.run(cmds);
+        BacktestResult expected = session.result();
+
+        EXPECT_EQ(results[v].variant, v);
+        EXPECT_EQ(results[v].commands, cmds.size());
+        EXPECT_EQ(results[v].fills, expected.fills);
+        EXPECT_EQ(results[v].net_position, expected.net_position);
+        EXPECT_DOUBLE_EQ(results[v].pnl, expected.pnl);
+    }
+    EXPECT_GT(results[0].fills, 0u);
+}
+
+TEST(BacktestHarness, VirtualOrdersDoNotPerturbTheRealBook) {
+    const auto cmds = random_flow(5'000);
+
+    Strategy idle;
+    BacktestSession baseline(SYMBOLS, idle, small_books());
+    baseline.run(cmds);
+
+    JoinBestStrategy quoting({100, 0, 1'000'000});
+    BacktestSession active(SYMBOLS, quoting, small_books());
+    active.run(cmds);
+
+    EXPECT_GT(active.result().fills, 0u);
+    auto expect_same = [](const LimitOrderBook::BestLevel& a, const LimitOrderBook::BestLevel& b) {
+        EXPECT_EQ(a.valid, b.valid);
+        EXPECT_DOUBLE_EQ(a.price, b.price);
+        EXPECT_EQ(a.quantity, b.quantity);
+    };
+    expect_same(baseline.book().get_best_bid(), active.book().get_best_bid());
+    expect_same(baseline.book().get_best_ask(), active.book().get_best_ask());
+    EXPECT_EQ(baseline.book().orders_by_id.size(), active.book().orders_by_id.size());
+}
+
+TEST(BacktestHarness, RethrowsVariantFailure) {
+    const auto cmds = random_flow(100);
+    auto factory = [](size_t variant) -> std::unique_ptr<Strategy> {
+        if (variant == 2) throw std::runtime_error("bad parameters");
+        return std::make_unique<Strategy>();
+    };
+    BacktestConfig config = small_books();
+    config.threads = 2;
+    EXPECT_THROW(run_backtests(cmds, SYMBOLS, 4, factory, config), std::runtime_error);
+}
@@ -0,0 +1,105 @@
+#include "BatchScheduler.h"
+#include "ItchTestUtil.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace itch_test;
+
+static void write_day(const fs::path& path, int orders) {
+    std::vector<char> stream;
+    frame(stream, directory(1, "AAPL"));
+    frame(stream, directory(2, "MSFT"));
+    for (int i = 1; i <= orders; ++i) {
+        uint16_t locate = i % 2 ? 1 : 2;
+        frame(stream, add(locate, 1000 + i, i, i % 3 ? 'B' : 'S', 100, i % 3 ? 1'000'000 : 1'010'000));
+    }
+    std::ofstream(path, std::ios::binary).write(stream.data(), stream.size());
+}
+
+class BatchReplayTest : public testing::Test {
+protected:
+    void SetUp() override {
+        // one directory per test, so ctest -j can run them side by side
+        root = fs::path(testing::TempDir()) /
+               (std::string("batch_replay_") + testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(root);
+        fs::create_directories(root / "in");
+        write_day(root / "in" / "day1.itch", 50);
+        write_day(root / "in" / "day2.itch", 500);
+        write_day(root / "in" / "day3.itch", 5);
+
+        opts.batch = true;
+        opts.headless = true;
+        opts.batch_inputs = {(root / "in" / "day*.itch").string()};
+        opts.output_dir = (root / "out").string();
+        opts.batch_workers = 2;
+        opts.tracked_symbols = {"AAPL", "MSFT"};
+        opts.flight_recorder_size = 0;
+    }
+
+    void TearDown() override { fs::remove_all(root); }
+
+    fs::path root;
+    AppOptions opts;
+};
+
+TEST_F(BatchReplayTest, PlansLargestFirstAndShardsSymbols) {
+    opts.batch_shards = 2;
+    BatchScheduler scheduler(opts);
+    auto jobs = scheduler.plan();
+
+    // each day splits into one job per non-empty shard
+    size_t expected_per_day = 0;
+    for (size_t shard = 0; shard < 2; ++shard) {
+        bool used = BatchScheduler::shard_of("AAPL", 2) == shard || BatchScheduler::shard_of("MSFT", 2) == shard;
+        expected_per_day += used;
+    }
+    ASSERT_EQ(jobs.size(), 3 * expected_per_day);
+
+    for (size_t i = 1; i < jobs.size(); ++i)
+        EXPECT_GE(jobs[i - 1].input_bytes, jobs[i].input_bytes);
+    EXPECT_EQ(fs::path(jobs.front().input_path).filename(), "day2.itch");
+}
+
+TEST_F(BatchReplayTest, RunsEveryJobAndResumes) {
+    {
+        BatchScheduler scheduler(opts);
+        auto results = scheduler.run();
+        ASSERT_EQ(results.size(), 3u);
+        for (const auto& r : results) {
+            EXPECT_EQ(r.status, BatchJobResult::Status::Done) << r.job.name << ": " << r.error;
+            EXPECT_EQ(r.summary.tracked_symbols, 2u);
+            EXPECT_TRUE(fs::exists(fs::path(opts.output_dir) / r.job.name / "trades.csv"));
+            EXPECT_TRUE(fs::exists(fs::path(opts.output_dir) / r.job.name / "DONE"));
+        }
+    }
+    EXPECT_TRUE(fs::exists(fs::path(opts.output_dir) / "batch_summary.csv"));
+
+    // second run finds the DONE markers and only reports
+    BatchScheduler again(opts);
+    auto results = again.run();
+    ASSERT_EQ(results.size(), 3u);
+    for (const auto& r : results) {
+        EXPECT_EQ(r.status, BatchJobResult::Status::Skipped);
+        EXPECT_GT(r.summary.messages, 0u);
+    }
+}
+
+TEST_F(BatchReplayTest, FailedJobDoesNotStopTheBatch) {
+    // length prefix promises 5 bytes, only the type byte follows
+    std::ofstream(root / "in" / "day4.itch", std::ios::binary) << std::string("\x00\x05R", 3);
+    BatchScheduler scheduler(opts);
+    auto results = scheduler.run();
+
+    size_t failed = 0, done = 0;
+    for (const auto& r : results) {
+        failed += r.status == BatchJobResult::Status::Failed;
+        done += r.status == BatchJobResult::Status::Done;
+    }
+    EXPECT_EQ(failed, 1u);
+    EXPECT_EQ(done, 3u);
+}
@@ -0,0 +1,273 @@
+#include "BookDelta.h"
+#include "DashboardServer.h"
+#include "MarketState.h"
+#include "WebSocket.h"
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// ---------- Protocol pieces ----------
+
+TEST(WebSocket, HandshakeKeyMatchesRfc6455Example) {
+    auto digest = websocket::sha1("abc");
+    EXPECT_EQ(websocket::base64(digest.data(), digest.size()), "qZk+NkcGgWq6PiVxeFDCbJzQ2J0=");
+    EXPECT_EQ(websocket::accept_key("dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(WebSocket, ParsesMaskedClientFrame) {
+    // "Hello" masked with 37 fa 21 3d, from RFC 6455 section 5.7
+    const std::string wire("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58", 11);
+    websocket::Frame frame;
+    EXPECT_EQ(websocket::parse_frame(wire.substr(0, 6), frame), 0u);
+    EXPECT_EQ(websocket::parse_frame(wire, frame), wire.size());
+    EXPECT_EQ(frame.opcode, websocket::TEXT);
+    EXPECT_EQ(frame.payload, "Hello");
+}
+
+TEST(BookDelta, DeltaCarriesOnlyChangedLevels) {
+    LimitOrderBook book(0.0, 1000.0, 1000);
+    MarketStateStore store(5);
+    store.add_symbol(3, "AAPL");
+    store.watch(3);
+
+    book.process_order(1, 100.00, 10, OrderSide::Buy);
+    book.process_order(2, 99.99, 20, OrderSide::Buy);
+    book.process_order(3, 100.02, 30, OrderSide::Sell);
+    store.publish(3, book, 1000);
+    BookSnapshot first;
+    ASSERT_TRUE(store.read(3, first));
+
+    std::string full;
+    ASSERT_TRUE(book_delta::encode(nullptr, first, store.depth(), full));
+    BookSnapshot client;
+    ASSERT_TRUE(book_delta::apply(client, full.data(), full.size()));
+    EXPECT_EQ(client.bid_levels, 2);
+    EXPECT_EQ(client.bid_price[1], 9999);
+    EXPECT_EQ(client.ask_qty[0], 30);
+
+    book.process_order(4, 100.00, 5, OrderSide::Sell);     // trades 5 against the best bid
+    store.record_trade(3, 100.00, 5);
+    store.publish(3, book, 2000);
+    BookSnapshot second;
+    ASSERT_TRUE(store.read(3, second));
+
+    std::string delta;
+    ASSERT_TRUE(book_delta::encode(&first, second, store.depth(), delta));
+    EXPECT_EQ(delta.size(), book_delta::HEADER_SIZE + 2 * book_delta::ENTRY_SIZE);   // best bid + trade
+    ASSERT_TRUE(book_delta::apply(client, delta.data(), delta.size()));
+    EXPECT_EQ(client.bid_qty[0], 5);
+    EXPECT_EQ(client.last_price, 10000);
+    EXPECT_EQ(client.timestamp, 2000u);
+
+    std::string none;
+    EXPECT_FALSE(book_delta::encode(&second, second, store.depth(), none));
+    EXPECT_TRUE(none.empty());
+}
+
+// ---------- Server over localhost ----------
+
+namespace {
+
+int connect_local(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    timeval tv{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+void send_all(int fd, const std::string& data) {
+    ASSERT_EQ(::send(fd, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+}
+
+std::string read_until(int fd, std::string& buffer, const std::string& marker) {
+    char buf[4096];
+    size_t pos;
+    while ((pos = buffer.find(marker)) == std::string::npos) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return {};
+        buffer.append(buf, static_cast<size_t>(n));
+    }
+    std::string head = buffer.substr(0, pos + marker.size());
+    buffer.erase(0, pos + marker.size());
+    return head;
+}
+
+bool read_frame(int fd, std::string& buffer, websocket::Frame& frame) {
+    char buf[4096];
+    while (true) {
+        size_t used = websocket::parse_frame(buffer, frame, 1 << 20);
+        if (used && used != SIZE_MAX) {
+            buffer.erase(0, used);
+            return true;
+        }
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        buffer.append(buf, static_cast<size_t>(n));
+    }
+}
+
+std::string masked_text(const std::string& text) {
+    std::string out;
+    out.push_back(static_cast<char>(0x81));
+    out.push_back(static_cast<char>(0x80 | text.size()));
+    const char mask[4] = {1, 2, 3, 4};
+    out.append(mask, 4);
+    for (size_t i = 0; i < text.size(); ++i) out.push_back(text[i] ^ mask[i % 4]);
+    return out;
+}
+
+// Connects, upgrades and returns the socket after the symbol list arrives
+int open_websocket(uint16_t port, std::string& buffer, std::string& symbols) {
+    int fd = connect_local(port);
+    if (fd < 0) return -1;
+    send_all(fd, "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                 "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+    std::string head = read_until(fd, buffer, "\r\n\r\n");
+    if (head.find("101") == std::string::npos || head.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == std::string::npos) {
+        ::close(fd);
+        return -1;
+    }
+    websocket::Frame frame;
+    if (!read_frame(fd, buffer, frame)) {
+        ::close(fd);
+        return -1;
+    }
+    symbols = frame.payload;
+    return fd;
+}
+
+} // namespace
+
+TEST(DashboardServer, ServesPageAndStreamsSubscribedBook) {
+    MarketStateStore store(5);
+    store.add_symbol(7, "MSFT");
+    DashboardServer server(store, 0, std::chrono::milliseconds(5));
+    server.start();
+    ASSERT_NE(server.port(), 0);
+
+    {
+        int fd = connect_local(server.port());
+        ASSERT_GE(fd, 0);
+        send_all(fd, "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        std::string buffer;
+        std::string head = read_until(fd, buffer, "\r\n\r\n");
+        EXPECT_NE(head.find("200 OK"), std::string::npos);
+        read_until(fd, buffer, "</html>");
+        ::close(fd);
+    }
+
+    std::string buffer, symbols;
+    int fd = open_websocket(server.port(), buffer, symbols);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(symbols, "{\"symbols\":[[\"MSFT\",7]]}");
+
+    EXPECT_FALSE(store.watched(7));
+    send_all(fd, masked_text("sub MSFT"));
+    for (int i = 0; i < 200 && !store.watched(7); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_TRUE(store.watched(7));
+
+    LimitOrderBook book(0.0, 1000.0, 1000);
+    book.process_order(1, 250.00, 40, OrderSide::Buy);
+    book.process_order(2, 250.05, 60, OrderSide::Sell);
+    store.publish(7, book, 123);
+
+    BookSnapshot client;
+    websocket::Frame frame;
+    while (client.timestamp != 123) {
+        ASSERT_TRUE(read_frame(fd, buffer, frame));
+        ASSERT_EQ(frame.opcode, websocket::BINARY);
+        ASSERT_TRUE(book_delta::apply(client, frame.payload.data(), frame.payload.size()));
+    }
+    EXPECT_EQ(client.locate, 7);
+    EXPECT_EQ(client.bid_price[0], 25000);
+    EXPECT_EQ(client.ask_qty[0], 60);
+
+    ::close(fd);
+    for (int i = 0; i < 200 && store.watched(7); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_FALSE(store.watched(7));
+    server.stop();
+}
+
+TEST(DashboardServer, EscapesErrorsAndClosesOnUnmaskedFrames) {
+    MarketStateStore store(5);
+    store.add_symbol(7, "MSFT");
+    DashboardServer server(store, 0, std::chrono::milliseconds(5));
+    server.start();
+
+    std::string buffer, symbols;
+    int fd = open_websocket(server.port(), buffer, symbols);
+    ASSERT_GE(fd, 0);
+
+    websocket::Frame frame;
+    send_all(fd, masked_text("sub X\",\"y\":\"\\"));
+    ASSERT_TRUE(read_frame(fd, buffer, frame));
+    ASSERT_EQ(frame.opcode, websocket::TEXT);
+    EXPECT_EQ(frame.payload, "{\"error\":\"unknown symbol X\\\",\\\"y\\\":\\\"\\\\\"}");
+
+    // a client frame without a mask is a protocol error (close code 1002)
+    send_all(fd, std::string("\x81\x08sub MSFT", 10));
+    ASSERT_TRUE(read_frame(fd, buffer, frame));
+    ASSERT_EQ(frame.opcode, websocket::CLOSE);
+    EXPECT_EQ(frame.payload, std::string("\x03\xea", 2));
+    EXPECT_FALSE(store.watched(7));
+
+    ::close(fd);
+    server.stop();
+}
+
+TEST(DashboardServer, SlowClientGetsLatestStateNotBacklog) {
+    MarketStateStore store(5);
+    store.add_symbol(1, "AAPL");
+    DashboardServer server(store, 0, std::chrono::milliseconds(2));
+    server.start();
+
+    std::string buffer, symbols;
+    int fd = open_websocket(server.port(), buffer, symbols);
+    ASSERT_GE(fd, 0);
+    send_all(fd, masked_text("sub AAPL"));
+    for (int i = 0; i < 200 && !store.watched(1); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_TRUE(store.watched(1));
+
+    // many more updates than pushes; the client reads nothing meanwhile
+    LimitOrderBook book(0.0, 1000.0, 100'000);
+    const int updates = 20'000;
+    for (int i = 1; i <= updates; ++i) {
+        book.process_order(i, 100.00 + (i % 50) * 0.01, 1, OrderSide::Buy);
+        store.publish(1, book, static_cast<uint64_t>(i));
+    }
+
+    BookSnapshot latest;
+    ASSERT_TRUE(store.read(1, latest));
+
+    BookSnapshot client;
+    websocket::Frame frame;
+    int frames = 0;
+    while (client.timestamp != static_cast<uint64_t>(updates)) {
+        ASSERT_TRUE(read_frame(fd, buffer, frame));
+        ASSERT_TRUE(book_delta::apply(client, frame.payload.data(), frame.payload.size()));
+        ++frames;
+    }
+    EXPECT_LT(frames, updates / 10);
+    for (size_t i = 0; i < store.depth(); ++i) {
+        EXPECT_EQ(client.bid_price[i], latest.bid_price[i]);
+        EXPECT_EQ(client.bid_qty[i], latest.bid_qty[i]);
+    }
+    ::close(fd);
+}
@@ -0,0 +1,610 @@
+#include "BlockSource.h"
+#include "CommandCache.h"
+#include "ItchDispatcher.h"
+#include "ItchFramer.h"
+#include "ItchMerge.h"
+#include "ItchPrefilter.h"
+#include "ItchTestUtil.h"
+#include "MoldUdp.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#ifdef ORDERBOOK_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace itch_test;
+
+static std::vector<std::vector<char>> sample_messages() {
+    std::vector<std::vector<char>> msgs;
+    msgs.push_back(directory(5, "AAPL"));
+    for (uint64_t i = 1; i <= 200; ++i)
+        msgs.push_back(add(5, 1000 + i, i, i % 2 ? 'B' : 'S', 100, i % 2 ? 1'000'000 : 1'010'000));
+    for (uint64_t i = 1; i <= 200; i += 3)
+        msgs.push_back(del(5, 5000 + i, i));
+    return msgs;
+}
+
+static std::vector<char> to_stream(const std::vector<std::vector<char>>& msgs) {
+    std::vector<char> stream;
+    for (const auto& m : msgs)
+        frame(stream, m);
+    return stream;
+}
+
+static void expect_frames(BlockSource& source, const std::vector<std::vector<char>>& msgs) {
+    ItchFramer framer(source);
+    ItchMessageView view;
+    size_t i = 0;
+    while (framer.next(view)) {
+        ASSERT_LT(i, msgs.size());
+        ASSERT_EQ(view.length, msgs[i].size()) << "message " << i;
+        EXPECT_EQ(std::memcmp(view.data, msgs[i].data(), view.length), 0) << "message " << i;
+        ++i;
+    }
+    EXPECT_EQ(i, msgs.size());
+}
+
+// ---------- Framing ----------
+
+TEST(ItchFramer, StitchesMessagesAcrossBlockBoundaries) {
+    auto msgs = sample_messages();
+    auto stream = to_stream(msgs);
+
+    // 1-byte blocks split even the length prefix; 4096 leaves most messages whole
+    for (size_t block : {1u, 2u, 7u, 37u, 4096u}) {
+        VectorSource source(stream, block);
+        expect_frames(source, msgs);
+    }
+}
+
+TEST(ItchFramer, TruncatedTailThrows) {
+    auto stream = to_stream(sample_messages());
+    stream.resize(stream.size() - 3);
+
+    VectorSource source(stream, 64);
+    ItchFramer framer(source);
+    ItchMessageView view;
+    EXPECT_THROW({ while (framer.next(view)) {} }, std::runtime_error);
+}
+
+TEST(PipelinedSource, ReadsPlainFileThroughRing) {
+    auto msgs = sample_messages();
+    auto stream = to_stream(msgs);
+
+    const std::string path = testing::TempDir() + "plain.itch";
+    std::ofstream(path, std::ios::binary).write(stream.data(), stream.size());
+
+    // tiny blocks and a short ring force many producer/consumer handoffs
+    auto source = open_block_source(path, 100, 2);
+    expect_frames(*source, msgs);
+    std::remove(path.c_str());
+}
+
+#ifdef ORDERBOOK_HAVE_ZLIB
+TEST(PipelinedSource, InflatesMultiMemberGzip) {
+    auto msgs = sample_messages();
+    auto stream = to_stream(msgs);
+
+    // two concatenated gzip members, split mid-message
+    const std::string path = testing::TempDir() + "multi.itch.gz";
+    const size_t split = stream.size() / 2 + 3;
+    {
+        gzFile gz = gzopen(path.c_str(), "wb");
+        gzwrite(gz, stream.data(), static_cast<unsigned>(split));
+        gzclose(gz);
+        gz = gzopen(path.c_str(), "ab");
+        gzwrite(gz, stream.data() + split, static_cast<unsigned>(stream.size() - split));
+        gzclose(gz);
+    }
+
+    auto source = open_block_source(path, 256, 3);
+    expect_frames(*source, msgs);
+    std::remove(path.c_str());
+}
+
+TEST(PipelinedSource, InflatesMembersInParallel) {
+    auto msgs = sample_messages();
+    auto stream = to_stream(msgs);
+
+    // one member per 37 bytes, cutting through messages
+    const std::string path = testing::TempDir() + "members.itch.gz";
+    for (size_t at = 0; at < stream.size(); at += 37) {
+        gzFile gz = gzopen(path.c_str(), at == 0 ? "wb" : "ab");
+        gzwrite(gz, stream.data() + at, static_cast<unsigned>(std::min<size_t>(37, stream.size() - at)));
+        gzclose(gz);
+    }
+
+    auto source = open_block_source(path, 256, 3, 3);
+    expect_frames(*source, msgs);
+    std::remove(path.c_str());
+}
+
+TEST(GzipProducer, ParallelMembersSurviveFalseHeaders) {
+    // stored (level 0) members carry their payload verbatim, so gzip header
+    // bytes in the payload show up as false member candidates
+    std::mt19937 rng(7);
+    std::vector<char> payload(300'000);
+    for (auto& c : payload) c = static_cast<char>(rng());
+    const unsigned char fake[] = {0x1f, 0x8b, 0x08, 0x00, 0, 0, 0, 0, 0, 3};
+    for (size_t at = 1000; at + sizeof(fake) < payload.size(); at += 7919)
+        std::memcpy(payload.data() + at, fake, sizeof(fake));
+
+    const std::string path = testing::TempDir() + "false_headers.gz";
+    const size_t member = 40'000;
+    for (size_t at = 0, k = 0; at < payload.size(); at += member, ++k) {
+        gzFile gz = gzopen(path.c_str(), at == 0 ? (k % 2 ? "wb6" : "wb0") : (k % 2 ? "ab6" : "ab0"));
+        gzwrite(gz, payload.data() + at, static_cast<unsigned>(std::min(member, payload.size() - at)));
+        gzclose(gz);
+    }
+
+    for (size_t threads : {1, 2, 4}) {
+        SCOPED_TRACE("threads " + std::to_string(threads));
+        GzipProducer producer(path, threads);
+        std::vector<char> out;
+        char buf[5000];
+        while (size_t n = producer.fill(buf, sizeof(buf))) out.insert(out.end(), buf, buf + n);
+        EXPECT_TRUE(out == payload);
+    }
+    std::remove(path.c_str());
+}
+#endif
+
+// ---------- Dispatch ----------
+
+TEST(ItchDispatcher, RoutesTrackedSymbolsOnly) {
+    std::unordered_map<uint16_t, std::unique_ptr<MatchingEngine>> engines;
+    ItchDispatcher dispatcher({"AAPL", "MSFT"}, [&](uint16_t locate, const std::string&) {
+        engines[locate] = std::make_unique<MatchingEngine>(std::make_unique<LimitOrderBook>(0.0, 1000.0));
+        return engines[locate].get();
+    });
+
+    std::vector<std::vector<char>> msgs = {
+        directory(1, "AAPL"),
+        directory(2, "TSLA"),                 // not tracked
+        directory(3, "MSFT", 'T'),            // test security
+        add(1, 10, 100, 'B', 300, 1'500'000),
+        add(1, 11, 101, 'S', 200, 1'501'000),
+        add(2, 12, 102, 'B', 100, 1'000'000),
+        cancel(1, 13, 100, 50),
+        execute(1, 14, 100, 25),
+        replace(1, 15, 101, 103, 150, 1'502'000),
+    };
+    for (const auto& m : msgs)
+        dispatcher.dispatch(m.data(), m.size());
+
+    EXPECT_EQ(dispatcher.tracked_count(), 1u);
+    EXPECT_TRUE(dispatcher.is_tracked(1));
+    EXPECT_FALSE(dispatcher.is_tracked(2));
+    EXPECT_FALSE(dispatcher.is_tracked(3));
+    EXPECT_EQ(dispatcher.symbol(1), "AAPL");
+
+    auto& book = engines[1]->get_book();
+    auto bid = book->get_best_bid();
+    auto ask = book->get_best_ask();
+    EXPECT_NEAR(bid.price, 150.00, 1e-9);
+    EXPECT_EQ(bid.quantity, 225);
+    EXPECT_NEAR(ask.price, 150.20, 1e-9);
+    EXPECT_EQ(ask.quantity, 150);
+
+    BookStats s = book->get_stats();
+    EXPECT_EQ(s.adds, 2u);
+    EXPECT_EQ(s.reduces, 1u);
+    EXPECT_EQ(s.fills, 1u);
+    EXPECT_EQ(s.replaces, 1u);
+}
+
+// ---------- Prefilter ----------
+
+// Mostly untracked traffic over 300 locates, with directory messages and a
+// few odd short messages sprinkled in
+static std::vector<std::vector<char>> mixed_messages() {
+    std::mt19937 rng(7);
+    std::vector<std::vector<char>> msgs;
+    for (uint64_t i = 0; i < 3000; ++i) {
+        const uint16_t locate = static_cast<uint16_t>(rng() % 300);
+        switch (rng() % 20) {
+        case 0: msgs.push_back(directory(locate, std::string("S") + std::to_string(locate))); break;
+        case 1: msgs.push_back({'Z'}); break;
+        case 2: msgs.push_back(del(locate, i, i)); break;
+        case 3: msgs.push_back(execute(locate, i, i, 10)); break;
+        default: msgs.push_back(add(locate, i, i, 'B', 100, 1'000'000)); break;
+        }
+    }
+    return msgs;
+}
+
+static bool survives(const std::vector<char>& m, const ItchPrefilter& filter) {
+    return m.size() < 3 || m[0] == 'R' || filter.tracked(itch::read_be16(m.data() + 1));
+}
+
+TEST(ItchPrefilter, VectorAndScalarScansAgree) {
+    auto msgs = mixed_messages();
+    auto stream = to_stream(msgs);
+
+    ItchPrefilter scalar(false), simd(true);
+    for (uint16_t locate = 0; locate < 300; locate += 37) {
+        scalar.track(locate);
+        simd.track(locate);
+    }
+    EXPECT_FALSE(scalar.simd());
+    EXPECT_EQ(simd.simd(), ItchPrefilter::cpu_has_avx2());
+
+    // rescan from each stop, as the framer would after handling that message
+    for (const ItchPrefilter* filter : {&scalar, &simd}) {
+        std::vector<size_t> kept;
+        const char* p = stream.data();
+        const char* end = stream.data() + stream.size();
+        uint64_t scanned = 0;
+        while (p < end) {
+            std::vector<uint32_t> survivors;
+            const char* stop = filter->scan(p, end, survivors, scanned);
+            for (uint32_t off : survivors) kept.push_back(p + off - stream.data());
+            if (stop == end) break;
+            if (itch::read_be16(stop) < 3) {
+                kept.push_back(stop - stream.data());
+                ++scanned;
+                stop += 2 + itch::read_be16(stop);
+            }
+            p = stop;
+        }
+        EXPECT_EQ(scanned, msgs.size());
+
+        std::vector<size_t> expected;
+        size_t offset = 0;
+        for (const auto& m : msgs) {
+            if (survives(m, *filter)) expected.push_back(offset);
+            offset += 2 + m.size();
+        }
+        EXPECT_EQ(kept, expected) << (filter->simd() ? "avx2" : "scalar");
+    }
+}
+
+TEST(ItchPrefilter, RunDeliversTrackedMessagesInOrderAcrossBlocks) {
+    auto msgs = mixed_messages();
+    auto stream = to_stream(msgs);
+
+    for (bool allow_simd : {false, true}) {
+        for (size_t block : {5u, 64u, 4096u, 1u << 20}) {
+            VectorSource source(stream, block);
+            ItchFramer framer(source);
+            ItchPrefilter filter(allow_simd);
+
+            // a locate becomes tracked at its first directory message, like
+            // the dispatcher would do
+            ItchPrefilter reference(false);
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < msgs.size(); ++i) {
+                if (survives(msgs[i], reference)) expected.push_back(i);
+                if (msgs[i][0] == 'R') reference.track(itch::read_be16(msgs[i].data() + 1));
+            }
+
+            std::vector<size_t> delivered;
+            size_t cursor = 0;
+            uint64_t framed = filter.run(framer, [&](const char* data, uint16_t length) {
+                // find the message by content from the last delivered position
+                while (cursor < msgs.size() &&
+                       (msgs[cursor].size() != length || std::memcmp(msgs[cursor].data(), data, length) != 0))
+                    ++cursor;
+                ASSERT_LT(cursor, msgs.size());
+                delivered.push_back(cursor++);
+                if (data[0] == 'R') filter.track(itch::stock_locate(data));
+            });
+
+            EXPECT_EQ(framed, msgs.size()) << "block " << block;
+            // the filter may pass extra messages (the one after each scan stop,
+            // every message cut by a block edge), never drop a tracked one
+            EXPECT_TRUE(std::includes(delivered.begin(), delivered.end(), expected.begin(), expected.end()))
+                << "block " << block;
+            if (block >= 4096) {
+                EXPECT_LT(delivered.size(), expected.size() + msgs.size() / 4) << "block " << block;
+            }
+        }
+    }
+}
+
+// ---------- Merge ----------
+
+// Per-input streams with non-decreasing timestamps, frequent ties across
+// inputs, and short messages that inherit their input's previous timestamp.
+// One input is empty. `expected` is the stable merge of them all.
+static std::vector<std::vector<std::vector<char>>> merge_inputs(std::vector<std::vector<char>>& expected) {
+    std::mt19937 rng(11);
+    std::vector<std::vector<std::vector<char>>> inputs(5);
+    struct Tagged { uint64_t ts; size_t input, pos; };
+    std::vector<Tagged> order;
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        if (k == 3) continue;
+        uint64_t ts = 0;
+        for (size_t j = 0; j < 400 + 100 * k; ++j) {
+            if (rng() % 15 == 0) {
+                inputs[k].push_back({'Z', static_cast<char>(k)});
+            } else {
+                ts += rng() % 3 * 1000;
+                inputs[k].push_back(add(static_cast<uint16_t>(k), ts, k << 32 | j, 'B', 100, 1'000'000));
+            }
+            order.push_back({ts, k, j});
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [](const Tagged& a, const Tagged& b) {
+        return a.ts != b.ts ? a.ts < b.ts : a.input < b.input;
+    });
+    for (const auto& t : order)
+        expected.push_back(inputs[t.input][t.pos]);
+    return inputs;
+}
+
+TEST(ItchMerge, MergesInTimestampOrderStably) {
+    std::vector<std::vector<char>> expected;
+    auto inputs = merge_inputs(expected);
+
+    for (size_t block : {1u, 37u, 4096u}) {
+        std::vector<std::unique_ptr<BlockSource>> sources;
+        for (const auto& msgs : inputs)
+            sources.push_back(std::make_unique<VectorSource>(to_stream(msgs), block));
+        ItchMerge merge(std::move(sources));
+        ASSERT_EQ(merge.inputs(), 5u);
+
+        ItchMessageView view;
+        size_t i = 0;
+        while (merge.next(view)) {
+            ASSERT_LT(i, expected.size());
+            ASSERT_EQ(view.length, expected[i].size()) << "message " << i << ", block " << block;
+            EXPECT_EQ(std::memcmp(view.data, expected[i].data(), view.length), 0) << "message " << i;
+            ++i;
+        }
+        EXPECT_EQ(i, expected.size());
+        EXPECT_FALSE(merge.next(view));
+        EXPECT_EQ(merge.bytes_consumed(), to_stream(expected).size());
+    }
+}
+
+TEST(ItchMerge, ProducerReframesIntoSmallBlocks) {
+    std::vector<std::vector<char>> expected;
+    auto inputs = merge_inputs(expected);
+
+    // 7-byte blocks split nearly every message across two handoffs
+    for (size_t block : {7u, 4096u}) {
+        std::vector<std::unique_ptr<BlockSource>> sources;
+        for (const auto& msgs : inputs)
+            sources.push_back(std::make_unique<VectorSource>(to_stream(msgs), 64));
+        PipelinedSource merged(std::make_unique<ItchMergeProducer>(std::move(sources)), block, 3);
+        expect_frames(merged, expected);
+    }
+}
+
+TEST(ItchMerge, OpensFilesAndRejectsCommandCaches) {
+    std::vector<std::vector<char>> expected;
+    auto inputs = merge_inputs(expected);
+
+    std::vector<std::string> paths;
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        paths.push_back(testing::TempDir() + "merge" + std::to_string(k) + ".itch");
+        auto stream = to_stream(inputs[k]);
+        std::ofstream(paths.back(), std::ios::binary).write(stream.data(), stream.size());
+    }
+    {
+        auto merged = open_merged_source(paths, 256, 2);
+        expect_frames(*merged, expected);
+    }
+
+    const std::string cache = testing::TempDir() + "merge.cmdcache";
+    {
+        CommandCacheWriter writer(cache);
+        writer.finish();
+    }
+    paths.push_back(cache);
+    EXPECT_THROW(open_merged_source(paths), std::runtime_error);
+
+    for (const auto& path : paths)
+        std::remove(path.c_str());
+}
+
+// ---------- MoldUDP64 ----------
+
+static MoldUdpReceiverConfig loopback_receiver() {
+    MoldUdpReceiverConfig config;
+    config.bind_address = "127.0.0.1";
+    config.busy_poll = false;
+    config.idle_timeout_ms = 5000; // a test that loses its end of session still ends
+    return config;
+}
+
+static MoldUdpPublisherConfig loopback_publisher(uint16_t port) {
+    MoldUdpPublisherConfig config;
+    config.port = port;
+    config.max_payload = 200; // a handful of messages per packet
+    return config;
+}
+
+TEST(MoldUdp, LoopbackReplayDeliversEveryMessageInOrder) {
+    auto msgs = sample_messages();
+    MoldUdpReceiver receiver(loopback_receiver());
+    MoldUdpPublisher publisher(loopback_publisher(receiver.port()));
+
+    MoldUdpPublisher::Stats sent;
+    std::thread thread([&] {
+        VectorSource source(to_stream(msgs), 64);
+        sent = publisher.run(source);
+    });
+    expect_frames(receiver, msgs);
+    thread.join();
+
+    EXPECT_GT(sent.packets, 10u);
+    EXPECT_EQ(receiver.stats().messages, msgs.size());
+    EXPECT_EQ(receiver.stats().gaps, 0u);
+    EXPECT_EQ(receiver.next_sequence(), msgs.size() + 1);
+    EXPECT_NE(receiver.packet_time_ns(), 0u);
+}
+
+TEST(MoldUdp, RequestsRecoverDroppedPackets) {
+    auto msgs = sample_messages();
+    MoldUdpReceiver receiver(loopback_receiver());
+    auto publisher_config = loopback_publisher(receiver.port());
+    publisher_config.drop_every = 3;
+    publisher_config.serve_requests = true;
+    publisher_config.linger_ms = 300;
+    MoldUdpPublisher publisher(publisher_config);
+    receiver.set_request_server("127.0.0.1", publisher.request_port());
+
+    MoldUdpPublisher::Stats sent;
+    std::thread thread([&] {
+        VectorSource source(to_stream(msgs), 64);
+        sent = publisher.run(source);
+    });
+    expect_frames(receiver, msgs);
+    thread.join();
+
+    EXPECT_GT(sent.dropped, 0u);
+    EXPECT_GT(receiver.stats().gaps, 0u);
+    EXPECT_GE(sent.retransmitted, sent.dropped);
+    EXPECT_EQ(receiver.stats().lost, 0u);
+    EXPECT_EQ(receiver.stats().messages, msgs.size());
+}
+
+TEST(MoldUdp, TrimsOverlapsAndSkipsUnfilledGaps) {
+    auto config = loopback_receiver();
+    config.gap_timeout_ms = 20;
+    MoldUdpReceiver receiver(config);
+    std::vector<std::pair<uint64_t, uint64_t>> gaps;
+    receiver.set_gap_callback([&](uint64_t first, uint64_t count) { gaps.emplace_back(first, count); });
+
+    auto msgs = sample_messages();
+    auto packet = [&](uint64_t sequence, uint16_t count) {
+        moldudp64::Header header;
+        header.session = moldudp64::make_session("S1");
+        header.sequence = sequence;
+        header.count = count;
+        std::vector<char> bytes(moldudp64::HEADER_SIZE);
+        moldudp64::write_header(bytes.data(), header);
+        for (uint64_t s = sequence; count != moldudp64::END_OF_SESSION && s < sequence + count; ++s)
+            frame(bytes, msgs[s - 1]);
+        return bytes;
+    };
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(receiver.port());
+    ::inet_pton(AF_INET, "127.0.0.1", &to.sin_addr);
+    // 1-3, an overlapping 2-5, a duplicate, then 9-10 leaves 6-8 missing
+    for (const auto& bytes : {packet(1, 3), packet(2, 4), packet(1, 2), packet(9, 2),
+                              packet(11, moldudp64::END_OF_SESSION)})
+        ::sendto(fd, bytes.data(), bytes.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+    ::close(fd);
+
+    std::vector<std::vector<char>> expected(msgs.begin(), msgs.begin() + 5);
+    expected.insert(expected.end(), msgs.begin() + 8, msgs.begin() + 10);
+    expect_frames(receiver, expected);
+
+    ASSERT_EQ(gaps.size(), 1u);
+    EXPECT_EQ(gaps[0], std::make_pair(uint64_t{6}, uint64_t{3}));
+    EXPECT_EQ(receiver.stats().duplicates, 1u);
+    EXPECT_EQ(receiver.stats().lost, 3u);
+    EXPECT_EQ(receiver.stats().messages, 7u);
+}
+
+// ---------- Command cache ----------
+
+TEST(CommandCache, ReplayMatchesDirectDispatch) {
+    std::vector<std::vector<char>> msgs = {
+        directory(1, "AAPL"),
+        directory(2, "TSLA"),                 // not tracked
+        add(1, 10, 100, 'B', 300, 1'500'000),
+        add(1, 11, 101, 'S', 200, 1'501'000),
+        add(2, 12, 102, 'B', 100, 1'000'000),
+        cancel(1, 13, 100, 50),
+        add(1, 14, 104, 'S', 80, 1'499'000),  // crosses the bid
+        execute(1, 15, 100, 25),
+        replace(1, 16, 101, 103, 150, 1'502'000),
+        del(1, 17, 103),
+    };
+
+    const std::string path = testing::TempDir() + "day.cmdcache";
+    VectorSource source(to_stream(msgs), 16);
+    auto built = build_command_cache(source, {"AAPL"}, path);
+    EXPECT_EQ(built.messages, msgs.size());
+    EXPECT_EQ(built.symbols, 1u);
+    EXPECT_EQ(built.commands, 7u);
+    ASSERT_TRUE(command_cache::is_cache_file(path));
+
+    CommandCacheReader cache(path);
+    ASSERT_EQ(cache.symbols().size(), 1u);
+    EXPECT_EQ(cache.symbols()[0].first, 1);
+    EXPECT_EQ(cache.symbols()[0].second, "AAPL");
+
+    auto commands = cache.commands();
+    ASSERT_EQ(commands.size(), 7u);
+    EXPECT_EQ(commands[0].type, CommandType::Add);
+    EXPECT_EQ(commands[0].timestamp, 10u);
+    EXPECT_EQ(commands[0].price, 1'500'000u);
+    EXPECT_EQ(commands[5].type, CommandType::Replace);
+    EXPECT_EQ(commands[5].new_order_id, 103);
+
+    MatchingEngine direct(std::make_unique<LimitOrderBook>(0.0, 1000.0));
+    ItchDispatcher dispatcher({"AAPL"}, [&](uint16_t, const std::string&) { return &direct; });
+    for (const auto& m : msgs)
+        dispatcher.dispatch(m.data(), m.size());
+
+    MatchingEngine cached(std::make_unique<LimitOrderBook>(0.0, 1000.0));
+    cached.apply_batch(commands.data(), commands.size());
+
+    auto& a = direct.get_book();
+    auto& b = cached.get_book();
+    EXPECT_EQ(a->get_best_bid().quantity, b->get_best_bid().quantity);
+    EXPECT_DOUBLE_EQ(a->get_best_bid().price, b->get_best_bid().price);
+    EXPECT_EQ(a->get_best_ask().valid, b->get_best_ask().valid);
+    EXPECT_EQ(a->orders_by_id.size(), b->orders_by_id.size());
+
+    BookStats sa = a->get_stats();
+    BookStats sb = b->get_stats();
+    EXPECT_EQ(sa.adds, sb.adds);
+    EXPECT_EQ(sa.fills, sb.fills);
+    EXPECT_EQ(sa.matches, sb.matches);
+    EXPECT_EQ(sa.replaces, sb.replaces);
+    EXPECT_EQ(sa.cancels, sb.cancels);
+    std::remove(path.c_str());
+}
+
+TEST(CommandCache, RejectsUnfinishedFile) {
+    const std::string path = testing::TempDir() + "partial.cmdcache";
+    {
+        CommandCacheWriter writer(path);
+        writer.append(EngineCommand{});
+        // destroyed without finish()
+    }
+    EXPECT_FALSE(command_cache::is_cache_file(path));
+    EXPECT_THROW(CommandCacheReader reader(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(CommandCache, RejectsRecordCountsThatWrap) {
+    const std::string path = testing::TempDir() + "wrapped.cmdcache";
+    {
+        CommandCacheWriter writer(path);
+        writer.append(EngineCommand{});
+        writer.finish();
+    }
+    {
+        // records_offset + count * sizeof(EngineCommand) overflows to a small value
+        const uint64_t count = ~uint64_t{0} / sizeof(EngineCommand) + 1;
+        std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(offsetof(command_cache::Header, record_count));
+        io.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    EXPECT_THROW(CommandCacheReader reader(path), std::runtime_error);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+// Builders for synthetic ITCH 5.0 streams used across the feed tests.
+
+#include "BlockSource.h"
+#include "ItchMessage.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace itch_test {
+
+inline void put_be(std::vector<char>& out, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i)
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+}
+
+inline std::vector<char> header(char type, uint16_t locate, uint64_t timestamp) {
+    std::vector<char> m;
+    m.push_back(type);
+    put_be(m, locate, 2);
+    put_be(m, 0, 2);            // tracking number
+    put_be(m, timestamp, 6);
+    return m;
+}
+
+inline std::vector<char> directory(uint16_t locate, const std::string& symbol, char authenticity = 'P',
+                                   char issue_classification = 'C', char financial_status = 'N') {
+    auto m = header('R', locate, 0);
+    std::string padded = symbol;
+    padded.resize(8, ' ');
+    m.insert(m.end(), padded.begin(), padded.end());
+    m.push_back('Q');                   // market category
+    m.push_back(financial_status);
+    put_be(m, 100, 4);                  // round lot size
+    m.push_back('N');                   // round lots only
+    m.push_back(issue_classification);
+    m.push_back('Z'); m.push_back(' '); // issue subtype
+    m.push_back(authenticity);
+    m.resize(itch::directory::LENGTH, ' ');
+    return m;
+}
+
+inline std::vector<char> add(uint16_t locate, uint64_t ts, uint64_t ref, char side, uint32_t shares,
+                             uint32_t price_1e4, const std::string& symbol = "TEST") {
+    auto m = header('A', locate, ts);
+    put_be(m, ref, 8);
+    m.push_back(side);
+    put_be(m, shares, 4);
+    std::string padded = symbol;
+    padded.resize(8, ' ');
+    m.insert(m.end(), padded.begin(), padded.end());
+    put_be(m, price_1e4, 4);
+    return m;
+}
+
+inline std::vector<char> del(uint16_t locate, uint64_t ts, uint64_t ref) {
+    auto m = header('D', locate, ts);
+    put_be(m, ref, 8);
+    return m;
+}
+
+inline std::vector<char> cancel(uint16_t locate, uint64_t ts, uint64_t ref, uint32_t shares) {
+    auto m = header('X', locate, ts);
+    put_be(m, ref, 8);
+    put_be(m, shares, 4);
+    return m;
+}
+
+inline std::vector<char> execute(uint16_t locate, uint64_t ts, uint64_t ref, uint32_t shares, uint64_t match = 1) {
+    auto m = header('E', locate, ts);
+    put_be(m, ref, 8);
+    put_be(m, shares, 4);
+    put_be(m, match, 8);
+    return m;
+}
+
+inline std::vector<char> replace(uint16_t locate, uint64_t ts, uint64_t old_ref, uint64_t new_ref,
+                                 uint32_t shares, uint32_t price_1e4) {
+    auto m = header('U', locate, ts);
+    put_be(m, old_ref, 8);
+    put_be(m, new_ref, 8);
+    put_be(m, shares, 4);
+    put_be(m, price_1e4, 4);
+    return m;
+}
+
+// Appends `msg` with its 2-byte length prefix
+inline void frame(std::vector<char>& stream, const std::vector<char>& msg) {
+    put_be(stream, msg.size(), 2);
+    stream.insert(stream.end(), msg.begin(), msg.end());
+}
+
+// Serves an in-memory byte stream in fixed-size blocks
+class VectorSource : public BlockSource {
+public:
+    VectorSource(std::vector<char> bytes, size_t block_size)
+        : bytes_(std::move(bytes)), block_size_(block_size) {}
+
+    std::span<const char> next_block() override {
+        size_t n = std::min(block_size_, bytes_.size() - pos_);
+        std::span<const char> block(bytes_.data() + pos_, n);
+        pos_ += n;
+        return block;
+    }
+
+private:
+    std::vector<char> bytes_;
+    size_t block_size_;
+    size_t pos_ = 0;
+};
+
+} // namespace itch_test
@@ -0,0 +1,506 @@
+#include "BookBuilder.h"
+#include "EngineScheduler.h"
+#include "LifecycleReport.h"
+#include "MatchingEngine.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::unique_ptr<MatchingEngine> make_engine() {
+    return std::make_unique<MatchingEngine>(std::make_unique<LimitOrderBook>(0.0, 1000.0));
+}
+
+// ---------- Flight recorder ----------
+
+TEST(FlightRecorder, KeepsMostRecentEntriesInOrder) {
+    FlightRecorder rec(5); // rounded up to 8
+    EXPECT_EQ(rec.capacity(), 8u);
+
+    for (int i = 0; i < 20; ++i)
+        rec.record(FlightRecord::Kind::Cancel, i, 0, 0.0, 0);
+
+    EXPECT_EQ(rec.size(), 8u);
+    EXPECT_EQ(rec.total_recorded(), 20u);
+    for (size_t i = 0; i < rec.size(); ++i)
+        EXPECT_EQ(rec.at(i).id, static_cast<int64_t>(12 + i));
+    for (size_t i = 1; i < rec.size(); ++i)
+        EXPECT_GE(rec.at(i).tsc, rec.at(i - 1).tsc);
+}
+
+TEST(FlightRecorder, EngineRecordsInputsAndTrades) {
+    auto engine = make_engine();
+    engine->enable_flight_recorder(64);
+
+    engine->submitLimit(1, OrderSide::Sell, 100.00, 50);
+    engine->submitLimit(2, OrderSide::Buy, 100.00, 20);
+    engine->reduce_order(1, 5);
+    engine->execute(1, 5);
+    engine->order_replace(1, 3, 100.50, 10);
+    engine->cancel(3);
+
+    const FlightRecorder* rec = engine->flight_recorder();
+    ASSERT_NE(rec, nullptr);
+
+    std::vector<FlightRecord::Kind> kinds;
+    for (size_t i = 0; i < rec->size(); ++i)
+        kinds.push_back(rec->at(i).kind);
+
+    using K = FlightRecord::Kind;
+    std::vector<K> expected = {K::Add, K::Add, K::Trade, K::Reduce, K::Execute, K::Replace, K::Cancel};
+    EXPECT_EQ(kinds, expected);
+
+    const FlightRecord& trade = rec->at(2);
+    EXPECT_EQ(trade.id, 1);        // maker
+    EXPECT_EQ(trade.other_id, 2);  // taker
+    EXPECT_EQ(trade.quantity, 20);
+
+    std::ostringstream out;
+    rec->dump(out, "TEST");
+    EXPECT_NE(out.str().find("flight recorder: TEST"), std::string::npos);
+    EXPECT_NE(out.str().find("REPLACE"), std::string::npos);
+}
+
+// ---------- Conflated output ----------
+
+TEST(MatchingEngineConflation, OneSweepAndOneBboEventPerCommand) {
+    auto engine = make_engine();
+
+    size_t trades = 0;
+    std::vector<SweepEvent> sweeps;
+    std::vector<std::vector<SweepLevel>> breakdowns;
+    std::vector<BboEvent> bbos;
+    engine->setTradeCallback([&](const TradeEvent&) { ++trades; });
+    engine->setSweepCallback([&](const SweepEvent& ev) {
+        sweeps.push_back(ev);
+        breakdowns.emplace_back(ev.by_level.begin(), ev.by_level.end());
+    }, true);
+    engine->setBboCallback([&](const BboEvent& ev) { bbos.push_back(ev); });
+
+    engine->submitLimit(1, OrderSide::Sell, 100.00, 100);
+    engine->submitLimit(2, OrderSide::Sell, 100.00, 100);
+    engine->submitLimit(3, OrderSide::Sell, 100.00, 100);
+    engine->submitLimit(4, OrderSide::Sell, 100.01, 100);   // behind the touch: no BBO event
+    engine->submitLimit(5, OrderSide::Sell, 100.01, 100);
+    engine->submitLimit(6, OrderSide::Sell, 100.02, 100);
+    ASSERT_EQ(bbos.size(), 3u);
+    EXPECT_EQ(bbos.back().ask.quantity, 300);
+    EXPECT_FALSE(bbos.back().bid.valid);
+
+    engine->submitLimit(10, OrderSide::Buy, 100.02, 450);
+    EXPECT_EQ(trades, 5u);
+    ASSERT_EQ(sweeps.size(), 1u);
+    const SweepEvent& sweep = sweeps[0];
+    EXPECT_EQ(sweep.taker_id, 10);
+    EXPECT_EQ(sweep.taker_side, OrderSide::Buy);
+    EXPECT_EQ(sweep.quantity, 450);
+    EXPECT_EQ(sweep.fills, 5u);
+    EXPECT_EQ(sweep.levels, 2u);
+    EXPECT_DOUBLE_EQ(sweep.first_price, 100.00);
+    EXPECT_DOUBLE_EQ(sweep.last_price, 100.01);
+    EXPECT_NEAR(sweep.vwap, (300 * 100.00 + 150 * 100.01) / 450, 1e-9);
+
+    ASSERT_EQ(breakdowns[0].size(), 2u);
+    EXPECT_EQ(breakdowns[0][0].quantity, 300);
+    EXPECT_EQ(breakdowns[0][0].fills, 3u);
+    EXPECT_EQ(breakdowns[0][1].quantity, 150);
+    EXPECT_EQ(breakdowns[0][1].fills, 2u);
+
+    ASSERT_EQ(bbos.size(), 4u);
+    EXPECT_NEAR(bbos.back().ask.price, 100.01, 1e-9);
+    EXPECT_EQ(bbos.back().ask.quantity, 50);
+
+    engine->cancel(6);                                      // no fills, top unchanged
+    engine->submitLimit(11, OrderSide::Buy, 99.00, 10);     // new bid
+    EXPECT_EQ(sweeps.size(), 1u);
+    ASSERT_EQ(bbos.size(), 5u);
+    EXPECT_TRUE(bbos.back().bid.valid);
+
+    // each sweep starts fresh
+    engine->submitLimit(12, OrderSide::Sell, 99.00, 4);
+    ASSERT_EQ(sweeps.size(), 2u);
+    EXPECT_EQ(sweeps[1].quantity, 4);
+    EXPECT_EQ(sweeps[1].levels, 1u);
+    EXPECT_EQ(breakdowns[1].size(), 1u);
+}
+
+// ---------- Invariant checks ----------
+
+TEST(MatchingEngineInvariants, HealthyBookNeverReports) {
+    auto engine = make_engine();
+    int failures = 0;
+    engine->setInvariantCallback([&](MatchingEngine&, const char*) { ++failures; });
+
+    engine->submitLimit(1, OrderSide::Buy, 99.00, 10);
+    engine->submitLimit(2, OrderSide::Sell, 101.00, 10);
+    engine->submitLimit(3, OrderSide::Buy, 101.00, 15); // crosses, rests 5 at 101
+    engine->cancel(1);
+
+    EXPECT_EQ(failures, 0);
+    EXPECT_TRUE(engine->get_book()->check_invariants());
+}
+
+TEST(MatchingEngineInvariants, OverExecutionIsReported) {
+    auto engine = make_engine();
+    engine->enable_flight_recorder(16);
+
+    std::string seen;
+    engine->setInvariantCallback([&](MatchingEngine&, const char* what) { seen = what; });
+
+    engine->submitLimit(1, OrderSide::Buy, 99.00, 10);
+    // corrupt the resting order behind the book's back
+    engine->get_book()->orders_by_id[1]->quantity = 30;
+    engine->reduce_order(1, 20);
+
+    EXPECT_EQ(seen, "non-positive quantity at best bid");
+    EXPECT_EQ(engine->flight_recorder()->at(engine->flight_recorder()->size() - 1).kind,
+              FlightRecord::Kind::InvariantFailure);
+
+    std::string error;
+    EXPECT_FALSE(engine->get_book()->check_invariants(&error));
+    EXPECT_FALSE(error.empty());
+}
+
+// ---------- Order lifecycle stats ----------
+
+static EngineCommand command(CommandType type, uint64_t ts, int64_t id, int32_t qty,
+                             uint32_t price = 0, uint8_t side = 0, int64_t new_id = 0) {
+    EngineCommand cmd{};
+    cmd.type = type;
+    cmd.timestamp = ts;
+    cmd.order_id = id;
+    cmd.quantity = qty;
+    cmd.price = price;
+    cmd.side = side;
+    cmd.new_order_id = new_id;
+    return cmd;
+}
+
+TEST(Log2Histogram, BucketsByPowerOfTwo) {
+    Log2Histogram h;
+    EXPECT_EQ(h.quantile(0.5), 0u);
+    h.add(0);
+    h.add(1);
+    h.add(5);       // [4, 8)
+    h.add(6);
+    h.add(1000);    // [512, 1024)
+    EXPECT_EQ(h.total, 5u);
+    EXPECT_EQ(h.counts[0], 1u);
+    EXPECT_EQ(h.counts[1], 1u);
+    EXPECT_EQ(h.counts[3], 2u);
+    EXPECT_EQ(h.counts[10], 1u);
+    EXPECT_EQ(h.quantile(0.2), 0u);
+    EXPECT_EQ(h.quantile(0.8), 7u);
+    EXPECT_EQ(h.quantile(1.0), 1000u);  // capped at the largest sample
+}
+
+TEST(OrderLifecycle, TracksExitsInExchangeTime) {
+    auto engine = make_engine();
+    engine->enable_lifecycle_stats();
+
+    const uint32_t p100 = 1'000'000;
+    const std::vector<EngineCommand> day = {
+        command(CommandType::Add, 1'000, 1, 100, p100, 1),          // ask 100 @ 100.00
+        command(CommandType::Add, 2'000, 2, 50, p100 - 100, 0),     // bid 50 @ 99.99
+        command(CommandType::Add, 3'000, 3, 80, p100 - 200, 0),     // bid 80 @ 99.98
+        command(CommandType::Execute, 11'000, 1, 40),               // first fill of 1 after 10us
+        command(CommandType::Add, 17'000, 4, 60, p100, 0),          // buy 60 takes the rest of 1
+        command(CommandType::Reduce, 20'000, 2, 50),                // 2 reduced to zero, unfilled
+        command(CommandType::Execute, 21'000, 3, 30),
+        command(CommandType::Replace, 35'000, 3, 50, p100 - 300, 0, 5),
+        command(CommandType::Add, 36'000, 6, 10, p100 - 300, 1),    // sells into 5 on arrival
+    };
+    engine->apply_batch(day.data(), day.size());
+
+    const OrderLifecycleStats* l = engine->lifecycle_stats();
+    ASSERT_NE(l, nullptr);
+    EXPECT_EQ(l->fully_filled, 1u);             // order 1 at 17us
+    EXPECT_EQ(l->filled_lifetime_ns.total, 1u);
+    EXPECT_EQ(l->filled_lifetime_ns.max, 16'000u);
+    EXPECT_EQ(l->filled_on_arrival, 2u);        // orders 4 and 6
+    EXPECT_EQ(l->cancelled_unfilled, 1u);       // order 2
+    EXPECT_EQ(l->cancelled_partial, 1u);        // order 3, by replace
+    EXPECT_EQ(l->replaced, 1u);
+    EXPECT_EQ(l->cancelled_lifetime_ns.total, 2u);
+    EXPECT_EQ(l->cancelled_lifetime_ns.max, 32'000u);
+
+    // 1 after 10us, 3 after 18us, 5 after 1us
+    EXPECT_EQ(l->time_to_first_fill_ns.total, 3u);
+    EXPECT_EQ(l->time_to_first_fill_ns.max, 18'000u);
+
+    EXPECT_EQ(l->fill_ratio_deciles[10], 1u);
+    EXPECT_EQ(l->fill_ratio_deciles[0], 1u);
+    EXPECT_EQ(l->fill_ratio_deciles[3], 1u);    // 30 of 80
+
+    LifecycleReport report;
+    report.track("TEST", engine.get());
+    std::ostringstream json;
+    report.write_json(json);
+    EXPECT_NE(json.str().find("\"symbol\": \"TEST\""), std::string::npos);
+    EXPECT_NE(json.str().find("\"time_to_first_fill_ns\": {\"count\": 3"), std::string::npos);
+}
+
+TEST(OrderLifecycle, DisabledByDefault) {
+    auto engine = make_engine();
+    engine->submitLimit(1, OrderSide::Buy, 100.00, 10);
+    engine->cancel(1);
+    EXPECT_EQ(engine->lifecycle_stats(), nullptr);
+}
+
+// ---------- Engine scheduler ----------
+
+// Random adds, cancels, executes and replaces over `symbols` locates, with
+// locate 0 taking about 60% of the traffic
+static std::vector<EngineCommand> skewed_commands(size_t symbols, size_t count) {
+    std::mt19937_64 rng(42);
+    std::vector<std::vector<int64_t>> live(symbols);
+    std::vector<EngineCommand> out;
+    int64_t next_id = 1;
+    for (size_t i = 0; i < count; ++i) {
+        const uint16_t locate = rng() % 10 < 6 ? 0 : static_cast<uint16_t>(1 + rng() % (symbols - 1));
+        auto& ids = live[locate];
+        EngineCommand cmd{};
+        cmd.locate = locate;
+        cmd.timestamp = i;
+        const unsigned pick = rng() % 10;
+        if (ids.empty() || pick < 5) {
+            cmd.type = CommandType::Add;
+            cmd.order_id = next_id++;
+            cmd.side = rng() % 2;
+            cmd.price = static_cast<uint32_t>(1'000'000 + (cmd.side ? 1 : -1) * static_cast<int>(rng() % 40) * 100);
+            cmd.quantity = static_cast<int32_t>(1 + rng() % 300);
+            ids.push_back(cmd.order_id);
+        } else {
+            const size_t k = rng() % ids.size();
+            cmd.order_id = ids[k];
+            if (pick < 7) {
+                cmd.type = CommandType::Cancel;
+                ids[k] = ids.back();
+                ids.pop_back();
+            } else if (pick < 9) {
+                cmd.type = pick == 7 ? CommandType::Execute : CommandType::Reduce;
+                cmd.quantity = static_cast<int32_t>(1 + rng() % 50);
+            } else {
+                cmd.type = CommandType::Replace;
+                cmd.new_order_id = next_id++;
+                cmd.price = static_cast<uint32_t>(1'000'000 + static_cast<int>(rng() % 80) * 100 - 4'000);
+                cmd.quantity = static_cast<int32_t>(1 + rng() % 300);
+                ids[k] = cmd.new_order_id;
+            }
+        }
+        out.push_back(cmd);
+    }
+    return out;
+}
+
+TEST(EngineScheduler, SkewedLoadMatchesSerialReplay) {
+    const size_t symbols = 12;
+    const auto commands = skewed_commands(symbols, 200'000);
+
+    std::vector<std::unique_ptr<MatchingEngine>> serial, parallel;
+    std::vector<uint64_t> serial_trades(symbols), parallel_trades(symbols);
+    for (size_t s = 0; s < symbols; ++s) {
+        serial.push_back(make_engine());
+        parallel.push_back(make_engine());
+        serial[s]->setTradeCallback([&serial_trades, s](const TradeEvent&) { ++serial_trades[s]; });
+        parallel[s]->setTradeCallback([&parallel_trades, s](const TradeEvent&) { ++parallel_trades[s]; });
+    }
+    for (const auto& cmd : commands)
+        serial[cmd.locate]->apply(cmd);
+
+    // small rings and frequent rebalancing keep symbols moving between workers
+    EngineScheduler scheduler(3, 64, 512);
+    for (size_t s = 0; s < symbols; ++s)
+        scheduler.add(static_cast<uint16_t>(s), parallel[s].get());
+    for (const auto& cmd : commands)
+        scheduler.submit(cmd);
+    scheduler.finish();
+
+    uint64_t applied = 0;
+    for (const auto& load : scheduler.loads()) {
+        applied += load.commands;
+        EXPECT_LT(load.worker, 3u);
+    }
+    EXPECT_EQ(applied, commands.size());
+    // the point of the small rings: symbols must actually have moved
+    EXPECT_GT(scheduler.migrations() + scheduler.steals(), 0u);
+
+    for (size_t s = 0; s < symbols; ++s) {
+        SCOPED_TRACE("symbol " + std::to_string(s));
+        const BookStats a = serial[s]->stats(), b = parallel[s]->stats();
+        EXPECT_EQ(a.adds, b.adds);
+        EXPECT_EQ(a.cancels, b.cancels);
+        EXPECT_EQ(a.fills, b.fills);
+        EXPECT_EQ(serial_trades[s], parallel_trades[s]);
+        const auto bid_a = serial[s]->get_book()->get_best_bid(), bid_b = parallel[s]->get_book()->get_best_bid();
+        const auto ask_a = serial[s]->get_book()->get_best_ask(), ask_b = parallel[s]->get_book()->get_best_ask();
+        EXPECT_EQ(bid_a.price, bid_b.price);
+        EXPECT_EQ(bid_a.quantity, bid_b.quantity);
+        EXPECT_EQ(ask_a.price, ask_b.price);
+        EXPECT_EQ(ask_a.quantity, ask_b.quantity);
+        EXPECT_TRUE(parallel[s]->get_book()->check_invariants());
+    }
+}
+
+TEST(EngineScheduler, EngineExceptionsReachTheProducer) {
+    auto engine = make_engine();
+    engine->setTradeCallback([](const TradeEvent&) { throw std::runtime_error("downstream failed"); });
+
+    EngineScheduler scheduler(2, 16);
+    scheduler.add(7, engine.get());
+    EXPECT_TRUE(scheduler.has(7));
+    EXPECT_FALSE(scheduler.has(8));
+
+    EngineCommand ask{};
+    ask.locate = 7;
+    ask.type = CommandType::Add;
+    ask.order_id = 1;
+    ask.side = 1;
+    ask.price = 1'000'000;
+    ask.quantity = 10;
+    EngineCommand bid = ask;
+    bid.order_id = 2;
+    bid.side = 0;
+
+    EXPECT_THROW({
+        scheduler.submit(ask);
+        scheduler.submit(bid);
+        for (int i = 0; i < 1000; ++i) {
+            EngineCommand cancel{};
+            cancel.locate = 7;
+            cancel.type = CommandType::Cancel;
+            cancel.order_id = 100 + i;
+            scheduler.submit(cancel);
+        }
+        scheduler.finish();
+    }, std::runtime_error);
+}
+
+// ---------- Published depth ----------
+
+TEST(PublishedDepth, FollowsCommandsAndSkipsUnchangedTops) {
+    auto engine = make_engine();
+    LimitOrderBook::DepthView view;
+    EXPECT_FALSE(engine->get_book()->read_depth(view));
+    EXPECT_THROW(engine->enable_published_depth(LimitOrderBook::DepthView::MAX_DEPTH + 1), std::invalid_argument);
+
+    engine->enable_published_depth(2);
+    engine->submitLimit(1, OrderSide::Buy, 10.00, 100);
+    engine->submitLimit(2, OrderSide::Buy, 9.99, 50);
+    engine->submitLimit(3, OrderSide::Sell, 10.02, 70);
+    const LimitOrderBook& book = *engine->get_book();
+    EXPECT_EQ(book.depth_version(), 3u);
+
+    // a third bid level is out of view
+    engine->submitLimit(4, OrderSide::Buy, 9.90, 10);
+    EXPECT_EQ(book.depth_version(), 3u);
+
+    engine->submitLimit(5, OrderSide::Sell, 9.99, 120); // takes 10.00 and part of 9.99
+    EXPECT_EQ(book.depth_version(), 4u);
+    ASSERT_TRUE(book.read_depth(view));
+    ASSERT_EQ(view.bid_levels, 2u);
+    EXPECT_DOUBLE_EQ(view.bids[0].price, 9.99);
+    EXPECT_EQ(view.bids[0].quantity, 30);
+    EXPECT_DOUBLE_EQ(view.bids[1].price, 9.90);
+    ASSERT_EQ(view.ask_levels, 1u);
+    EXPECT_DOUBLE_EQ(view.asks[0].price, 10.02);
+    EXPECT_EQ(view.asks[0].quantity, 70);
+}
+
+TEST(PublishedDepth, ConcurrentReaderNeverSeesATornView) {
+    std::vector<EngineCommand> commands;
+    for (const auto& cmd : skewed_commands(2, 100'000))
+        if (cmd.locate == 0) commands.push_back(cmd);
+    ASSERT_FALSE(commands.empty());
+
+    auto engine = make_engine();
+    engine->enable_published_depth(5);
+    const LimitOrderBook& book = *engine->get_book();
+
+    // every published view comes from a whole number of commands, so it is
+    // never crossed, its levels are ordered and its clock never runs back
+    std::atomic<bool> started{false}, done{false};
+    uint64_t reads = 0, failures = 0;
+    std::thread reader([&] {
+        uint64_t last_time = 0;
+        LimitOrderBook::DepthView view;
+        while (!done.load(std::memory_order_acquire)) {
+            if (!book.read_depth(view)) continue;
+            ++reads;
+            started.store(true, std::memory_order_release);
+            bool ok = view.time >= last_time && view.bid_levels <= 5 && view.ask_levels <= 5;
+            last_time = view.time;
+            for (uint32_t i = 0; i < view.bid_levels; ++i)
+                ok = ok && view.bids[i].valid && view.bids[i].quantity > 0 && (i == 0 || view.bids[i].price < view.bids[i - 1].price);
+            for (uint32_t i = 0; i < view.ask_levels; ++i)
+                ok = ok && view.asks[i].valid && view.asks[i].quantity > 0 && (i == 0 || view.asks[i].price > view.asks[i - 1].price);
+            if (view.bid_levels && view.ask_levels)
+                ok = ok && view.bids[0].price < view.asks[0].price;
+            failures += !ok;
+        }
+    });
+
+    // the first command publishes a view; hold the rest back until the
+    // reader has seen it so the replay always overlaps some reads
+    engine->apply(commands.front());
+    while (!started.load(std::memory_order_acquire))
+        std::this_thread::yield();
+    for (size_t i = 1; i < commands.size(); ++i)
+        engine->apply(commands[i]);
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    EXPECT_GT(reads, 0u);
+    EXPECT_EQ(failures, 0u);
+
+    LimitOrderBook::DepthView view;
+    ASSERT_TRUE(book.read_depth(view));
+    LimitOrderBook::BestLevel bids[5];
+    ASSERT_EQ(view.bid_levels, book.get_top_levels(OrderSide::Buy, 5, bids));
+    for (uint32_t i = 0; i < view.bid_levels; ++i) {
+        EXPECT_EQ(view.bids[i].price, bids[i].price);
+        EXPECT_EQ(view.bids[i].quantity, bids[i].quantity);
+    }
+    ASSERT_GT(view.ask_levels, 0u);
+    EXPECT_EQ(view.asks[0].price, book.get_best_ask().price);
+}
+
+// ---------- Book builder ----------
+
+TEST(BookBuilder, HandsOverPreparedBooksUpToTheLimit) {
+    BookBuilderConfig config;
+    config.min_price = 0.0;
+    config.max_price = 1000.0;
+    config.ahead = 2;
+    config.limit = 3;
+    config.prefault_orders = 16;
+    BookBuilder builder(config, [](LimitOrderBook& book) { book.enable_lifecycle_stats(); });
+
+    std::vector<std::unique_ptr<LimitOrderBook>> books;
+    for (int i = 0; i < 4; ++i) books.push_back(builder.take());
+    EXPECT_EQ(builder.taken(), 4u);
+    EXPECT_EQ(builder.built_inline(), 1u); // past the limit nothing was built ahead
+
+    for (auto& book : books) {
+        ASSERT_NE(book->lifecycle_stats(), nullptr);
+        MatchingEngine engine(std::move(book));
+        engine.submitLimit(1, OrderSide::Sell, 10.0, 100);
+        engine.submitLimit(2, OrderSide::Buy, 10.0, 40);
+        EXPECT_EQ(engine.get_book()->get_best_ask().quantity, 60);
+    }
+}
+
+TEST(BookBuilder, ZeroLookaheadBuildsInline) {
+    BookBuilderConfig config;
+    config.max_price = 1000.0;
+    config.ahead = 0;
+    BookBuilder builder(config);
+    auto book = builder.take();
+    ASSERT_NE(book, nullptr);
+    EXPECT_EQ(builder.built_inline(), 1u);
+    EXPECT_EQ(builder.wait_ns(), 0u);
+}
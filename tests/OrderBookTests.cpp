@@ -1,4 +1,5 @@
 #include "LimitOrderBook.h"
+#include "LevelScan.h"
 #include <gtest/gtest.h>
 #include <chrono>
 #include <random>
@@ -173,6 +174,278 @@ TEST(LimitOrderBookPrice, FractionalPriceIsRoundedToNearestTick) {
     EXPECT_TRUE(levels[idx_trunc].orders.empty());
 }
 
+// ---------- Per-book counters ----------
+
+TEST(LimitOrderBookStats, CountsOperationsPerBook) {
+    LimitOrderBook lob(TEST_MIN_PRICE, TEST_MAX_PRICE);
+    LimitOrderBook other(TEST_MIN_PRICE, TEST_MAX_PRICE);
+
+    lob.process_order(1, 101.00, 50, OrderSide::Sell);
+    lob.process_order(2, 102.00, 50, OrderSide::Sell);
+    lob.process_order(3, 102.00, 10, OrderSide::Sell);
+    lob.process_order(4, 100.00, 10, OrderSide::Buy);
+    lob.reduce_order(4, 5);
+    lob.execute_order(4, 2);
+    EXPECT_TRUE(lob.replace_order(4, 5, 99.00, 20));
+    EXPECT_FALSE(lob.replace_order(42, 43, 99.00, 20));
+    lob.cancel_order(5);
+
+    // sweeps 101.00 and part of 102.00
+    lob.process_order(6, 102.00, 70, OrderSide::Buy);
+
+    BookStats s = lob.get_stats();
+    EXPECT_EQ(s.adds, 5u);
+    EXPECT_EQ(s.cancels, 1u);
+    EXPECT_EQ(s.reduces, 1u);
+    EXPECT_EQ(s.replaces, 1u);
+    EXPECT_EQ(s.fills, 3u);              // one execution + two resting orders hit
+    EXPECT_EQ(s.filled_quantity, 72u);
+    EXPECT_EQ(s.matches, 1u);
+    EXPECT_EQ(s.levels_crossed, 2u);
+    EXPECT_EQ(s.max_levels_crossed, 2u);
+    EXPECT_EQ(s.max_queue_depth, 2u);
+    EXPECT_EQ(lob.get_total_trades(), 3u);
+
+    // two orders left resting at 102.00 (30 + 10)
+    EXPECT_EQ(s.pool_in_use, 2u);
+    EXPECT_EQ(s.pool_high_water, 4u);
+    EXPECT_EQ(s.id_index_size, 2u);
+    EXPECT_EQ(s.active_ask_levels, 1u);
+    EXPECT_GT(s.ladder_bytes, 0u);
+    EXPECT_GT(s.pool_bytes, 0u);
+
+    // counters are per book, not shared
+    EXPECT_EQ(other.get_total_trades(), 0u);
+    EXPECT_EQ(other.get_stats().adds, 0u);
+}
+
+// ---------- Queue position ----------
+
+// Reference answer: walk the level FIFO up to the order
+static int64_t queue_ahead_by_walk(const LimitOrderBook& lob, int64_t id) {
+    const Order* target = lob.orders_by_id.at(id);
+    int64_t ahead = 0;
+    for (const Order* o : lob.get_price_levels()[price_to_index(target->price)].orders) {
+        if (o == target) break;
+        ahead += o->quantity;
+    }
+    return ahead;
+}
+
+TEST(LimitOrderBookQueue, TracksFillsCancelsAndReduces) {
+    LimitOrderBook lob(TEST_MIN_PRICE, TEST_MAX_PRICE);
+    lob.process_order(1, 100.00, 100, OrderSide::Sell);
+    lob.process_order(2, 100.00, 50, OrderSide::Sell);
+    lob.process_order(3, 100.00, 70, OrderSide::Sell);
+    lob.process_order(4, 100.00, 30, OrderSide::Sell);
+
+    EXPECT_EQ(lob.queue_ahead(1), 0);
+    EXPECT_EQ(lob.queue_ahead(4), 220);
+    EXPECT_FALSE(lob.queue_ahead(99).has_value());
+
+    lob.process_order(5, 100.00, 40, OrderSide::Buy);   // partial fill from the front
+    EXPECT_EQ(lob.queue_ahead(3), 110);
+
+    lob.cancel_order(2);                                // cancel in the middle
+    EXPECT_EQ(lob.queue_ahead(3), 60);
+    EXPECT_EQ(lob.queue_ahead(4), 130);
+
+    lob.reduce_order(3, 20);
+    lob.execute_order(1, 10);
+    EXPECT_EQ(lob.queue_ahead(3), 50);
+    EXPECT_EQ(lob.queue_ahead(4), 100);
+
+    // emptying the level restarts its queue
+    lob.process_order(6, 100.00, 130, OrderSide::Buy);
+    lob.process_order(7, 100.00, 10, OrderSide::Sell);
+    lob.process_order(8, 100.00, 10, OrderSide::Sell);
+    EXPECT_EQ(lob.queue_ahead(8), 10);
+}
+
+TEST(LimitOrderBookQueue, MatchesLinearWalkUnderRandomOperations) {
+    LimitOrderBook lob(TEST_MIN_PRICE, TEST_MAX_PRICE);
+    std::mt19937 rng(7);
+
+    // a narrow price band keeps queues long and crossing frequent, and pushes
+    // levels through several slot renumberings
+    std::uniform_int_distribution<int> tick_dist(0, 4);
+    std::uniform_int_distribution<int32_t> qty_dist(1, 100);
+    std::uniform_int_distribution<int> op_dist(0, 9);
+
+    std::vector<int64_t> ids;
+    int64_t next_id = 1;
+
+    for (int i = 0; i < 20000; ++i) {
+        int op = op_dist(rng);
+        if (op <= 5 || ids.empty()) {
+            OrderSide side = rng() % 2 ? OrderSide::Buy : OrderSide::Sell;
+            // buys rest just below sells, with the odd aggressive order
+            int offset = side == OrderSide::Buy ? -tick_dist(rng) : tick_dist(rng);
+            if (rng() % 20 == 0) offset = -offset;
+            lob.process_order(next_id, 100.00 + offset * TICK, qty_dist(rng), side);
+            ids.push_back(next_id++);
+        } else {
+            std::size_t idx = rng() % ids.size();
+            auto it = lob.orders_by_id.find(ids[idx]);
+            if (it == lob.orders_by_id.end()) {
+                ids[idx] = ids.back();
+                ids.pop_back();
+            } else if (op <= 7) {
+                lob.cancel_order(ids[idx]);
+            } else {
+                int32_t shares = 1 + static_cast<int32_t>(rng() % it->second->quantity);
+                if (op == 8) lob.reduce_order(ids[idx], shares);
+                else lob.execute_order(ids[idx], shares);
+            }
+        }
+
+        if (i % 97 == 0) {
+            for (const auto& [id, order] : lob.orders_by_id)
+                ASSERT_EQ(lob.queue_ahead(id), queue_ahead_by_walk(lob, id)) << "order " << id << " op " << i;
+        }
+    }
+
+    std::string error;
+    EXPECT_TRUE(lob.check_invariants(&error)) << error;
+}
+
+// ---------- Depth and market impact ----------
+
+TEST(LevelScan, KernelsMatchScalarLoops) {
+    std::mt19937 rng(3);
+    for (size_t n : {0u, 1u, 7u, 8u, 9u, 31u, 1000u}) {
+        std::vector<int32_t> q(n);
+        for (auto& v : q) v = rng() % 4 ? 0 : static_cast<int32_t>(rng() % 2'000'000'000);
+
+        int64_t total = 0;
+        std::vector<int64_t> prefix(n), out(n);
+        for (size_t i = 0; i < n; ++i) prefix[i] = total += q[i];
+        EXPECT_EQ(level_scan::sum(q.data(), n), total) << n;
+        level_scan::prefix_sums(q.data(), n, out.data());
+        EXPECT_EQ(out, prefix) << n;
+
+        for (int64_t target : {int64_t{1}, total / 3, total, total + 1}) {
+            size_t expect = 0;
+            while (expect < n && prefix[expect] < target) ++expect;
+            int64_t weighted = 0;
+            for (size_t i = 0; i < expect; ++i) weighted += int64_t{q[i]} * int64_t(i);
+
+            int64_t got_before = -1, got_weighted = -1;
+            EXPECT_EQ(level_scan::find_cumulative(q.data(), n, target, got_before, got_weighted), expect) << n;
+            EXPECT_EQ(got_before, expect ? prefix[expect - 1] : 0) << n;
+            EXPECT_EQ(got_weighted, weighted) << n;
+        }
+    }
+}
+
+TEST(LimitOrderBookDepth, ImpactAndDepthOnSmallBook) {
+    LimitOrderBook lob(TEST_MIN_PRICE, TEST_MAX_PRICE);
+    lob.process_order(1, 100.00, 100, OrderSide::Sell);
+    lob.process_order(2, 100.02, 200, OrderSide::Sell);
+    lob.process_order(3, 100.05, 300, OrderSide::Sell);
+    lob.process_order(4, 99.99, 50, OrderSide::Buy);
+    lob.process_order(5, 99.90, 70, OrderSide::Buy);
+
+    auto buy = lob.market_impact(OrderSide::Buy, 250);
+    EXPECT_TRUE(buy.complete);
+    EXPECT_EQ(buy.filled, 250);
+    EXPECT_EQ(buy.levels, 2u);
+    EXPECT_NEAR(buy.notional, 100 * 100.00 + 150 * 100.02, 1e-6);
+    EXPECT_NEAR(buy.worst_price, 100.02, 1e-9);
+
+    auto sweep = lob.market_impact(OrderSide::Sell, 1000);
+    EXPECT_FALSE(sweep.complete);
+    EXPECT_EQ(sweep.filled, 120);
+    EXPECT_EQ(sweep.levels, 2u);
+    EXPECT_NEAR(sweep.average_price, (50 * 99.99 + 70 * 99.90) / 120, 1e-9);
+    EXPECT_NEAR(sweep.worst_price, 99.90, 1e-9);
+
+    // 5 bps of 100.00 is 5 ticks
+    EXPECT_EQ(lob.depth_within_bps(OrderSide::Sell, 5.0), 600);
+    EXPECT_EQ(lob.depth_within_bps(OrderSide::Sell, 2.0), 300);
+    EXPECT_EQ(lob.depth_within_bps(OrderSide::Buy, 5.0), 50);
+    EXPECT_EQ(lob.depth_within_bps(OrderSide::Sell, -1.0), 0);
+    EXPECT_EQ(lob.depth_within_bps(OrderSide::Sell, 1e30), lob.depth_within_bps(OrderSide::Sell, 10000.0));
+
+    int64_t curve[8];
+    ASSERT_EQ(lob.depth_curve(OrderSide::Sell, 8, curve), 6u);
+    EXPECT_EQ(curve[0], 100);
+    EXPECT_EQ(curve[1], 100);
+    EXPECT_EQ(curve[2], 300);
+    EXPECT_EQ(curve[5], 600);
+
+    lob.cancel_order(1);
+    EXPECT_NEAR(lob.market_impact(OrderSide::Buy, 10).worst_price, 100.02, 1e-9);
+    EXPECT_EQ(lob.depth_curve(OrderSide::Buy, 0, curve), 0u);
+}
+
+TEST(LimitOrderBookDepth, MatchesLadderWalkUnderRandomOperations) {
+    LimitOrderBook lob(TEST_MIN_PRICE, TEST_MAX_PRICE);
+    std::mt19937 rng(11);
+    std::vector<int64_t> ids;
+    int64_t next_id = 1;
+
+    // resting quantity of `side` at ladder index `idx`
+    auto at = [&](OrderSide side, size_t idx) -> int64_t {
+        const auto& level = lob.get_price_levels()[idx];
+        return !level.orders.empty() && level.orders.front()->side == side ? level.total_quantity : 0;
+    };
+
+    for (int i = 0; i < 5000; ++i) {
+        if (rng() % 3 || ids.empty()) {
+            OrderSide side = rng() % 2 ? OrderSide::Buy : OrderSide::Sell;
+            int offset = static_cast<int>(rng() % 60) + (rng() % 15 == 0 ? -5 : 1);
+            double price = 200.00 + (side == OrderSide::Buy ? -offset : offset) * TICK;
+            lob.process_order(next_id, price, 1 + static_cast<int32_t>(rng() % 500), side);
+            ids.push_back(next_id++);
+        } else {
+            size_t pick = rng() % ids.size();
+            if (rng() % 2) lob.cancel_order(ids[pick]);
+            else lob.execute_order(ids[pick], 1 + static_cast<int32_t>(rng() % 100));
+        }
+
+        if (i % 50 != 0) continue;
+        for (OrderSide taker : {OrderSide::Buy, OrderSide::Sell}) {
+            const OrderSide resting = taker == OrderSide::Buy ? OrderSide::Sell : OrderSide::Buy;
+            const auto best = resting == OrderSide::Sell ? lob.get_best_ask() : lob.get_best_bid();
+            if (!best.valid) continue;
+
+            const int64_t want = 1 + static_cast<int64_t>(rng() % 5000);
+            const int step = resting == OrderSide::Sell ? 1 : -1;
+            int64_t left = want, filled = 0;
+            double notional = 0.0;
+            size_t levels = 0;
+            for (long idx = static_cast<long>(price_to_index(best.price)); idx >= 0 && idx < static_cast<long>(lob.get_price_levels().size()) && left > 0; idx += step) {
+                const int64_t q = std::min(left, at(resting, idx));
+                if (q == 0) continue;
+                filled += q;
+                left -= q;
+                notional += q * (TEST_MIN_PRICE + idx * TICK);
+                ++levels;
+            }
+
+            auto impact = lob.market_impact(taker, want);
+            ASSERT_EQ(impact.filled, filled) << "op " << i;
+            ASSERT_EQ(impact.complete, left == 0) << "op " << i;
+            ASSERT_EQ(impact.levels, levels) << "op " << i;
+            ASSERT_NEAR(impact.notional, notional, 1e-6 * notional) << "op " << i;
+
+            const int64_t within_10_ticks = [&] {
+                int64_t sum = 0;
+                for (int k = 0; k <= 10; ++k) {
+                    long idx = static_cast<long>(price_to_index(best.price)) + k * step;
+                    if (idx >= 0) sum += at(resting, idx);
+                }
+                return sum;
+            }();
+            // a band of exactly ten ticks
+            ASSERT_EQ(lob.depth_within_bps(resting, 10.0 * TICK / best.price * 10000.0), within_10_ticks) << "op " << i;
+        }
+    }
+    std::string error;
+    EXPECT_TRUE(lob.check_invariants(&error)) << error;
+}
+
 // ---------- Invariants under randomised operations ----------
 
 TEST(LimitOrderBookStress, RandomisedAddCancelReduceKeepsTotalsConsistent) {
@@ -257,4 +530,7 @@ TEST(LimitOrderBookStress, RandomisedAddCancelReduceKeepsTotalsConsistent) {
         }
         EXPECT_EQ(sum, level.total_quantity) << " at price index " << idx;
     }
+
+    std::string error;
+    EXPECT_TRUE(lob.check_invariants(&error)) << error;
 }
@@ -0,0 +1,110 @@
+#include "SharedBook.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+static std::string segment_name(const char* tag) {
+    return std::string("/orderbook_test_") + tag + "_" + std::to_string(::getpid());
+}
+
+TEST(SharedBook, ReaderSeesPublishedTopOfBook) {
+    const std::string name = segment_name("basic");
+    SharedBookPublisher publisher(name, 3);
+    publisher.add_symbol(42, "NVDA");
+
+    SharedBookReader reader(name);
+    EXPECT_EQ(reader.depth(), 3u);
+    EXPECT_EQ(reader.find("NVDA"), std::optional<uint16_t>(42));
+    EXPECT_FALSE(reader.find("AAPL").has_value());
+    EXPECT_FALSE(reader.has_symbol(7));
+
+    LimitOrderBook book(0.0, 1000.0, 1000);
+    book.process_order(1, 120.00, 100, OrderSide::Buy);
+    book.process_order(2, 119.99, 50, OrderSide::Buy);
+    book.process_order(3, 120.03, 70, OrderSide::Sell);
+    EXPECT_TRUE(publisher.publish(42, book, 5000));
+    // nothing changed, nothing stored
+    EXPECT_FALSE(publisher.publish(42, book, 6000));
+    EXPECT_EQ(reader.version(42), 2u);      // initial empty state + one publish
+
+    BookSnapshot snap;
+    ASSERT_TRUE(reader.read(42, snap));
+    EXPECT_EQ(snap.timestamp, 5000u);
+    EXPECT_EQ(snap.bid_levels, 2);
+    EXPECT_EQ(snap.bid_price[0], 12000);
+    EXPECT_EQ(snap.bid_qty[1], 50);
+    EXPECT_EQ(snap.ask_price[0], 12003);
+    EXPECT_EQ(reader.writer_pid(), static_cast<uint32_t>(::getpid()));
+
+    publisher.record_trade(42, 120.00, 10);
+    book.process_order(4, 120.00, 10, OrderSide::Sell);
+    EXPECT_TRUE(publisher.publish(42, book, 7000));
+    ASSERT_TRUE(reader.read(42, snap));
+    EXPECT_EQ(snap.bid_qty[0], 90);
+    EXPECT_EQ(snap.last_qty, 10);
+    EXPECT_EQ(snap.sequence, 2u);
+}
+
+TEST(SharedBook, ConcurrentReadsAreNeverTorn) {
+    const std::string name = segment_name("torn");
+    SharedBookPublisher publisher(name, 5);
+    publisher.add_symbol(1, "AAPL");
+    SharedBookReader reader(name);
+
+    // every published state has bid qty == timestamp at all five levels
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> checked{0};
+    std::thread poller([&] {
+        BookSnapshot snap;
+        while (!done.load()) {
+            if (!reader.read(1, snap) || snap.bid_levels == 0) continue;
+            for (int i = 0; i < snap.bid_levels; ++i)
+                ASSERT_EQ(static_cast<uint64_t>(snap.bid_qty[i]), snap.timestamp);
+            checked.fetch_add(1);
+        }
+    });
+
+    LimitOrderBook book(0.0, 1000.0, 100'000);
+    int64_t id = 1;
+    for (int32_t round = 1; round <= 2000; ++round) {
+        for (int lvl = 0; lvl < 5; ++lvl)
+            book.cancel_order(id - 5 + lvl);
+        for (int lvl = 0; lvl < 5; ++lvl)
+            book.process_order(id++, 100.00 - lvl * 0.01, round, OrderSide::Buy);
+        publisher.publish(1, book, static_cast<uint64_t>(round));
+    }
+    while (checked.load() == 0) std::this_thread::yield();
+    done = true;
+    poller.join();
+}
+
+TEST(SharedBook, VisibleFromAnotherProcess) {
+    const std::string name = segment_name("fork");
+    SharedBookPublisher publisher(name);
+    publisher.add_symbol(9, "MSFT");
+
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // child: poll until the parent's final state shows up
+        SharedBookReader reader(name);
+        BookSnapshot snap;
+        for (int i = 0; i < 5000; ++i) {
+            if (reader.read(9, snap) && snap.timestamp == 99 && snap.ask_qty[0] == 300) ::_exit(0);
+            ::usleep(1000);
+        }
+        ::_exit(1);
+    }
+
+    LimitOrderBook book(0.0, 1000.0, 1000);
+    book.process_order(1, 400.00, 300, OrderSide::Sell);
+    publisher.publish(9, book, 99);
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
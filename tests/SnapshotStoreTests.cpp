@@ -0,0 +1,241 @@
+#include "SnapshotReader.h"
+#include "SnapshotSampler.h"
+#include "SnapshotWriter.h"
+#include "TradeTapeReader.h"
+#include "TradeTapeWriter.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace snapshot_format;
+
+static std::string temp_path(const std::string& name) {
+    return testing::TempDir() + name;
+}
+
+// ---------- Writer / reader round trip ----------
+
+TEST(SnapshotStore, RoundTripAcrossChunks) {
+    const std::string path = temp_path("roundtrip.snap");
+    const uint32_t depth = 2;
+
+    {
+        SnapshotWriter writer(path, depth, 100'000'000, /*chunk_rows=*/3);
+        writer.add_symbol(7, "AAPL");
+        writer.add_symbol(9, "MSFT");
+
+        for (int r = 0; r < 7; ++r) {
+            SnapshotLevel bids[2] = {{10000 - r, 100 + r}, {9999 - r, 50}};
+            SnapshotLevel asks[2] = {{10001 + r, 200}, {0, 0}};
+            writer.append(7, 1'000 + r * 100, bids, asks);
+        }
+        SnapshotLevel bids[2] = {{500, 1}, {499, 2}};
+        SnapshotLevel asks[2] = {{501, 3}, {502, 4}};
+        writer.append(9, 1'000, bids, asks);
+    }
+
+    SnapshotReader reader(path);
+    EXPECT_EQ(reader.depth(), depth);
+    EXPECT_EQ(reader.interval_ns(), 100'000'000u);
+    EXPECT_EQ(reader.find_locate("AAPL"), 7);
+    EXPECT_EQ(reader.find_locate("MSFT"), 9);
+    EXPECT_EQ(reader.find_locate("TSLA"), -1);
+
+    // 7 rows at 3 rows per chunk -> 3 chunks for locate 7
+    auto aapl = reader.chunks_for(7);
+    ASSERT_EQ(aapl.size(), 3u);
+
+    std::vector<uint64_t> timestamps;
+    std::vector<int64_t> best_bid_px, best_bid_qty, second_ask_px;
+    for (size_t idx : aapl) {
+        SnapshotChunk chunk;
+        reader.read_chunk(idx, chunk);
+        EXPECT_EQ(chunk.locate, 7);
+        EXPECT_EQ(chunk.rows(), reader.chunks()[idx].rows);
+        EXPECT_EQ(chunk.timestamps.front(), reader.chunks()[idx].first_ts);
+        EXPECT_EQ(chunk.timestamps.back(), reader.chunks()[idx].last_ts);
+        for (size_t r = 0; r < chunk.rows(); ++r) {
+            timestamps.push_back(chunk.timestamps[r]);
+            best_bid_px.push_back(chunk.level(0, BidPrice)[r]);
+            best_bid_qty.push_back(chunk.level(0, BidQty)[r]);
+            second_ask_px.push_back(chunk.level(1, AskPrice)[r]);
+        }
+    }
+
+    ASSERT_EQ(timestamps.size(), 7u);
+    for (int r = 0; r < 7; ++r) {
+        EXPECT_EQ(timestamps[r], static_cast<uint64_t>(1'000 + r * 100));
+        EXPECT_EQ(best_bid_px[r], 10000 - r);
+        EXPECT_EQ(best_bid_qty[r], 100 + r);
+        EXPECT_EQ(second_ask_px[r], 0);
+    }
+
+    auto msft = reader.chunks_for(9);
+    ASSERT_EQ(msft.size(), 1u);
+    std::vector<int64_t> ask_qty;
+    reader.read_column(msft[0], level_column(1, AskQty), ask_qty);
+    ASSERT_EQ(ask_qty.size(), 1u);
+    EXPECT_EQ(ask_qty[0], 4);
+
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotStore, UnchangedLevelsEncodeCompactly) {
+    const std::string path = temp_path("compact.snap");
+    const uint32_t depth = 5;
+    const int rows = 1000;
+
+    {
+        SnapshotWriter writer(path, depth, 1, /*chunk_rows=*/rows);
+        std::vector<SnapshotLevel> bids(depth, {1'000'000, 500});
+        std::vector<SnapshotLevel> asks(depth, {1'000'100, 700});
+        for (int r = 0; r < rows; ++r)
+            writer.append(1, 34'200'000'000'000ULL + r, bids.data(), asks.data());
+    }
+
+    SnapshotReader reader(path);
+    ASSERT_EQ(reader.chunks().size(), 1u);
+    // one byte per column per row once the first row has been written
+    EXPECT_LT(reader.chunks()[0].raw_size, static_cast<uint32_t>(rows * column_count(depth) + 128));
+
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotStore, RejectsFooterCountsLargerThanTheFile) {
+    const std::string path = temp_path("corrupt.snap");
+    {
+        SnapshotWriter writer(path, 1, 1);
+        writer.add_symbol(7, "AAPL");
+        SnapshotLevel bid[1] = {{100, 1}}, ask[1] = {{101, 1}};
+        writer.append(7, 1, bid, ask);
+    }
+
+    Trailer trailer{};
+    {
+        std::ifstream in(path, std::ios::binary);
+        in.seekg(-static_cast<std::streamoff>(sizeof(trailer)), std::ios::end);
+        in.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    }
+    {
+        std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(static_cast<std::streamoff>(trailer.footer_offset));
+        const uint32_t nsymbols = 0xFFFFFFFF;
+        io.write(reinterpret_cast<const char*>(&nsymbols), sizeof(nsymbols));
+    }
+    EXPECT_THROW(SnapshotReader reader(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+// ---------- Sampling live books ----------
+
+TEST(SnapshotSampler, SamplesOnTimestampGrid) {
+    const std::string path = temp_path("sampler.snap");
+    LimitOrderBook lob(0.0, 1000.0);
+
+    {
+        SnapshotWriter writer(path, 2, 100);
+        SnapshotSampler sampler(writer, 100);
+        sampler.track(3, "NVDA", &lob);
+
+        sampler.advance(50);             // aligns the grid to 100
+        lob.process_order(1, 100.00, 10, OrderSide::Buy);
+        lob.process_order(2, 100.05, 20, OrderSide::Sell);
+        sampler.advance(150);            // samples t=100
+        lob.process_order(3, 100.01, 30, OrderSide::Buy);
+        sampler.advance(320);            // samples t=200 and t=300
+        EXPECT_EQ(sampler.samples_taken(), 3u);
+    }
+
+    SnapshotReader reader(path);
+    auto chunks = reader.chunks_for(3);
+    ASSERT_EQ(chunks.size(), 1u);
+
+    SnapshotChunk chunk;
+    reader.read_chunk(chunks[0], chunk);
+    ASSERT_EQ(chunk.rows(), 3u);
+    EXPECT_EQ(chunk.timestamps[0], 100u);
+    EXPECT_EQ(chunk.timestamps[2], 300u);
+
+    EXPECT_EQ(chunk.level(0, BidPrice)[0], 10000);
+    EXPECT_EQ(chunk.level(0, BidQty)[0], 10);
+    EXPECT_EQ(chunk.level(1, BidQty)[0], 0);
+    EXPECT_EQ(chunk.level(0, AskPrice)[0], 10005);
+
+    EXPECT_EQ(chunk.level(0, BidPrice)[1], 10001);
+    EXPECT_EQ(chunk.level(1, BidPrice)[1], 10000);
+    EXPECT_EQ(chunk.level(1, BidQty)[2], 10);
+
+    std::remove(path.c_str());
+}
+
+// ---------- Trade tapes ----------
+
+static trade_tape::TradeRecord trade_at(uint64_t ts, uint64_t seq) {
+    return {ts, seq, static_cast<int64_t>(seq), static_cast<int64_t>(seq + 1), 1'000'000 + static_cast<int64_t>(seq), 100, 0};
+}
+
+TEST(TradeTape, RangeQueriesMatchALinearScan) {
+    const std::string path = temp_path("range.tape");
+
+    // bursts of equal timestamps straddle index entries
+    std::vector<trade_tape::TradeRecord> written;
+    {
+        TradeTapeWriter writer(path, 12, "NVDA", /*index_every=*/8, /*buffer_records=*/5);
+        for (uint64_t i = 0; i < 300; ++i) {
+            written.push_back(trade_at(1'000 + (i / 3) * 10, i + 1));
+            writer.append(written.back());
+        }
+        EXPECT_EQ(writer.records(), 300u);
+    }
+
+    TradeTapeReader reader(path);
+    EXPECT_EQ(reader.symbol(), "NVDA");
+    EXPECT_EQ(reader.locate(), 12);
+    ASSERT_EQ(reader.records().size(), 300u);
+    EXPECT_EQ(reader.index().size(), 38u);
+    EXPECT_EQ(reader.records()[299].sequence, 300u);
+
+    for (uint64_t from : {0ull, 1'000ull, 1'005ull, 1'080ull, 1'990ull, 5'000ull}) {
+        for (uint64_t to : {from, from + 1, from + 10, from + 255, from + 10'000}) {
+            size_t expected_first = 0, expected_count = 0;
+            for (size_t i = 0; i < written.size(); ++i) {
+                if (written[i].timestamp < from) expected_first = i + 1;
+                if (written[i].timestamp >= from && written[i].timestamp < to) ++expected_count;
+            }
+            auto got = reader.range(from, to);
+            ASSERT_EQ(got.size(), expected_count) << from << ".." << to;
+            if (expected_count) {
+                EXPECT_EQ(got.data(), reader.records().data() + expected_first) << from << ".." << to;
+            }
+        }
+    }
+    std::remove(path.c_str());
+    std::remove(trade_tape::index_path(path).c_str());
+}
+
+TEST(TradeTape, ReadsATapeStillBeingWritten) {
+    const std::string path = temp_path("live.tape");
+    TradeTapeWriter writer(path, 3, "AAPL", /*index_every=*/4, /*buffer_records=*/1000);
+    for (uint64_t i = 0; i < 10; ++i)
+        writer.append(trade_at(100 + i, i + 1));
+    writer.flush();
+    writer.append(trade_at(200, 11)); // still buffered
+
+    // a torn record at the end (a writer caught mid-write) is ignored
+    {
+        std::ofstream(path, std::ios::binary | std::ios::app).write("\x01\x02\x03", 3);
+    }
+
+    TradeTapeReader reader(path);
+    EXPECT_EQ(reader.records().size(), 10u);
+    EXPECT_EQ(reader.range(105, 1'000).size(), 5u);
+
+    // without its index a tape is searched whole
+    std::remove(trade_tape::index_path(path).c_str());
+    TradeTapeReader unindexed(path);
+    EXPECT_TRUE(unindexed.index().empty());
+    EXPECT_EQ(unindexed.range(105, 1'000).size(), 5u);
+    std::remove(path.c_str());
+}